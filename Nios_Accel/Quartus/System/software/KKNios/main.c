@@ -65,6 +65,22 @@
  */
 #define ACTIVATE_PERFCOUNT
 
+/**
+ * @brief Uncomment this define to read back only the determinant (no inverse nor identity check).
+ */
+//#define DETERMINANT_ONLY
+
+/**
+ * @brief Uncomment this define to check the inverse with random vectors (Freivalds' algorithm, O(N^2))
+ * instead of the full identity product (O(N^3)).
+ */
+//#define FREIVALDS_CHECK
+
+/**
+ * @brief Number of random vectors of Freivalds check (a wrong inverse passes with probability 2^-ROUNDS at most).
+ */
+#define FREIVALDS_ROUNDS 8
+
 /**
  * @brief Transform a fixedpoint element to float.
  *
@@ -213,6 +229,63 @@ float calculate_error(float matrix[N][N]) {
 	return val;
 }
 
+/**
+ * @brief Multiply random sign vectors by B, then by A (Freivalds' algorithm).
+ *
+ * A * B * r gives r back when A * B is the identity. Each vector costs O(N^2) instead of the O(N^3) of
+ * multiply_matrix(), and a product off by more than twice the accepted error passes a vector with
+ * probability 1/2 at most.
+ *
+ * @param A First N-by-N matrix.
+ * @param B Second N-by-N matrix.
+ * @param r FREIVALDS_ROUNDS random sign vectors (output).
+ * @param y FREIVALDS_ROUNDS products A * B * r (output).
+ */
+void multiply_freivalds(float A[N][N], float B[N][N], float r[FREIVALDS_ROUNDS][N], float y[FREIVALDS_ROUNDS][N]) {
+	int i, j, k;
+	float t[N];
+
+	for(k = 0; k < FREIVALDS_ROUNDS; k++) {
+		for(j = 0; j < N; j++)
+			r[k][j] = (rand() & 1)? -1 : 1;
+
+		for(i = 0; i < N; i++) {
+			t[i] = 0;
+			for(j = 0; j < N; j++)
+				t[i] += B[i][j] * r[k][j];
+		}
+
+		for(i = 0; i < N; i++) {
+			y[k][i] = 0;
+			for(j = 0; j < N; j++)
+				y[k][i] += A[i][j] * t[j];
+		}
+	}
+}
+
+/**
+ * @brief Calculate error distance between Freivalds products and their random vectors.
+ *
+ * @param r FREIVALDS_ROUNDS random sign vectors.
+ * @param y FREIVALDS_ROUNDS products A * B * r.
+ *
+ * @return Error distance (mean of |A * B * r - r|). Less is better.
+ */
+float calculate_error_freivalds(float r[FREIVALDS_ROUNDS][N], float y[FREIVALDS_ROUNDS][N]) {
+	int i, k;
+	float val = 0;
+
+	for(k = 0; k < FREIVALDS_ROUNDS; k++) {
+		for(i = 0; i < N; i++) {
+			val += fabs(r[k][i] - y[k][i]);
+		}
+	}
+
+	val /= FREIVALDS_ROUNDS * N;
+
+	return val;
+}
+
 /**
  * @brief Run KK Algorithm.
  */
@@ -323,14 +396,28 @@ void the_algorithm(void) {
 							};
 #endif
 
+#ifdef DETERMINANT_ONLY
+	/* Determinant */
+	float det;
+#else
 	/* Matrix scratchpad */
 	float matrix_K[3][N][N];
+#ifdef FREIVALDS_CHECK
+	/* Random vectors of Freivalds check */
+	float vector_R[FREIVALDS_ROUNDS][N];
+	/* Random vectors multiplied by original matrix and calculated inverted matrix */
+	float vector_Y[FREIVALDS_ROUNDS][N];
+#else
 	/* Calculated identity matrix based on calculated inverted matrix */
 	float matrix_IC[N][N];
+#endif
 	/* Error distance from true identity */
 	float error;
+	/* Scratchpad indexes */
+	int next = ((N + 2) % 3), prev = (N % 3), curr = (N + 1) % 3;
+#endif
 	/* Auxiliary variables */
-	int i, j, next = ((N + 2) % 3), prev = (N % 3), curr = (N + 1) % 3;
+	int i, j;
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp before: Transfer matrix */
@@ -365,6 +452,31 @@ void the_algorithm(void) {
 	kk_start();
 	while(kk_isrunning());
 
+#ifdef DETERMINANT_ONLY
+	/* Determinant is element (0, 0) of last matrix: a single read instead of 2 * N * N */
+	det = kk_getdetelem(0, 0);
+
+#ifdef ACTIVATE_TIMESTAMP
+	/* Timestamp after: KK Iterations */
+	now[1] = alt_timestamp();
+#endif
+#ifdef ACTIVATE_PERFCOUNT
+	/* Stop performance counter: KK Iterations */
+	PERF_END(PERFORMANCE_COUNTER_BASE, 2);
+#endif
+
+	/* Print determinant */
+	printf("################################################\n");
+	printf("Determinant: %.2f\n", det);
+	printf("Division by zero? %d\n", kk_divzero());
+
+#ifdef ACTIVATE_TIMESTAMP
+	/* Print timestamp report */
+	printf("################################################\n");
+	printf("Timestamp 0: Transfer matrix: %u ticks\n", now[0] - then[0]);
+	printf("Timestamp 1: Iterations: %u ticks\n", now[1] - then[1]);
+#endif
+#else
 	/* Get elements */
 	for(i = 0; i < N; i++) {
 		for(j = 0; j < N; j++) {
@@ -424,8 +536,13 @@ void the_algorithm(void) {
 	PERF_BEGIN(PERFORMANCE_COUNTER_BASE, 4);
 #endif
 
+#ifdef FREIVALDS_CHECK
+	/* Calculate identity (only applied to random vectors) */
+	multiply_freivalds(matrix_K[next], matrix_O, vector_R, vector_Y);
+#else
 	/* Calculate identity */
 	multiply_matrix(matrix_K[next], matrix_O, matrix_IC);
+#endif
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp after: Calculate identity */
@@ -436,10 +553,12 @@ void the_algorithm(void) {
 	PERF_END(PERFORMANCE_COUNTER_BASE, 4);
 #endif
 
+#ifndef FREIVALDS_CHECK
 	/* Print calculated identity matrix */
 	printf("################################################\n");
 	printf("Calculated identity based on calculated inverted matrix:\n");
 	print_matrix(matrix_IC);
+#endif
 	printf("################################################\n");
 
 #ifdef ACTIVATE_TIMESTAMP
@@ -451,8 +570,13 @@ void the_algorithm(void) {
 	PERF_BEGIN(PERFORMANCE_COUNTER_BASE, 5);
 #endif
 
+#ifdef FREIVALDS_CHECK
+	/* Calculate error (over random vectors) */
+	error = calculate_error_freivalds(vector_R, vector_Y);
+#else
 	/* Calculate error */
 	error = calculate_error(matrix_IC);
+#endif
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp after: Calculate error */
@@ -475,6 +599,7 @@ void the_algorithm(void) {
 	printf("Timestamp 3: Calculated identity: %u ticks\n", now[3] - then[3]);
 	printf("Timestamp 4: Error distance: %u ticks\n", now[4] - then[4]);
 #endif
+#endif
 }
 
 /**
@@ -0,0 +1,2081 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (PC Benchmark)                  * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kk.h"
+#include "kk_batch.h"
+#include "kk_exact.h"
+#include "kk_file.h"
+#include "kk_fixed.h"
+#include "kk_format.h"
+#include "kk_generic.h"
+#include "kk_lu.h"
+#include "kk_pool.h"
+#include "kk_precond.h"
+#include "kk_sched.h"
+#include "kk_small.h"
+#include "kk_solve.h"
+#include "kk_update.h"
+#include "kk_verify.h"
+
+/**
+ * @brief Minimum time (in seconds) spent measuring each configuration.
+ */
+#define MIN_TIME 0.2
+
+/**
+ * @brief Warmup time (in seconds) of each sweep configuration, before any sample is kept.
+ */
+#define SWEEP_WARMUP 0.05
+
+/**
+ * @brief Minimum number of samples of each sweep configuration (p99 needs a few of them).
+ */
+#define SWEEP_MIN_SAMPLES 20
+
+/**
+ * @brief Maximum number of samples of each sweep configuration.
+ */
+#define SWEEP_MAX_SAMPLES 2000
+
+/**
+ * @brief Output stream of machine-readable results (--json), NULL if not requested.
+ */
+static FILE *json;
+
+/**
+ * @brief Maximum number of KK iterations timed per run (larger matrices are timed per iteration).
+ */
+#define MAX_STEPS 64
+
+/**
+ * @brief Generate a legacy KK iteration kernel for a compile-time matrix size.
+ *
+ * Same loop as original PC/main.c (modulo indexing over three N-by-N matrices), instantiated per size
+ * so that the compiler may strength-reduce the modulo just as it did with #define N.
+ */
+#define LEGACY_KERNEL(NN) \
+	static void legacy_iterate_##NN(double (*matrix_K)[NN][NN], int steps) { \
+		int i, j, k, next = 0, prev = 1, curr = 2; \
+		for(k = 0; k < steps; k++) { \
+			for(i = 0; i < NN; i++) { \
+				for(j = 0; j < NN; j++) { \
+					matrix_K[next][i % NN][j % NN] = \
+							(matrix_K[curr][i % NN][j % NN] * matrix_K[curr][(i + 1) % NN][(j + 1) % NN] - (matrix_K[curr][(i + 1) % NN][j % NN] * matrix_K[curr][i % NN][(j + 1) % NN])) / \
+							(k? (matrix_K[prev][(i + 1) % NN][(j + 1) % NN]) : 1.0); \
+				} \
+			} \
+			next = (next + 1) % 3; \
+			prev = (prev + 1) % 3; \
+			curr = (curr + 1) % 3; \
+		} \
+	}
+
+LEGACY_KERNEL(4)
+LEGACY_KERNEL(7)
+LEGACY_KERNEL(8)
+LEGACY_KERNEL(16)
+LEGACY_KERNEL(32)
+LEGACY_KERNEL(64)
+LEGACY_KERNEL(100)
+LEGACY_KERNEL(128)
+LEGACY_KERNEL(256)
+LEGACY_KERNEL(512)
+LEGACY_KERNEL(1000)
+LEGACY_KERNEL(1024)
+LEGACY_KERNEL(2048)
+
+/**
+ * @brief Legacy kernel descriptor.
+ */
+typedef struct {
+	int n;
+	void (*iterate)(void *matrix_K, int steps);
+} legacy_t;
+
+/**
+ * @brief Sizes benchmarked against legacy kernel.
+ */
+static const legacy_t legacy[] = {
+	{4, (void (*)(void *, int)) legacy_iterate_4},
+	{7, (void (*)(void *, int)) legacy_iterate_7},
+	{8, (void (*)(void *, int)) legacy_iterate_8},
+	{16, (void (*)(void *, int)) legacy_iterate_16},
+	{32, (void (*)(void *, int)) legacy_iterate_32},
+	{64, (void (*)(void *, int)) legacy_iterate_64},
+	{100, (void (*)(void *, int)) legacy_iterate_100},
+	{128, (void (*)(void *, int)) legacy_iterate_128},
+	{256, (void (*)(void *, int)) legacy_iterate_256},
+	{512, (void (*)(void *, int)) legacy_iterate_512},
+	{1000, (void (*)(void *, int)) legacy_iterate_1000},
+	{1024, (void (*)(void *, int)) legacy_iterate_1024},
+	{2048, (void (*)(void *, int)) legacy_iterate_2048}
+};
+
+/**
+ * @brief Return monotonic time.
+ *
+ * @return Time in seconds.
+ */
+static double now_sec(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + (ts.tv_nsec * 1e-9);
+}
+
+/**
+ * @brief Fill a matrix with well-conditioned pseudo-random values.
+ *
+ * @param n Size of matrix.
+ * @param matrix n-by-n row-major matrix.
+ */
+static void fill_matrix(int n, double *matrix) {
+	int i;
+
+	srand(n);
+	for(i = 0; i < n * n; i++)
+		matrix[i] = ((rand() / (double) RAND_MAX) - 0.5) * 2.0;
+}
+
+/**
+ * @brief Compare legacy modulo kernel against halo-padded kernel.
+ */
+static void bench_layout(void) {
+	int l, n, steps, reps;
+	double *matrix_O, *matrix_K;
+	double then, elapsed, tLegacy, tHalo;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %6s %16s %16s %10s\n", "N", "steps", "legacy ns/step", "halo ns/step", "speedup");
+
+	for(l = 0; l < (int) (sizeof(legacy) / sizeof(legacy[0])); l++) {
+		n = legacy[l].n;
+		steps = (n - 1 < MAX_STEPS)? (n - 1) : MAX_STEPS;
+		matrix_O = malloc((size_t) n * n * sizeof(double));
+		matrix_K = malloc(3 * (size_t) n * n * sizeof(double));
+		fill_matrix(n, matrix_O);
+		kk_workspace_reserve(&ws, n);
+
+		/* Legacy kernel */
+		tLegacy = 1e30;
+		elapsed = 0;
+		for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+			memcpy(&matrix_K[2 * n * n], matrix_O, (size_t) n * n * sizeof(double));
+			then = now_sec();
+			legacy[l].iterate(matrix_K, steps);
+			then = now_sec() - then;
+			elapsed += then;
+			if(then < tLegacy)
+				tLegacy = then;
+		}
+
+		/* Halo-padded kernel */
+		tHalo = 1e30;
+		elapsed = 0;
+		for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+			int k;
+
+			kk_transfer(&ws, n, matrix_O);
+			then = now_sec();
+			for(k = 0; k < steps; k++)
+				kk_step(&ws);
+			then = now_sec() - then;
+			elapsed += then;
+			if(then < tHalo)
+				tHalo = then;
+		}
+
+		printf("%6d %6d %16.1lf %16.1lf %9.2lfx\n", n, steps, tLegacy * 1e9 / steps, tHalo * 1e9 / steps, tLegacy / tHalo);
+
+		free(matrix_K);
+		free(matrix_O);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Return distance in units in the last place between two doubles.
+ *
+ * @param a First value.
+ * @param b Second value.
+ *
+ * @return ULP distance (saturated for NaN).
+ */
+static uint64_t ulp_distance(double a, double b) {
+	int64_t ia, ib;
+
+	if(isnan(a) || isnan(b))
+		return (isnan(a) && isnan(b))? 0 : UINT64_MAX;
+
+	memcpy(&ia, &a, sizeof(ia));
+	memcpy(&ib, &b, sizeof(ib));
+	/* Map sign-magnitude to a monotonic integer line */
+	ia = (ia < 0)? (INT64_MIN - ia) : ia;
+	ib = (ib < 0)? (INT64_MIN - ib) : ib;
+
+	return (ia > ib)? (uint64_t) ia - (uint64_t) ib : (uint64_t) ib - (uint64_t) ia;
+}
+
+/**
+ * @brief Compare SIMD levels on full inversions (time and ULP distance to scalar path).
+ */
+static void bench_simd(void) {
+	static const int sizes[] = {16, 32, 64, 100, 128, 256, 500, 512};
+	static const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+	int l, n, t, reps;
+	size_t e;
+	uint64_t ulp, maxUlp;
+	double *matrix_O, *matrix_R, *matrix_I;
+	double then, elapsed, best, tScalar = 0;
+	kk_simd_t level, detected = kk_simd_detect();
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %8s %14s %10s %8s\n", "N", "simd", "us/inversion", "speedup", "max ULP");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		matrix_O = malloc((size_t) n * n * sizeof(double));
+		matrix_R = malloc((size_t) n * n * sizeof(double));
+		matrix_I = malloc((size_t) n * n * sizeof(double));
+		fill_matrix(n, matrix_O);
+
+		for(l = KK_SIMD_SCALAR; l <= (int) detected; l++) {
+			level = (kk_simd_t) l;
+			kk_simd_set(level);
+
+			best = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				kk_invert(n, matrix_O, matrix_I, &ws, NULL);
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best)
+					best = then;
+			}
+
+			/* Scalar result is the reference */
+			if(KK_SIMD_SCALAR == level) {
+				memcpy(matrix_R, matrix_I, (size_t) n * n * sizeof(double));
+				tScalar = best;
+			}
+
+			maxUlp = 0;
+			for(e = 0; e < (size_t) n * n; e++) {
+				ulp = ulp_distance(matrix_R[e], matrix_I[e]);
+				if(ulp > maxUlp)
+					maxUlp = ulp;
+			}
+
+			printf("%6d %8s %14.2lf %9.2lfx %8llu\n", n, names[l], best * 1e6, tScalar / best, (unsigned long long) maxUlp);
+		}
+
+		free(matrix_I);
+		free(matrix_R);
+		free(matrix_O);
+	}
+
+	kk_simd_set(detected);
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Maximum size (in bytes) of input (or output) batch.
+ */
+#define MAX_BATCH_BYTES (512 << 20)
+
+/**
+ * @brief Compare per-matrix throughput of single inversions against batched (interleaved) inversions.
+ */
+static void bench_batch(void) {
+	static const int sizes[] = {4, 8, 16};
+	int t, n, mode, reps;
+	size_t m, count, e;
+	double *matrix_O, *matrix_I, *packed;
+	double then, elapsed, best[3];
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %9s %14s %14s %14s %10s\n", "N", "batch", "single ns/mat", "batch ns/mat", "packed ns/mat", "speedup");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+
+		for(count = 1; count * n * n * sizeof(double) <= MAX_BATCH_BYTES; count *= 10) {
+			matrix_O = malloc(count * n * n * sizeof(double));
+			matrix_I = malloc(count * n * n * sizeof(double));
+			packed = malloc(kk_batch_packed_size(n, count));
+			srand(n);
+			for(e = 0; e < count * n * n; e++)
+				matrix_O[e] = ((rand() / (double) RAND_MAX) - 0.5) * 2.0;
+			kk_batch_pack(n, count, matrix_O, packed);
+
+			/* Mode 0: one kk_invert() per matrix, 1: kk_batch_invert(), 2: kk_batch_invert_packed() */
+			for(mode = 0; mode < 3; mode++) {
+				best[mode] = 1e30;
+				elapsed = 0;
+				for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+					then = now_sec();
+					if(0 == mode)
+						for(m = 0; m < count; m++)
+							kk_invert(n, &matrix_O[m * n * n], &matrix_I[m * n * n], &ws, NULL);
+					else if(1 == mode)
+						kk_batch_invert(n, count, matrix_O, matrix_I, &ws, NULL);
+					else
+						kk_batch_invert_packed(n, count, packed, packed, &ws, NULL);
+					then = now_sec() - then;
+					elapsed += then;
+					if(then < best[mode])
+						best[mode] = then;
+				}
+			}
+
+			printf("%6d %9zu %14.1lf %14.1lf %14.1lf %9.2lfx\n", n, count, best[0] * 1e9 / count, best[1] * 1e9 / count,
+					best[2] * 1e9 / count, best[0] / best[1]);
+
+			free(packed);
+			free(matrix_I);
+			free(matrix_O);
+		}
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Measure scaling of pooled inversions from 1 to 64 threads.
+ */
+static void bench_threads(void) {
+	static const int sizes[] = {128, 256, 512, 1024};
+	int t, n, threads, reps;
+	double *matrix_O, *matrix_I;
+	double then, elapsed, best, tSingle = 0;
+	kk_pool_t *pool;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %8s %14s %10s %11s\n", "N", "threads", "ms/inversion", "speedup", "efficiency");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		matrix_O = malloc((size_t) n * n * sizeof(double));
+		matrix_I = malloc((size_t) n * n * sizeof(double));
+		fill_matrix(n, matrix_O);
+
+		for(threads = 1; threads <= 64; threads *= 2) {
+			pool = kk_pool_create(threads);
+
+			best = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				kk_pool_invert(pool, n, matrix_O, matrix_I, &ws, NULL);
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best)
+					best = then;
+			}
+
+			if(1 == threads)
+				tSingle = best;
+
+			printf("%6d %8d %14.3lf %9.2lfx %10.1lf%%\n", n, threads, best * 1e3, tSingle / best, 100.0 * tSingle / (best * threads));
+
+			kk_pool_destroy(pool);
+		}
+
+		free(matrix_I);
+		free(matrix_O);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Compare two doubles (for qsort()).
+ *
+ * @param a First double.
+ * @param b Second double.
+ *
+ * @return Negative, zero or positive as a is less than, equal to or greater than b.
+ */
+static int cmp_double(const void *a, const void *b) {
+	double x = *(const double *) a, y = *(const double *) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Return a percentile of a set of samples (samples are sorted in place).
+ *
+ * @param samples Samples.
+ * @param count Number of samples.
+ * @param p Percentile (0 to 100).
+ *
+ * @return The percentile.
+ */
+static double percentile(double *samples, int count, double p) {
+	int i;
+
+	qsort(samples, count, sizeof(double), cmp_double);
+	i = (int) ceil((p / 100.0) * count) - 1;
+
+	return samples[(i < 0)? 0 : i];
+}
+
+/**
+ * @brief Number of jobs of mixed workload.
+ */
+#define MIXED_JOBS 2000
+
+/**
+ * @brief One in every MIXED_LARGE_EVERY jobs of mixed workload is large.
+ */
+#define MIXED_LARGE_EVERY 250
+
+/**
+ * @brief Size of large jobs of mixed workload.
+ */
+#define MIXED_LARGE_N 384
+
+/**
+ * @brief Mixed workload shared by static threads.
+ */
+typedef struct {
+	/* Size of each job */
+	int *n;
+	/* Input and output matrices of each job */
+	double **in, **out;
+	/* Completion time of each job, relative to start */
+	double *latency;
+	/* Start of workload */
+	double start;
+	/* Number of threads and index of this one */
+	int threads, id;
+} mixed_t;
+
+/**
+ * @brief Static split thread: invert every threads-th job of a mixed workload, in order.
+ *
+ * @param arg Mixed workload (private copy with own id).
+ *
+ * @return Nothing.
+ */
+static void *mixed_static(void *arg) {
+	mixed_t *m = arg;
+	int j;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+	for(j = m->id; j < MIXED_JOBS; j += m->threads) {
+		kk_invert(m->n[j], m->in[j], m->out[j], &ws, NULL);
+		m->latency[j] = now_sec() - m->start;
+	}
+	kk_workspace_free(&ws);
+
+	return NULL;
+}
+
+/**
+ * @brief Scheduler completion callback: record latency of a mixed workload job.
+ *
+ * @param job Finished job (arg points to its latency slot, which holds start time on submission).
+ */
+static void mixed_done(kk_sched_job_t *job) {
+	double *latency = job->arg;
+
+	*latency = now_sec() - *latency;
+}
+
+/**
+ * @brief Check jobs small enough for kk_small kernels on a fresh scheduler against kk_invert().
+ *
+ * Such jobs leave the scratchpad of their worker untouched, so their results must come from kk_invert()
+ * itself (a fresh worker has no scratchpad at all).
+ *
+ * @return Number of jobs whose inverse, determinant or division by zero flag differ.
+ */
+static int sched_check_small(void) {
+	int j, n, bad = 0;
+	double in[KK_SMALL_MAX][KK_SMALL_MAX * KK_SMALL_MAX], out[KK_SMALL_MAX][KK_SMALL_MAX * KK_SMALL_MAX];
+	double ref[KK_SMALL_MAX * KK_SMALL_MAX];
+	kk_result_t res;
+	kk_sched_job_t jobs[KK_SMALL_MAX];
+	kk_sched_t *sched;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+	sched = kk_sched_create(1);
+
+	/* Sizes from KK_SMALL_MAX down to 1, so that first job runs on a fresh worker */
+	for(j = 0; j < KK_SMALL_MAX; j++) {
+		n = KK_SMALL_MAX - j;
+		fill_matrix(n, in[j]);
+		kk_sched_job_init(&jobs[j]);
+		kk_sched_submit(sched, &jobs[j], n, in[j], out[j]);
+	}
+	kk_sched_wait(sched);
+
+	for(j = 0; j < KK_SMALL_MAX; j++) {
+		n = KK_SMALL_MAX - j;
+		kk_invert(n, in[j], ref, &ws, &res);
+		if(memcmp(ref, out[j], (size_t) n * n * sizeof(double)) || memcmp(&res.det, &jobs[j].res.det, sizeof(double)) ||
+				(res.divZero != jobs[j].res.divZero))
+			bad++;
+		kk_sched_job_free(&jobs[j]);
+	}
+
+	kk_sched_destroy(sched);
+	kk_workspace_free(&ws);
+
+	return bad;
+}
+
+/**
+ * @brief Compare static split of a mixed workload against the work-stealing scheduler.
+ */
+static void bench_sched(void) {
+	int j, t, threads;
+	double makespan;
+	mixed_t m, mt[8];
+	pthread_t thread[8];
+	kk_sched_t *sched;
+	kk_sched_job_t *jobs;
+
+	m.n = malloc(MIXED_JOBS * sizeof(int));
+	m.in = malloc(MIXED_JOBS * sizeof(double *));
+	m.out = malloc(MIXED_JOBS * sizeof(double *));
+	m.latency = malloc(MIXED_JOBS * sizeof(double));
+	jobs = malloc(MIXED_JOBS * sizeof(kk_sched_job_t));
+
+	/* Many small matrices with a few large ones in between */
+	srand(1);
+	for(j = 0; j < MIXED_JOBS; j++) {
+		m.n[j] = (MIXED_LARGE_EVERY / 2 == j % MIXED_LARGE_EVERY)? MIXED_LARGE_N : 4 + (rand() % 29);
+		m.in[j] = malloc((size_t) m.n[j] * m.n[j] * sizeof(double));
+		m.out[j] = malloc((size_t) m.n[j] * m.n[j] * sizeof(double));
+		fill_matrix(m.n[j], m.in[j]);
+		kk_sched_job_init(&jobs[j]);
+		jobs[j].done = mixed_done;
+		jobs[j].arg = &m.latency[j];
+	}
+
+	printf("Small jobs (1 to %d) differing from kk_invert(): %d\n", KK_SMALL_MAX, sched_check_small());
+	printf("%d jobs, 1 in %d of size %d, others 4 to 32\n", MIXED_JOBS, MIXED_LARGE_EVERY, MIXED_LARGE_N);
+	printf("%8s %8s %12s %12s %12s %12s\n", "mode", "threads", "total ms", "jobs/s", "p50 ms", "p99 ms");
+
+	for(threads = 1; threads <= 8; threads *= 2) {
+		/* Static split: job j goes to thread j % threads */
+		m.threads = threads;
+		m.start = now_sec();
+		for(t = 0; t < threads; t++) {
+			mt[t] = m;
+			mt[t].id = t;
+			pthread_create(&thread[t], NULL, mixed_static, &mt[t]);
+		}
+		for(t = 0; t < threads; t++)
+			pthread_join(thread[t], NULL);
+		makespan = now_sec() - m.start;
+		printf("%8s %8d %12.3lf %12.0lf %12.3lf %12.3lf\n", "static", threads, makespan * 1e3, MIXED_JOBS / makespan,
+			percentile(m.latency, MIXED_JOBS, 50) * 1e3, percentile(m.latency, MIXED_JOBS, 99) * 1e3);
+
+		/* Work stealing: every job submitted at once */
+		sched = kk_sched_create(threads);
+		m.start = now_sec();
+		for(j = 0; j < MIXED_JOBS; j++) {
+			m.latency[j] = m.start;
+			kk_sched_submit(sched, &jobs[j], m.n[j], m.in[j], m.out[j]);
+		}
+		kk_sched_wait(sched);
+		makespan = now_sec() - m.start;
+		printf("%8s %8d %12.3lf %12.0lf %12.3lf %12.3lf\n", "steal", threads, makespan * 1e3, MIXED_JOBS / makespan,
+			percentile(m.latency, MIXED_JOBS, 50) * 1e3, percentile(m.latency, MIXED_JOBS, 99) * 1e3);
+		kk_sched_destroy(sched);
+	}
+
+	for(j = 0; j < MIXED_JOBS; j++) {
+		kk_sched_job_free(&jobs[j]);
+		free(m.out[j]);
+		free(m.in[j]);
+	}
+	free(jobs);
+	free(m.latency);
+	free(m.out);
+	free(m.in);
+	free(m.n);
+}
+
+/**
+ * @brief Number of matrices run through the fixed-point model per measurement.
+ */
+#define FIXED_MATRICES 4096
+
+/**
+ * @brief Measure throughput of the FixedPoint#(16, 16) accelerator model per SIMD level.
+ */
+static void bench_fixed(void) {
+	static const int sizes[] = {4, 8, 16, 32};
+	static const char *names[] = {"scalar", "sse2", "avx2", "avx512"};
+	int l, n, t, e, reps, same, flagged;
+	int32_t *in, *ref, *det;
+	double then, elapsed, best, tScalar = 0;
+	kk_fixed_result_t *res;
+	kk_simd_t level, detected = kk_simd_detect();
+	void *mem = NULL;
+
+	in = malloc((size_t) FIXED_MATRICES * 32 * 32 * sizeof(int32_t));
+	ref = malloc((size_t) FIXED_MATRICES * 32 * 32 * sizeof(int32_t));
+	det = malloc((size_t) FIXED_MATRICES * 32 * 32 * sizeof(int32_t));
+	res = malloc(FIXED_MATRICES * sizeof(kk_fixed_result_t));
+	if(posix_memalign(&mem, KK_ALIGN, kk_fixed_workspace_size(32)))
+		return;
+
+	printf("%6s %8s %16s %10s %10s %8s\n", "N", "simd", "matrices/s", "speedup", "identical", "divZero");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+
+		srand(n);
+		for(e = 0; e < FIXED_MATRICES * n * n; e++)
+			in[e] = kk_fixed_from_double(((rand() / (double) RAND_MAX) - 0.5) * 2.0, KK_FIXED_IW, KK_FIXED_FW);
+
+		for(l = KK_SIMD_SCALAR; l <= (int) detected; l++) {
+			level = (kk_simd_t) l;
+			kk_simd_set(level);
+
+			best = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				kk_fixed_run(KK_FIXED_IW, KK_FIXED_FW, n, FIXED_MATRICES, in, NULL, det, res, mem);
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best)
+					best = then;
+			}
+
+			/* Scalar result is the reference */
+			if(KK_SIMD_SCALAR == level) {
+				memcpy(ref, det, (size_t) FIXED_MATRICES * n * n * sizeof(int32_t));
+				tScalar = best;
+			}
+
+			same = !memcmp(ref, det, (size_t) FIXED_MATRICES * n * n * sizeof(int32_t));
+			for(e = 0, flagged = 0; e < FIXED_MATRICES; e++)
+				flagged += res[e].divZero;
+
+			printf("%6d %8s %16.0lf %9.2lfx %10s %8d\n", n, names[l], FIXED_MATRICES / best, tScalar / best, same? "yes" : "NO", flagged);
+		}
+	}
+
+	kk_simd_set(detected);
+	free(mem);
+	free(res);
+	free(det);
+	free(ref);
+	free(in);
+}
+
+/**
+ * @brief Mean distance of A * X to identity, as calculate_error() of main.c (in long double).
+ *
+ * @param n Size of matrices.
+ * @param a n-by-n matrix.
+ * @param x n-by-n inverse of a.
+ *
+ * @return Error distance.
+ */
+static double identity_error(int n, const long double *a, const long double *x) {
+	int i, j, k;
+	long double c, val = 0;
+
+	for(i = 0; i < n; i++) {
+		for(j = 0; j < n; j++) {
+			c = 0;
+			for(k = 0; k < n; k++)
+				c += a[i * n + k] * x[k * n + j];
+			val += fabsl(((i == j)? 1 : 0) - c);
+		}
+	}
+
+	return val / (n * n);
+}
+
+/**
+ * @brief Compare speed and accuracy of every element type (float, double, long double, Q16.16).
+ */
+static void bench_precision(void) {
+	static const int sizes[] = {8, 32, 128, 256};
+	static const char *names[] = {"float", "double", "long dbl", "q16.16"};
+	int t, n, p, e, reps;
+	double *md, *od, then, elapsed, best, tDouble = 0;
+	float *mf, *of;
+	long double *ml, *ol, *ea, *ex;
+	kk_q16_t *mq, *oq;
+	void *mem = NULL;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %8s %14s %10s %14s\n", "N", "type", "us/inversion", "vs double", "error");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		md = malloc((size_t) n * n * sizeof(double));
+		od = malloc((size_t) n * n * sizeof(double));
+		mf = malloc((size_t) n * n * sizeof(float));
+		of = malloc((size_t) n * n * sizeof(float));
+		ml = malloc((size_t) n * n * sizeof(long double));
+		ol = malloc((size_t) n * n * sizeof(long double));
+		mq = malloc((size_t) n * n * sizeof(kk_q16_t));
+		oq = malloc((size_t) n * n * sizeof(kk_q16_t));
+		ea = malloc((size_t) n * n * sizeof(long double));
+		ex = malloc((size_t) n * n * sizeof(long double));
+		mem = realloc(mem, kk_workspace_size_l(n));
+
+		fill_matrix(n, md);
+		for(e = 0; e < n * n; e++) {
+			mf[e] = md[e];
+			ml[e] = md[e];
+			mq[e] = kk_fixed_from_double(md[e], KK_FIXED_IW, KK_FIXED_FW);
+		}
+
+		/* Double first, as reference for speed */
+		for(p = 1; p < 5; p++) {
+			best = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				switch(p % 4) {
+					case 0:
+						kk_invert_f(n, mf, of, mem, NULL);
+						break;
+					case 1:
+						kk_invert(n, md, od, &ws, NULL);
+						break;
+					case 2:
+						kk_invert_l(n, ml, ol, mem, NULL);
+						break;
+					default:
+						kk_invert_q(n, mq, oq, mem, NULL);
+						break;
+				}
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best)
+					best = then;
+			}
+
+			/* Error is measured against the (rounded) matrix each type actually inverted */
+			for(e = 0; e < n * n; e++) {
+				switch(p % 4) {
+					case 0:
+						ea[e] = mf[e];
+						ex[e] = of[e];
+						break;
+					case 1:
+						ea[e] = md[e];
+						ex[e] = od[e];
+						break;
+					case 2:
+						ea[e] = ml[e];
+						ex[e] = ol[e];
+						break;
+					default:
+						ea[e] = kk_fixed_to_double(mq[e], KK_FIXED_FW);
+						ex[e] = kk_fixed_to_double(oq[e], KK_FIXED_FW);
+						break;
+				}
+			}
+
+			if(1 == p)
+				tDouble = best;
+
+			printf("%6d %8s %14.2lf %9.2lfx %14.3le\n", n, names[p % 4], best * 1e6, tDouble / best, identity_error(n, ea, ex));
+		}
+
+		free(ex);
+		free(ea);
+		free(oq);
+		free(mq);
+		free(ol);
+		free(ml);
+		free(of);
+		free(mf);
+		free(od);
+		free(md);
+	}
+
+	free(mem);
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Compare specialized small-size kernels against generic engine (time and bit-exactness).
+ */
+static void bench_small(void) {
+	/* Inversions per timed run (a single small inversion is below timer resolution) */
+	const int inner = 10000;
+	int n, p, k, reps, same;
+	double matrix_O[12 * 12], matrix_G[12 * 12], matrix_S[12 * 12];
+	double then, elapsed, best[2];
+	kk_result_t resG, resS;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %14s %14s %10s %10s\n", "N", "ns generic", "ns invert", "speedup", "identical");
+
+	for(n = 1; n <= 12; n++) {
+		fill_matrix(n, matrix_O);
+		kk_workspace_reserve(&ws, n);
+
+		for(p = 0; p < 2; p++) {
+			best[p] = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				for(k = 0; k < inner; k++) {
+					if(p) {
+						kk_invert(n, matrix_O, matrix_S, &ws, &resS);
+					}
+					else {
+						/* Same phases as kk_invert() without size dispatch */
+						kk_transfer(&ws, n, matrix_O);
+						kk_iterate(&ws);
+						kk_final(&ws, matrix_G);
+						resG.det = kk_getdetelem(&ws, 0, 0);
+						resG.divZero = ws.divZero;
+					}
+				}
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best[p])
+					best[p] = then;
+			}
+		}
+
+		same = !memcmp(matrix_G, matrix_S, (size_t) n * n * sizeof(double)) && !memcmp(&resG.det, &resS.det, sizeof(double)) && (resG.divZero == resS.divZero);
+		printf("%6d %14.1lf %14.1lf %9.2lfx %10s\n", n, best[0] * 1e9 / inner, best[1] * 1e9 / inner, best[0] / best[1], same? "yes" : "NO");
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Time KK breakdown detection and LU fallback.
+ *
+ * Columns: plain kk_invert(), kk_invert_safe() on the same (strongly non-singular) matrix, LU alone,
+ * and kk_invert_safe() on a matrix whose leading minor of order n / 2 is singular (its row n / 2 - 1
+ * starts as the sum of the rows above), which breaks KK half-way.
+ */
+static void bench_fallback(void) {
+	static const int sizes[] = {8, 32, 128, 256};
+	static const char *paths[] = {"kk", "lu"};
+	int t, n, h, i, j, p, reps;
+	double *in, *out, then, elapsed, best[4], err[4];
+	long double *ea, *ex;
+	kk_result_t res[4];
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %12s %12s %12s %12s %12s %12s %12s %12s\n", "N", "us invert", "us safe", "us lu", "us broken", "path safe", "path broken", "err safe", "err broken");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		h = n / 2;
+		in = malloc((size_t) 2 * n * n * sizeof(double));
+		out = malloc((size_t) n * n * sizeof(double));
+		ea = malloc((size_t) n * n * sizeof(long double));
+		ex = malloc((size_t) n * n * sizeof(long double));
+
+		/* Second matrix: leading h-by-h minor made singular */
+		fill_matrix(n, in);
+		memcpy(in + n * n, in, (size_t) n * n * sizeof(double));
+		for(j = 0; j < h; j++) {
+			in[n * n + (h - 1) * n + j] = 0;
+			for(i = 0; i < h - 1; i++)
+				in[n * n + (h - 1) * n + j] += in[i * n + j];
+		}
+
+		for(p = 0; p < 4; p++) {
+			best[p] = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				if(0 == p)
+					kk_invert(n, in, out, &ws, &res[p]);
+				else if(1 == p)
+					kk_invert_safe(n, in, out, &ws, 1e-9, &res[p]);
+				else if(2 == p)
+					kk_lu_invert(n, in, out, &ws, &res[p]);
+				else
+					kk_invert_safe(n, in + n * n, out, &ws, 1e-9, &res[p]);
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best[p])
+					best[p] = then;
+			}
+
+			for(i = 0; i < n * n; i++) {
+				ea[i] = in[((3 == p)? n * n : 0) + i];
+				ex[i] = out[i];
+			}
+			err[p] = identity_error(n, ea, ex);
+		}
+
+		printf("%6d %12.2lf %12.2lf %12.2lf %12.2lf %12s %12s %12.3le %12.3le\n", n, best[0] * 1e6, best[1] * 1e6, best[2] * 1e6, best[3] * 1e6, paths[res[1].path], paths[res[3].path], err[1], err[3]);
+
+		free(in);
+		free(out);
+		free(ea);
+		free(ex);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Time preconditioned KK retries against LU on invertible matrices that break plain KK.
+ *
+ * Matrices: the exchange matrix (ones on the anti-diagonal, most cyclic minors are zero), a random matrix
+ * with a third of its elements zeroed, and a random matrix whose leading minor of order n / 2 is
+ * singular.
+ */
+static void bench_precond(void) {
+	static const int sizes[] = {32, 128};
+	static const char *names[] = {"exchange", "sparse", "minor"};
+	static const char *paths[] = {"kk", "lu"};
+	int t, m, n, h, i, j, p, reps;
+	double *in, *out, then, elapsed, best[2], err[2];
+	long double *ea, *ex;
+	kk_precond_t opt = {KK_PRECOND_PERMUTE | KK_PRECOND_BUTTERFLY, 4, 1, 1e-9};
+	kk_precond_result_t res;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%8s %6s %12s %12s %6s %6s %12s %12s\n", "matrix", "N", "us precond", "us lu", "tries", "path", "err precond", "err lu");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		h = n / 2;
+		in = malloc((size_t) n * n * sizeof(double));
+		out = malloc((size_t) n * n * sizeof(double));
+		ea = malloc((size_t) n * n * sizeof(long double));
+		ex = malloc((size_t) n * n * sizeof(long double));
+
+		for(m = 0; m < 3; m++) {
+			fill_matrix(n, in);
+			if(0 == m) {
+				memset(in, 0, (size_t) n * n * sizeof(double));
+				for(i = 0; i < n; i++)
+					in[i * n + n - 1 - i] = 1;
+			}
+			else if(1 == m) {
+				for(i = 0; i < n * n; i++)
+					in[i] = (i % 3)? in[i] : 0;
+			}
+			else {
+				for(j = 0; j < h; j++) {
+					in[(h - 1) * n + j] = 0;
+					for(i = 0; i < h - 1; i++)
+						in[(h - 1) * n + j] += in[i * n + j];
+				}
+			}
+
+			for(p = 0; p < 2; p++) {
+				best[p] = 1e30;
+				elapsed = 0;
+				for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+					then = now_sec();
+					if(p)
+						kk_lu_invert(n, in, out, &ws, NULL);
+					else
+						kk_precond_invert(n, in, out, &ws, &opt, &res);
+					then = now_sec() - then;
+					elapsed += then;
+					if(then < best[p])
+						best[p] = then;
+				}
+
+				for(i = 0; i < n * n; i++) {
+					ea[i] = in[i];
+					ex[i] = out[i];
+				}
+				err[p] = identity_error(n, ea, ex);
+			}
+
+			printf("%8s %6d %12.2lf %12.2lf %6d %6s %12.3le %12.3le\n", names[m], n, best[0] * 1e6, best[1] * 1e6, res.tries, paths[res.res.path], err[0], err[1]);
+		}
+
+		free(in);
+		free(out);
+		free(ea);
+		free(ex);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Time determinant-only KK against a full inversion (which reports the determinant as well).
+ *
+ * Memory columns are scratch sizes: three matrices with halo against two without (small sizes of
+ * kk_invert() do not touch the workspace).
+ */
+static void bench_det(void) {
+	static const int sizes[] = {8, 32, 128, 512};
+	int t, n, p, reps;
+	double *in, *out, then, elapsed, best[2];
+	kk_result_t res[2];
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %12s %12s %8s %12s %12s\n", "N", "us invert", "us det", "speedup", "KiB invert", "KiB det");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		in = malloc((size_t) n * n * sizeof(double));
+		out = malloc((size_t) n * n * sizeof(double));
+		fill_matrix(n, in);
+
+		for(p = 0; p < 2; p++) {
+			best[p] = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				if(p)
+					kk_determinant(n, in, &ws, &res[p]);
+				else
+					kk_invert(n, in, out, &ws, &res[p]);
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best[p])
+					best[p] = then;
+			}
+		}
+
+		if(memcmp(&res[0].det, &res[1].det, sizeof(double)))
+			printf("Determinants differ: %.17le %.17le\n", res[0].det, res[1].det);
+
+		printf("%6d %12.2lf %12.2lf %8.2lf %12.1lf %12.1lf\n", n, best[0] * 1e6, best[1] * 1e6, best[0] / best[1], kk_workspace_size(n) / 1024.0, 2.0 * n * ((n + 8) / 8 * 8) * sizeof(double) / 1024.0);
+
+		free(in);
+		free(out);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Time kk_solve() against kk_invert() followed by a (row-streaming) product of inverse by B.
+ *
+ * Both calculate the same X bit for bit; the difference is the n-by-n inverse written and read back.
+ */
+static void bench_solve(void) {
+	static const int sizes[] = {32, 128, 512};
+	static const int rhs[] = {1, 16, 256};
+	int t, q, n, r, i, k, j, p, reps;
+	double *a, *b, *x, *inv, then, elapsed, best[2];
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %6s %14s %12s %8s\n", "N", "RHS", "us inv+gemm", "us solve", "speedup");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		for(q = 0; q < (int) (sizeof(rhs) / sizeof(rhs[0])); q++) {
+			r = rhs[q];
+			a = malloc((size_t) n * n * sizeof(double));
+			inv = malloc((size_t) n * n * sizeof(double));
+			b = malloc((size_t) n * r * sizeof(double));
+			x = malloc((size_t) n * r * sizeof(double));
+			fill_matrix(n, a);
+			for(i = 0; i < n * r; i++)
+				b[i] = rand() / (double) RAND_MAX - 0.5;
+
+			for(p = 0; p < 2; p++) {
+				best[p] = 1e30;
+				elapsed = 0;
+				for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+					then = now_sec();
+					if(p) {
+						kk_solve(n, r, a, b, x, &ws, NULL);
+					}
+					else {
+						kk_invert(n, a, inv, &ws, NULL);
+						memset(x, 0, (size_t) n * r * sizeof(double));
+						for(i = 0; i < n; i++)
+							for(k = 0; k < n; k++)
+								for(j = 0; j < r; j++)
+									x[i * r + j] += inv[i * n + k] * b[k * r + j];
+					}
+					then = now_sec() - then;
+					elapsed += then;
+					if(then < best[p])
+						best[p] = then;
+				}
+			}
+
+			printf("%6d %6d %14.2lf %12.2lf %8.2lf\n", n, r, best[0] * 1e6, best[1] * 1e6, best[0] / best[1]);
+
+			free(a);
+			free(inv);
+			free(b);
+			free(x);
+		}
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Time rank-k Woodbury updates against inverting each updated matrix from scratch.
+ *
+ * A stream of 200 random rank-k changes (elements of U and V in [-0.05, 0.05)) is applied to a
+ * diagonally dominant matrix; err is the residual left after the stream, and refreshes counts the full
+ * inversions the residual tolerance (1e-12) triggered.
+ */
+static void bench_update(void) {
+	static const int sizes[] = {64, 256, 512};
+	static const int ranks[] = {1, 2, 8};
+	int t, q, n, k, i, m, refreshes;
+	double *a, *inv, *u, *v, then, full, upd;
+	kk_update_t up;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+	kk_update_init(&up);
+
+	printf("%6s %6s %12s %12s %8s %10s %12s\n", "N", "rank", "us invert", "us update", "speedup", "refreshes", "err");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		a = malloc((size_t) n * n * sizeof(double));
+		inv = malloc((size_t) n * n * sizeof(double));
+		fill_matrix(n, a);
+		for(i = 0; i < n; i++)
+			a[i * n + i] += n;
+
+		/* Full inversion, as if every updated matrix were inverted again */
+		then = now_sec();
+		for(m = 0; m < 10; m++)
+			kk_invert(n, a, inv, &ws, NULL);
+		full = (now_sec() - then) / 10;
+
+		for(q = 0; q < (int) (sizeof(ranks) / sizeof(ranks[0])); q++) {
+			k = ranks[q];
+			u = malloc((size_t) n * k * sizeof(double));
+			v = malloc((size_t) n * k * sizeof(double));
+			kk_update_seed(&up, n, k, a, 1e-12);
+			refreshes = up.refreshes;
+
+			then = now_sec();
+			for(m = 0; m < 200; m++) {
+				for(i = 0; i < n * k; i++) {
+					u[i] = (rand() / (double) RAND_MAX - 0.5) * 0.1;
+					v[i] = (rand() / (double) RAND_MAX - 0.5) * 0.1;
+				}
+				kk_update_rank(&up, k, u, v);
+			}
+			upd = (now_sec() - then) / 200;
+
+			printf("%6d %6d %12.2lf %12.2lf %8.2lf %10d %12.3le\n", n, k, full * 1e6, upd * 1e6, full / upd, up.refreshes - refreshes, up.err);
+
+			free(u);
+			free(v);
+		}
+
+		free(a);
+		free(inv);
+	}
+
+	kk_update_free(&up);
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Check that kk_file_map() rejects headers whose sizes overflow, or whose matrix size is out of range.
+ *
+ * The first header describes 2^57 + 1 records of 128 bytes: without overflow checks, the size of its
+ * records wraps around to 128 bytes and matches a 192-byte file.
+ *
+ * @return Number of such headers that were mapped.
+ */
+static int file_check_overflow(void) {
+	static const uint64_t counts[] = {(UINT64_C(1) << 57) + 1, 1, 1};
+	static const uint32_t sizes[] = {4, 0, 0x80000000u};
+	int t, bad = 0;
+	unsigned char buf[192];
+	FILE *fp;
+	kk_file_header_t hdr;
+	kk_file_t f;
+
+	for(t = 0; t < 3; t++) {
+		kk_file_header_init(&hdr, 4, KK_FILE_F64, KK_FILE_ROWMAJOR, 1);
+		hdr.count = counts[t];
+		hdr.n = sizes[t];
+		memset(buf, 0, sizeof(buf));
+		memcpy(buf, &hdr, sizeof(hdr));
+
+		fp = fopen("/tmp/kk_bench.bad.kkm", "wb");
+		fwrite(buf, sizeof(buf), 1, fp);
+		fclose(fp);
+
+		if(!kk_file_map(&f, "/tmp/kk_bench.bad.kkm", 0)) {
+			kk_file_unmap(&f);
+			bad++;
+		}
+	}
+	remove("/tmp/kk_bench.bad.kkm");
+
+	return bad + !kk_file_header_init(&hdr, 0, KK_FILE_F64, KK_FILE_ROWMAJOR, 1);
+}
+
+/**
+ * @brief Time batch inversion of a matrix file: text (printf/strtod) round trip against mapped files.
+ *
+ * Files go to /tmp and are removed afterwards; columns are whole runs (load, invert and store).
+ */
+static void bench_file(void) {
+	static const int sizes[] = {4, 8, 16};
+	static const size_t count = 50000;
+	int t, n, p;
+	size_t m, e, nn;
+	double *in, *out, then, best[4];
+	char *text, *end;
+	FILE *fp;
+	kk_file_writer_t w;
+	kk_file_t fin, fout;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("Malformed headers accepted: %d\n", file_check_overflow());
+	printf("%6s %8s %12s %12s %12s %12s\n", "N", "count", "ms text", "ms memory", "ms mapped", "ms in place");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		nn = (size_t) n * n;
+		in = malloc(count * nn * sizeof(double));
+		out = malloc(count * nn * sizeof(double));
+		text = malloc(count * nn * 32);
+		for(m = 0; m < count; m++)
+			fill_matrix(n, &in[m * nn]);
+
+		/* Input files: text (one element per line) and matrix file */
+		fp = fopen("/tmp/kk_bench.txt", "w");
+		for(e = 0; e < count * nn; e++)
+			fprintf(fp, "%.17g\n", in[e]);
+		fclose(fp);
+		kk_file_writer_open(&w, "/tmp/kk_bench.kkm", n, KK_FILE_F64, KK_FILE_ROWMAJOR);
+		for(m = 0; m < count; m++)
+			kk_file_writer_put(&w, &in[m * nn]);
+		kk_file_writer_close(&w);
+
+		for(p = 0; p < 4; p++) {
+			then = now_sec();
+			if(0 == p) {
+				/* Status quo: parse, invert, print */
+				fp = fopen("/tmp/kk_bench.txt", "r");
+				e = fread(text, 1, count * nn * 32 - 1, fp);
+				text[e] = 0;
+				fclose(fp);
+				end = text;
+				for(e = 0; e < count * nn; e++)
+					in[e] = strtod(end, &end);
+				kk_batch_invert(n, count, in, out, &ws, NULL);
+				fp = fopen("/tmp/kk_bench.out.txt", "w");
+				for(e = 0; e < count * nn; e++)
+					fprintf(fp, "%.17g\n", out[e]);
+				fclose(fp);
+			}
+			else if(1 == p) {
+				/* Lower bound: matrices already in memory */
+				kk_batch_invert(n, count, in, out, &ws, NULL);
+			}
+			else if(2 == p) {
+				kk_file_map(&fin, "/tmp/kk_bench.kkm", 0);
+				kk_file_create(&fout, "/tmp/kk_bench.out.kkm", fin.hdr);
+				kk_file_invert(&fin, &fout, &ws, NULL);
+				kk_file_unmap(&fout);
+				kk_file_unmap(&fin);
+			}
+			else {
+				kk_file_map(&fin, "/tmp/kk_bench.kkm", 1);
+				kk_file_invert(&fin, &fin, &ws, NULL);
+				kk_file_unmap(&fin);
+			}
+			best[p] = now_sec() - then;
+		}
+
+		printf("%6d %8lu %12.2lf %12.2lf %12.2lf %12.2lf\n", n, (unsigned long) count, best[0] * 1e3, best[1] * 1e3, best[2] * 1e3, best[3] * 1e3);
+
+		remove("/tmp/kk_bench.txt");
+		remove("/tmp/kk_bench.out.txt");
+		remove("/tmp/kk_bench.kkm");
+		remove("/tmp/kk_bench.out.kkm");
+		free(in);
+		free(out);
+		free(text);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Time Freivalds verification (kk_verify()) against the identity check of main.c (product of
+ * inverse by matrix, then error distance from identity).
+ *
+ * Inverses come from kk_lu_invert(), so that they are accurate at every size. Rounds are those of a
+ * 1e-6 false-accept bound; err is the largest element of |A * inv * r - r|, wrong is the fraction of
+ * inverses with one element off by 1e-6 that were accepted (tolerance 1e-9).
+ */
+static void bench_verify(void) {
+	static const int sizes[] = {32, 128, 512};
+	int t, n, p, reps, rounds, i, j, k, wrong;
+	double *a, *inv, *ic, then, elapsed, best[2], inverted, err, val;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+	rounds = kk_verify_rounds(1e-6);
+
+	printf("%6s %7s %12s %12s %12s %8s %10s %7s\n", "N", "rounds", "us invert", "us identity", "us verify", "speedup", "err", "wrong");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		a = malloc((size_t) n * n * sizeof(double));
+		inv = malloc((size_t) n * n * sizeof(double));
+		ic = malloc((size_t) n * n * sizeof(double));
+		fill_matrix(n, a);
+
+		inverted = now_sec();
+		kk_lu_invert(n, a, inv, &ws, NULL);
+		inverted = now_sec() - inverted;
+
+		for(p = 0; p < 2; p++) {
+			best[p] = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				if(p) {
+					kk_verify(n, a, inv, rounds, reps, 1e-9, &ws, &err);
+				}
+				else {
+					memset(ic, 0, (size_t) n * n * sizeof(double));
+					for(i = 0; i < n; i++)
+						for(k = 0; k < n; k++)
+							for(j = 0; j < n; j++)
+								ic[i * n + j] += inv[i * n + k] * a[k * n + j];
+					for(val = 0, i = 0; i < n; i++)
+						for(j = 0; j < n; j++)
+							val += fabs(((i == j)? 1 : 0) - ic[i * n + j]);
+					ic[0] = val / ((double) n * n);
+				}
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best[p])
+					best[p] = then;
+			}
+		}
+
+		/* Single-element errors, one round each */
+		for(wrong = 0, k = 0; k < 100; k++) {
+			i = rand() % (n * n);
+			val = inv[i];
+			inv[i] += 1e-6;
+			wrong += !kk_verify(n, a, inv, 1, k, 1e-9, &ws, NULL);
+			inv[i] = val;
+		}
+
+		printf("%6d %7d %12.2lf %12.2lf %12.2lf %8.2lf %10.2le %6d%%\n", n, rounds, inverted * 1e6, best[0] * 1e6, best[1] * 1e6, best[0] / best[1], err, wrong);
+
+		free(a);
+		free(inv);
+		free(ic);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Time the full identity audit of kk_verify_full() against the one of main.c (plain i-j-k
+ * product into an N-by-N matrix, then error distance from identity), on 1, 2 and 4 workers.
+ *
+ * GFLOP/s counts the 2 N^3 operations of the product.
+ */
+static void bench_audit(void) {
+	static const int sizes[] = {128, 256, 512};
+	int t, n, i, j, k, threads, reps;
+	double *a, *inv, *ic, then, elapsed, best, naive = 0, err[2], val;
+	kk_pool_t *pool;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %8s %12s %12s %8s %10s\n", "N", "threads", "us naive", "us blocked", "speedup", "GFLOP/s");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		a = malloc((size_t) n * n * sizeof(double));
+		inv = malloc((size_t) n * n * sizeof(double));
+		ic = malloc((size_t) n * n * sizeof(double));
+		fill_matrix(n, a);
+		kk_lu_invert(n, a, inv, &ws, NULL);
+
+		for(threads = 0; threads <= 4; threads = threads? threads * 2 : 1) {
+			pool = (threads > 1)? kk_pool_create(threads) : NULL;
+
+			best = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				if(threads) {
+					kk_verify_full(pool, n, inv, a, &ws, &err[1]);
+				}
+				else {
+					for(i = 0; i < n; i++) {
+						for(j = 0; j < n; j++) {
+							ic[i * n + j] = 0;
+							for(k = 0; k < n; k++)
+								ic[i * n + j] += inv[i * n + k] * a[k * n + j];
+						}
+					}
+					for(val = 0, i = 0; i < n; i++)
+						for(j = 0; j < n; j++)
+							val += fabs(((i == j)? 1 : 0) - ic[i * n + j]);
+					err[0] = val / ((double) n * n);
+				}
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best)
+					best = then;
+			}
+
+			if(!threads)
+				naive = best;
+			else
+				printf("%6d %8d %12.2lf %12.2lf %8.2lf %10.2lf\n", n, threads, naive * 1e6, best * 1e6, naive / best, 2.0 * n * n * n / best * 1e-9);
+
+			if(pool)
+				kk_pool_destroy(pool);
+		}
+
+		/* Same products, only the error sum runs in another order */
+		if(fabs(err[0] - err[1]) > 1e-12 * err[0])
+			printf("Error distances differ: %.17le %.17le\n", err[0], err[1]);
+
+		free(a);
+		free(inv);
+		free(ic);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Time printing matrices with one fprintf() per element (as print_matrix() of main.c did) against
+ * kk_format writers, in fixed-precision, shortest round-trip and binary modes.
+ *
+ * 1000 inverses of 16-by-16 matrices go to /dev/null, so that only formatting and buffering are timed.
+ * Speedup of text modes is over fprintf() with the same precision ("%.17g" always reads back), that of
+ * binary mode over "%.17g".
+ */
+static void bench_format(void) {
+	static const int prec[] = {2, 2, KK_FORMAT_SHORTEST, KK_FORMAT_SHORTEST, 2};
+	static const char *const modes[] = {"printf %.2lf", "text %.2lf", "printf %.17g", "text shortest", "binary"};
+	const int n = 16, count = 1000;
+	int p, m, i, j, reps;
+	double *inv, then, elapsed, best, base = 0;
+	FILE *fp;
+	kk_format_t f;
+	kk_workspace_t ws;
+
+	fp = fopen("/dev/null", "w");
+	inv = malloc((size_t) count * n * n * sizeof(double));
+	if(!fp || !inv) {
+		printf("Could not open /dev/null\n");
+		free(inv);
+		if(fp)
+			fclose(fp);
+		return;
+	}
+
+	kk_workspace_init(&ws, NULL, 0);
+	for(m = 0; m < count; m++) {
+		srand(m);
+		for(i = 0; i < n * n; i++)
+			inv[(size_t) m * n * n + i] = ((rand() / (double) RAND_MAX) - 0.5) * 2.0;
+		kk_invert(n, &inv[(size_t) m * n * n], &inv[(size_t) m * n * n], &ws, NULL);
+	}
+	kk_workspace_free(&ws);
+
+	printf("%14s %14s %12s %8s\n", "mode", "ms/1000", "ns/value", "speedup");
+
+	for(p = 0; p < (int) (sizeof(modes) / sizeof(modes[0])); p++) {
+		best = 1e30;
+		elapsed = 0;
+		for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+			then = now_sec();
+			if(p & 1) {
+				kk_format_init(&f, fileno(fp), KK_FORMAT_TEXT, prec[p], 0);
+				for(m = 0; m < count; m++)
+					kk_format_matrix(&f, n, &inv[(size_t) m * n * n]);
+				kk_format_free(&f);
+			}
+			else if(4 == p) {
+				kk_format_init(&f, fileno(fp), KK_FORMAT_BINARY, prec[p], 0);
+				for(m = 0; m < count; m++)
+					kk_format_matrix(&f, n, &inv[(size_t) m * n * n]);
+				kk_format_free(&f);
+			}
+			else {
+				for(m = 0; m < count; m++) {
+					for(i = 0; i < n; i++) {
+						for(j = 0; j < n; j++)
+							fprintf(fp, p? "\t %.17g" : "\t %.2lf", inv[((size_t) m * n + i) * n + j]);
+						fprintf(fp, "\n");
+					}
+					fprintf(fp, "\n");
+				}
+				fflush(fp);
+			}
+			then = now_sec() - then;
+			elapsed += then;
+			if(then < best)
+				best = then;
+		}
+
+		/* Text modes against printf() with the same precision, binary against fixed text */
+		if(!(p & 1) && (4 != p))
+			base = best;
+
+		printf("%14s %14.3lf %12.2lf %8.2lf\n", modes[p], best * 1e3, best * 1e9 / ((double) count * n * n), base / best);
+	}
+
+	free(inv);
+	fclose(fp);
+}
+
+/**
+ * @brief Time KK iterations one sweep per iteration (kk_step()) against kk_iterate_tiled() at depths 2, 4
+ * and KK_TILE_DEPTH.
+ *
+ * Iterations only (transfer included, final iteration excluded); all depths calculate the same bits.
+ */
+static void bench_tile(void) {
+	static const int sizes[] = {256, 512, 1024};
+	static const int depths[] = {1, 2, 4, KK_TILE_DEPTH};
+	int t, d, n, reps;
+	double *in, then, elapsed, best[4];
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %10s %10s %10s %10s %8s\n", "N", "ms step", "ms d=2", "ms d=4", "ms d=8", "speedup");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		in = malloc((size_t) n * n * sizeof(double));
+		fill_matrix(n, in);
+		kk_workspace_reserve(&ws, n);
+
+		for(d = 0; d < 4; d++) {
+			best[d] = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				kk_transfer(&ws, n, in);
+				if(d)
+					kk_iterate_tiled(&ws, depths[d]);
+				else
+					while(ws.k < n - 1)
+						kk_step(&ws);
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best[d])
+					best[d] = then;
+			}
+		}
+
+		printf("%6d %10.2lf %10.2lf %10.2lf %10.2lf %8.2lf\n", n, best[0] * 1e3, best[1] * 1e3, best[2] * 1e3, best[3] * 1e3, best[0] / best[3]);
+
+		free(in);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Compare a barrier per iteration with pipelined iterations on pooled inversions.
+ */
+static void bench_pipeline(void) {
+	static const int sizes[] = {256, 512, 1024};
+	int t, p, n, threads, reps;
+	double *matrix_O, *matrix_I;
+	double then, elapsed, best[2];
+	kk_pool_t *pool;
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %8s %12s %14s %8s\n", "N", "threads", "ms barrier", "ms pipelined", "speedup");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		matrix_O = malloc((size_t) n * n * sizeof(double));
+		matrix_I = malloc((size_t) n * n * sizeof(double));
+		fill_matrix(n, matrix_O);
+
+		for(threads = 2; threads <= 16; threads *= 2) {
+			pool = kk_pool_create(threads);
+
+			for(p = 0; p < 2; p++) {
+				kk_pool_set_pipelined(pool, p);
+				best[p] = 1e30;
+				elapsed = 0;
+				for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+					then = now_sec();
+					kk_pool_invert(pool, n, matrix_O, matrix_I, &ws, NULL);
+					then = now_sec() - then;
+					elapsed += then;
+					if(then < best[p])
+						best[p] = then;
+				}
+			}
+
+			printf("%6d %8d %12.3lf %14.3lf %7.2lfx\n", n, threads, best[0] * 1e3, best[1] * 1e3, best[0] / best[1]);
+
+			kk_pool_destroy(pool);
+		}
+
+		free(matrix_I);
+		free(matrix_O);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Time KK iterations over three matrices (kk_step(), then kk_iterate_tiled()) against two
+ * (kk_iterate_lean()), with the scratch memory of each.
+ *
+ * Iterations only (transfer included, final iteration excluded); all of them calculate the same bits.
+ */
+static void bench_lean(void) {
+	static const int sizes[] = {256, 512, 1024};
+	int t, m, n, reps;
+	double *in, then, elapsed, best[3];
+	kk_workspace_t ws;
+
+	kk_workspace_init(&ws, NULL, 0);
+
+	printf("%6s %10s %10s %10s %10s %10s %8s\n", "N", "KiB 3", "KiB 2", "ms step", "ms tiled", "ms lean", "speedup");
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		n = sizes[t];
+		in = malloc((size_t) n * n * sizeof(double));
+		fill_matrix(n, in);
+
+		for(m = 0; m < 3; m++) {
+			if(m < 2)
+				kk_workspace_reserve(&ws, n);
+			else
+				kk_workspace_reserve_lean(&ws, n);
+
+			best[m] = 1e30;
+			elapsed = 0;
+			for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+				then = now_sec();
+				kk_transfer(&ws, n, in);
+				if(0 == m)
+					while(ws.k < n - 1)
+						kk_step(&ws);
+				else if(1 == m)
+					kk_iterate_tiled(&ws, KK_TILE_DEPTH);
+				else
+					kk_iterate_lean(&ws);
+				then = now_sec() - then;
+				elapsed += then;
+				if(then < best[m])
+					best[m] = then;
+			}
+		}
+
+		printf("%6d %10.0lf %10.0lf %10.2lf %10.2lf %10.2lf %8.2lf\n", n, kk_workspace_size(n) / 1024.0, kk_workspace_size_lean(n) / 1024.0,
+				best[0] * 1e3, best[1] * 1e3, best[2] * 1e3, best[0] / best[2]);
+
+		free(in);
+	}
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Sweep configuration.
+ */
+typedef struct {
+	/* Size of matrices */
+	int n;
+	/* Element type: 0 double, 1 float, 2 long double, 3 Q16.16 */
+	int precision;
+	/* Matrices per call (more than 1: kk_batch_invert()) */
+	int batch;
+	/* Workers (more than 1: kk_pool_invert()) */
+	int threads;
+} sweep_t;
+
+/**
+ * @brief Return operations of one KK inversion (two products, a difference and a division per element of
+ * each of the n - 1 iterations, then n^2 divisions), the base of GFLOP-equivalent figures.
+ *
+ * @param n Size of matrix.
+ *
+ * @return Number of floating-point (or fixed-point) operations.
+ */
+static double kk_flops(int n) {
+	return 4.0 * n * n * (n - 1) + (double) n * n;
+}
+
+/**
+ * @brief Time one sweep configuration: warmup, then samples until MIN_TIME has elapsed.
+ *
+ * @param c Configuration.
+ * @param samples Time of each call, in seconds (SWEEP_MAX_SAMPLES elements).
+ *
+ * @return Number of samples taken.
+ */
+static int sweep_run(const sweep_t *c, double *samples) {
+	int i, count = 0, n = c->n;
+	size_t nn = (size_t) n * n, total = nn * c->batch;
+	double *md, *od, then, start, elapsed;
+	float *mf, *of;
+	long double *ml, *ol;
+	kk_q16_t *mq, *oq;
+	void *mem;
+	kk_pool_t *pool = NULL;
+	kk_workspace_t ws;
+
+	md = malloc(total * sizeof(double));
+	od = malloc(total * sizeof(double));
+	mf = malloc(total * sizeof(float));
+	of = malloc(total * sizeof(float));
+	ml = malloc(total * sizeof(long double));
+	ol = malloc(total * sizeof(long double));
+	mq = malloc(total * sizeof(kk_q16_t));
+	oq = malloc(total * sizeof(kk_q16_t));
+	mem = malloc(kk_workspace_size_l(n));
+	kk_workspace_init(&ws, NULL, 0);
+	if(c->threads > 1)
+		pool = kk_pool_create(c->threads);
+
+	for(i = 0; i < c->batch; i++)
+		fill_matrix(n, &md[i * nn]);
+	for(i = 0; i < (int) total; i++) {
+		mf[i] = md[i];
+		ml[i] = md[i];
+		mq[i] = kk_fixed_from_double(md[i], 16, 16);
+	}
+
+	/* Samples taken during warmup are thrown away */
+	start = now_sec();
+	for(elapsed = 0; count < SWEEP_MAX_SAMPLES; ) {
+		then = now_sec();
+		if(c->batch > 1)
+			kk_batch_invert(n, c->batch, md, od, &ws, NULL);
+		else if(pool)
+			kk_pool_invert(pool, n, md, od, &ws, NULL);
+		else if(1 == c->precision)
+			kk_invert_f(n, mf, of, mem, NULL);
+		else if(2 == c->precision)
+			kk_invert_l(n, ml, ol, mem, NULL);
+		else if(3 == c->precision)
+			kk_invert_q(n, mq, oq, mem, NULL);
+		else
+			kk_invert(n, md, od, &ws, NULL);
+		then = now_sec() - then;
+
+		if(now_sec() - start < SWEEP_WARMUP)
+			continue;
+		samples[count++] = then;
+		elapsed += then;
+		if((elapsed >= MIN_TIME) && (count >= SWEEP_MIN_SAMPLES))
+			break;
+	}
+
+	if(pool)
+		kk_pool_destroy(pool);
+	kk_workspace_free(&ws);
+	free(md);
+	free(od);
+	free(mf);
+	free(of);
+	free(ml);
+	free(ol);
+	free(mq);
+	free(oq);
+	free(mem);
+
+	return count;
+}
+
+/**
+ * @brief Sweep matrix size, element type, batch size and thread count.
+ *
+ * Each configuration is warmed up, then timed call by call; median and p99 are per matrix, and GFLOP/s
+ * are KK operations (see kk_flops()) over the median. Every element type runs single-threaded on single
+ * matrices; double also runs batched (small sizes) and on a pool (large sizes). Results also go to the
+ * --json file, if any.
+ */
+static void bench_sweep(void) {
+	static const int sizes[] = {8, 32, 128, 256};
+	static const int batches[] = {8, 64};
+	static const int threads[] = {2, 4};
+	static const char *precisions[] = {"f64", "f32", "f80", "q16"};
+	static const char *levels[] = {"scalar", "sse2", "avx2", "avx512"};
+	int t, i, j, count, first = 1, nconf;
+	double median, p99, *samples;
+	sweep_t conf[8];
+
+	samples = malloc(SWEEP_MAX_SAMPLES * sizeof(double));
+
+	printf("%6s %6s %6s %8s %8s %12s %12s %10s\n", "N", "type", "batch", "threads", "samples", "us median", "us p99", "GFLOP/s");
+	if(json)
+		fprintf(json, "{\n  \"suite\": \"sweep\",\n  \"simd\": \"%s\",\n  \"flops\": \"4 n^2 (n - 1) + n^2 per matrix\",\n  \"results\": [", levels[kk_simd_get()]);
+
+	for(t = 0; t < (int) (sizeof(sizes) / sizeof(sizes[0])); t++) {
+		nconf = 0;
+		for(i = 0; i < 4; i++)
+			conf[nconf++] = (sweep_t) {sizes[t], i, 1, 1};
+		for(i = 0; (sizes[t] <= 32) && (i < (int) (sizeof(batches) / sizeof(batches[0]))); i++)
+			conf[nconf++] = (sweep_t) {sizes[t], 0, batches[i], 1};
+		for(i = 0; (sizes[t] >= 128) && (i < (int) (sizeof(threads) / sizeof(threads[0]))); i++)
+			conf[nconf++] = (sweep_t) {sizes[t], 0, 1, threads[i]};
+
+		for(j = 0; j < nconf; j++) {
+			count = sweep_run(&conf[j], samples);
+
+			/* Per matrix */
+			for(i = 0; i < count; i++)
+				samples[i] /= conf[j].batch;
+			p99 = percentile(samples, count, 99);
+			median = percentile(samples, count, 50);
+
+			printf("%6d %6s %6d %8d %8d %12.3lf %12.3lf %10.3lf\n", conf[j].n, precisions[conf[j].precision], conf[j].batch, conf[j].threads, count, median * 1e6, p99 * 1e6, kk_flops(conf[j].n) / median * 1e-9);
+			if(json)
+				fprintf(json, "%s\n    {\"n\": %d, \"type\": \"%s\", \"batch\": %d, \"threads\": %d, \"samples\": %d, \"median_us\": %.6g, \"p99_us\": %.6g, \"gflops\": %.6g}", first? "" : ",", conf[j].n, precisions[conf[j].precision], conf[j].batch, conf[j].threads, count, median * 1e6, p99 * 1e6, kk_flops(conf[j].n) / median * 1e-9);
+			first = 0;
+		}
+	}
+
+	if(json)
+		fprintf(json, "\n  ]\n}\n");
+
+	free(samples);
+}
+
+/**
+ * @brief Compare exact integer mode against double (time, width reached and double error).
+ *
+ * Vandermonde matrices are those of the_algorithm() (row i holds powers of i + 1); random ones hold
+ * 20-bit integers (so that no minor is zero), whose minors outgrow 128 bits from N = 6.
+ */
+static void bench_exact(void) {
+	static const char *widths[] = {"64", "128", "big"};
+	int t, n, i, j, p, reps, width = 0;
+	int64_t *matrix_Z;
+	double *matrix_O, *matrix_I, *matrix_X;
+	double then, elapsed, best[3], errDet, errInv;
+	char *det;
+	kk_result_t res;
+	kk_workspace_t ws;
+	kk_exact_t ex;
+
+	kk_workspace_init(&ws, NULL, 0);
+	kk_exact_init(&ex);
+
+	printf("%11s %6s %6s %12s %12s %12s %8s %12s %12s\n", "matrix", "N", "width", "us exact", "us modular", "us double", "digits", "det relerr", "inv relerr");
+
+	for(t = 0; t < 2; t++) {
+		for(n = t? 8 : 3; n <= (t? 64 : 16); n += (t || (n >= 12))? n : 1) {
+			matrix_Z = malloc((size_t) n * n * sizeof(int64_t));
+			matrix_O = malloc((size_t) n * n * sizeof(double));
+			matrix_I = malloc((size_t) n * n * sizeof(double));
+			matrix_X = malloc((size_t) n * n * sizeof(double));
+
+			srand(n);
+			for(i = 0; i < n; i++) {
+				for(j = 0; j < n; j++) {
+					matrix_Z[i * n + j] = t? (1 + rand() % 1000000) : (int64_t) pow(i + 1, j);
+					matrix_O[i * n + j] = (double) matrix_Z[i * n + j];
+				}
+			}
+
+			for(p = 0; p < 3; p++) {
+				best[p] = 1e30;
+				elapsed = 0;
+				for(reps = 0; (elapsed < MIN_TIME) || (reps < 3); reps++) {
+					then = now_sec();
+					if(2 == p)
+						kk_invert(n, matrix_O, matrix_I, &ws, &res);
+					else if(p)
+						kk_exact_invert_modular(n, matrix_Z, &ex, NULL);
+					else
+						kk_exact_invert(n, matrix_Z, &ex);
+					then = now_sec() - then;
+					elapsed += then;
+					if(then < best[p])
+						best[p] = then;
+				}
+				/* Width reached by iterations (modular mode always rebuilds multi-precision results) */
+				if(!p)
+					width = ex.width;
+			}
+
+			/* Double results against exact ones (rounded once) */
+			det = malloc(kk_exact_digits(&ex));
+			kk_exact_det_str(&ex, det, kk_exact_digits(&ex));
+			kk_exact_inverse(&ex, matrix_X);
+			errDet = fabs(res.det - strtod(det, NULL)) / fabs(strtod(det, NULL));
+			errInv = 0;
+			for(i = 0; i < n * n; i++) {
+				if(!(fabs(matrix_I[i] - matrix_X[i]) / fabs(matrix_X[i]) <= errInv))
+					errInv = fabs(matrix_I[i] - matrix_X[i]) / fabs(matrix_X[i]);
+			}
+
+			printf("%11s %6d %6s %12.2lf %12.2lf %12.2lf %8d %12.3le %12.3le\n", t? "random" : "vandermonde", n, ex.divZero? "div0" : widths[width], best[0] * 1e6, best[1] * 1e6, best[2] * 1e6,
+					(int) strlen(det) - ('-' == det[0]), errDet, errInv);
+
+			free(det);
+			free(matrix_X);
+			free(matrix_I);
+			free(matrix_O);
+			free(matrix_Z);
+		}
+	}
+
+	kk_exact_free(&ex);
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Benchmarks that may be selected from command line.
+ */
+static const struct {
+	const char *name;
+	void (*run)(void);
+} benches[] = {
+	{"layout", bench_layout},
+	{"simd", bench_simd},
+	{"batch", bench_batch},
+	{"fixed", bench_fixed},
+	{"precision", bench_precision},
+	{"threads", bench_threads},
+	{"sched", bench_sched},
+	{"small", bench_small},
+	{"exact", bench_exact},
+	{"fallback", bench_fallback},
+	{"precond", bench_precond},
+	{"det", bench_det},
+	{"solve", bench_solve},
+	{"update", bench_update},
+	{"file", bench_file},
+	{"verify", bench_verify},
+	{"audit", bench_audit},
+	{"format", bench_format},
+	{"tile", bench_tile},
+	{"pipeline", bench_pipeline},
+	{"lean", bench_lean},
+	{"sweep", bench_sweep}
+};
+
+/**
+ * @brief Main function.
+ *
+ * @param argc Number of arguments.
+ * @param argv Benchmarks to run (all of them if none given), and optionally --json followed by the file
+ *             that receives machine-readable results (of sweep).
+ *
+ * @return 0 on success, 1 on unknown benchmark or unwritable JSON file.
+ */
+int main(int argc, char *argv[]) {
+	int a, b, selected = 0, count = sizeof(benches) / sizeof(benches[0]);
+	const char *path = NULL;
+
+	for(a = 1; a < argc; a++) {
+		if(!strcmp(argv[a], "--json") && (a + 1 < argc)) {
+			path = argv[++a];
+			continue;
+		}
+
+		for(b = 0; (b < count) && strcmp(argv[a], benches[b].name); b++);
+		if(b == count) {
+			printf("Usage: %s [--json file]", argv[0]);
+			for(b = 0; b < count; b++)
+				printf(" [%s]", benches[b].name);
+			printf("\n");
+			return 1;
+		}
+		selected++;
+	}
+
+	if(path && !(json = fopen(path, "w"))) {
+		printf("Could not open %s\n", path);
+		return 1;
+	}
+
+	for(b = 0; b < count; b++) {
+		for(a = 1; (a < argc) && strcmp(argv[a], benches[b].name); a++);
+		if(!selected || (a < argc))
+			benches[b].run();
+	}
+
+	if(json)
+		fclose(json);
+
+	return 0;
+}
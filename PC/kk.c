@@ -0,0 +1,504 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (PC Library)                    * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kk.h"
+#include "kk_lu.h"
+#include "kk_simd.h"
+#include "kk_small.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+/* Checked row kernel gets one clone per instruction set, as the generic engine */
+#define KK_CHECK_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define KK_CHECK_CLONES
+#endif
+
+/**
+ * @brief Number of doubles in KK_ALIGN bytes.
+ */
+#define KK_ALIGN_ELEMS (KK_ALIGN / sizeof(double))
+
+/**
+ * @brief Return row stride (in elements) of an n-by-n scratch matrix.
+ *
+ * Every scratch matrix has one extra row and column replicating row 0 and column 0 (halo), so that
+ * (i + 1) and (j + 1) never wrap around.
+ *
+ * @param n Size of matrix.
+ *
+ * @return Row stride.
+ */
+static int kk_stride(int n) {
+	return (int) (((n + KK_ALIGN_ELEMS) / KK_ALIGN_ELEMS) * KK_ALIGN_ELEMS);
+}
+
+/**
+ * @brief Replicate row 0 and column 0 of a scratch matrix into its halo.
+ *
+ * @param matrix Scratch matrix.
+ * @param n Size of matrix.
+ * @param s Row stride.
+ */
+static void kk_halo(double *matrix, int n, int s) {
+	int i;
+
+	for(i = 0; i < n; i++)
+		matrix[i * s + n] = matrix[i * s];
+	memcpy(&matrix[n * s], matrix, (n + 1) * sizeof(double));
+}
+
+size_t kk_workspace_size(int n) {
+	return (3 * (size_t) (n + 1) + KK_TILE_DEPTH + 2) * kk_stride(n) * sizeof(double);
+}
+
+size_t kk_workspace_size_lean(int n) {
+	return 2 * (size_t) (n + 1) * kk_stride(n) * sizeof(double);
+}
+
+void kk_workspace_init(kk_workspace_t *ws, void *mem, size_t size) {
+	memset(ws, 0, sizeof(*ws));
+
+	ws->mem = mem;
+	ws->size = mem? size : 0;
+	ws->owned = !mem;
+}
+
+int kk_workspace_grow(kk_workspace_t *ws, size_t size) {
+	void *mem;
+
+	if(size > ws->size) {
+		/* Caller-provided memory cannot grow */
+		if(!ws->owned)
+			return -1;
+
+		/* Grow pooled memory (never shrinks, so steady state does not touch the heap) */
+		if(posix_memalign(&mem, KK_ALIGN, size))
+			return -1;
+		free(ws->mem);
+		ws->mem = mem;
+		ws->size = size;
+	}
+
+	return 0;
+}
+
+int kk_workspace_reserve(kk_workspace_t *ws, int n) {
+	int k;
+
+	if(kk_workspace_grow(ws, kk_workspace_size(n)))
+		return -1;
+
+	/* Set up scratchpad for current size */
+	ws->n = n;
+	ws->stride = kk_stride(n);
+	for(k = 0; k < 3; k++)
+		ws->matrix_K[k] = ((double *) ws->mem) + ((size_t) k * (n + 1) * ws->stride);
+
+	return 0;
+}
+
+int kk_workspace_reserve_lean(kk_workspace_t *ws, int n) {
+	if(kk_workspace_grow(ws, kk_workspace_size_lean(n)))
+		return -1;
+
+	/* Previous and current matrices only (kk_transfer() starts with next = 0) */
+	ws->n = n;
+	ws->stride = kk_stride(n);
+	ws->matrix_K[0] = NULL;
+	ws->matrix_K[1] = (double *) ws->mem;
+	ws->matrix_K[2] = ((double *) ws->mem) + ((size_t) (n + 1) * ws->stride);
+
+	return 0;
+}
+
+void kk_workspace_free(kk_workspace_t *ws) {
+	if(ws->owned)
+		free(ws->mem);
+
+	kk_workspace_init(ws, NULL, 0);
+}
+
+void kk_transfer(kk_workspace_t *ws, int n, const double *in) {
+	int i, j, s;
+
+	ws->n = n;
+	ws->stride = s = kk_stride(n);
+	ws->next = 0;
+	ws->prev = 1;
+	ws->curr = 2;
+	ws->k = 0;
+	ws->divZero = 0;
+
+	for(i = 0; i < n; i++)
+		memcpy(&ws->matrix_K[ws->curr][i * s], &in[i * n], n * sizeof(double));
+	kk_halo(ws->matrix_K[ws->curr], n, s);
+
+	/* Divisor of first iteration is 1 */
+	for(i = 0; i <= n; i++)
+		for(j = 0; j <= n; j++)
+			ws->matrix_K[ws->prev][i * s + j] = 1.0;
+}
+
+int kk_step_rows(kk_workspace_t *ws, int lo, int hi) {
+	int i, n = ws->n, s = ws->stride;
+	int divZero = 0;
+	double *next = ws->matrix_K[ws->next];
+	const double *prev = ws->matrix_K[ws->prev];
+	const double *curr = ws->matrix_K[ws->curr];
+
+	/* Rows i and i + 1 of current matrix, row i + 1 of previous matrix (halo makes row n valid) */
+	for(i = lo; i < hi; i++) {
+		divZero |= kk_kernels.iterate_row(&next[i * s], &curr[i * s], &curr[(i + 1) * s], &prev[(i + 1) * s], n, 1);
+		next[i * s + n] = next[i * s];
+	}
+
+	/* Row 0 is replicated as soon as it is done */
+	if(0 == lo)
+		memcpy(&next[n * s], next, (n + 1) * sizeof(double));
+
+	return divZero;
+}
+
+void kk_rotate(kk_workspace_t *ws, int divZero) {
+	int tmp;
+
+	/* Refresh indexes */
+	tmp = ws->prev;
+	ws->prev = ws->curr;
+	ws->curr = ws->next;
+	ws->next = tmp;
+	ws->k++;
+
+	ws->divZero |= divZero;
+}
+
+int kk_step(kk_workspace_t *ws) {
+	kk_rotate(ws, kk_step_rows(ws, 0, ws->n));
+
+	return ws->divZero;
+}
+
+int kk_iterate(kk_workspace_t *ws) {
+	if(!ws->matrix_K[ws->next])
+		return kk_iterate_lean(ws);
+	if(ws->n >= KK_TILE_MIN)
+		return kk_iterate_tiled(ws, KK_TILE_DEPTH);
+
+	while(ws->k < ws->n - 1)
+		kk_step(ws);
+
+	return ws->divZero;
+}
+
+int kk_iterate_tiled(kk_workspace_t *ws, int depth) {
+	int n = ws->n, s = ws->stride, t, T, p, r, divZero = 0;
+	/* Matrix and halo row of each iteration of a group (index t + 1: previous, current, then new ones) */
+	double *m[KK_TILE_DEPTH + 2], *halo[KK_TILE_DEPTH + 2];
+	double *ring = ws->matrix_K[0] + 3 * (size_t) (n + 1) * s;
+	const double *c1, *p1;
+
+	if(depth < 1)
+		depth = 1;
+	if(depth > KK_TILE_DEPTH)
+		depth = KK_TILE_DEPTH;
+
+	while(ws->k < n - 1) {
+		T = (n - 1 - ws->k < depth)? n - 1 - ws->k : depth;
+
+		/* Iteration t goes to the matrix of iteration t - 3 */
+		m[0] = ws->matrix_K[ws->prev];
+		m[1] = ws->matrix_K[ws->curr];
+		m[2] = ws->matrix_K[ws->next];
+		for(t = 0; t < T + 2; t++) {
+			if(t >= 3)
+				m[t] = m[t - 3];
+			halo[t] = &ring[t * s];
+		}
+		memcpy(halo[0], &m[0][n * s], (n + 1) * sizeof(double));
+		memcpy(halo[1], &m[1][n * s], (n + 1) * sizeof(double));
+
+		/* Iteration t of group calculates row r = p - t + 1, so rows r and r + 1 of iteration t - 1 are done */
+		for(p = 0; p < n + T - 1; p++) {
+			for(t = 1; (t <= T) && (p - t + 1 >= 0); t++) {
+				r = p - t + 1;
+				if(r >= n)
+					continue;
+
+				c1 = (r + 1 < n)? &m[t][(r + 1) * s] : halo[t];
+				p1 = (r + 1 < n)? &m[t - 1][(r + 1) * s] : halo[t - 1];
+				divZero |= kk_kernels.iterate_row(&m[t + 1][r * s], &m[t][r * s], c1, p1, n, 1);
+				m[t + 1][r * s + n] = m[t + 1][r * s];
+
+				if(0 == r) {
+					memcpy(halo[t + 1], m[t + 1], (n + 1) * sizeof(double));
+					memcpy(&m[t + 1][n * s], m[t + 1], (n + 1) * sizeof(double));
+				}
+			}
+		}
+
+		for(t = 0; t < T; t++)
+			kk_rotate(ws, divZero);
+	}
+
+	return ws->divZero;
+}
+
+int kk_iterate_lean(kk_workspace_t *ws) {
+	int i, tmp, n = ws->n, s = ws->stride, divZero;
+	double *prev;
+	const double *curr;
+
+	/*
+	 * Row i of previous matrix is only read by row i - 1 of next matrix, so next matrix overwrites
+	 * previous one in place, from top to bottom. Halo row n, read by row n - 1, is refreshed from
+	 * row 0 once the sweep is over.
+	 */
+	while(ws->k < n - 1) {
+		prev = ws->matrix_K[ws->prev];
+		curr = ws->matrix_K[ws->curr];
+		divZero = 0;
+
+		for(i = 0; i < n; i++) {
+			divZero |= kk_kernels.iterate_row(&prev[i * s], &curr[i * s], &curr[(i + 1) * s], &prev[(i + 1) * s], n, 1);
+			prev[i * s + n] = prev[i * s];
+		}
+		memcpy(&prev[n * s], prev, (n + 1) * sizeof(double));
+
+		/* Previous matrix now holds next one (next index is left alone) */
+		tmp = ws->prev;
+		ws->prev = ws->curr;
+		ws->curr = tmp;
+		ws->k++;
+		ws->divZero |= divZero;
+	}
+
+	return ws->divZero;
+}
+
+int kk_final_rows(kk_workspace_t *ws, double *out, int lo, int hi) {
+	int i, n = ws->n, s = ws->stride;
+	int divZero = 0;
+	const double *prev = ws->matrix_K[ws->prev];
+	const double *curr = ws->matrix_K[ws->curr];
+
+	/* Element (i, j) of inverse is prev[j + 1][i + 1] / curr[i][j] */
+	for(i = lo; i < hi; i++)
+		divZero |= kk_kernels.final_row(&out[i * n], &prev[s + (i + 1)], s, &curr[i * s], n);
+
+	return divZero;
+}
+
+int kk_final(kk_workspace_t *ws, double *out) {
+	ws->divZero |= kk_final_rows(ws, out, 0, ws->n);
+
+	return ws->divZero;
+}
+
+double kk_getintelem(const kk_workspace_t *ws, int i, int j) {
+	return ws->matrix_K[ws->prev][i * ws->stride + j];
+}
+
+double kk_getdetelem(const kk_workspace_t *ws, int i, int j) {
+	return ws->matrix_K[ws->curr][i * ws->stride + j];
+}
+
+int kk_invert(int n, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res) {
+	if((n > 0) && (n <= KK_SMALL_MAX)) {
+		kk_small[n](in, out, res);
+		return 0;
+	}
+
+	if(kk_workspace_reserve(ws, n))
+		return -1;
+
+	kk_transfer(ws, n, in);
+	kk_iterate(ws);
+	kk_final(ws, out);
+
+	if(res) {
+		res->det = kk_getdetelem(ws, 0, 0);
+		res->divZero = ws->divZero;
+		res->path = KK_PATH_KK;
+	}
+
+	return 0;
+}
+
+int kk_invert_lean(int n, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res) {
+	if((n > 0) && (n <= KK_SMALL_MAX)) {
+		kk_small[n](in, out, res);
+		return 0;
+	}
+
+	if(kk_workspace_reserve_lean(ws, n))
+		return -1;
+
+	kk_transfer(ws, n, in);
+	kk_iterate_lean(ws);
+	kk_final(ws, out);
+
+	if(res) {
+		res->det = kk_getdetelem(ws, 0, 0);
+		res->divZero = ws->divZero;
+		res->path = KK_PATH_KK;
+	}
+
+	return 0;
+}
+
+int kk_determinant(int n, const double *in, kk_workspace_t *ws, kk_result_t *res) {
+	int i, k, m, s = kk_stride(n), divZero = 0;
+	int cs, ps;
+	double *buf[2];
+	const double *curr, *prev;
+
+	if(n < 2) {
+		res->det = (1 == n)? in[0] : 1.0;
+		res->divZero = 0;
+		res->path = KK_PATH_KK;
+		return 0;
+	}
+
+	/* Two n-by-n buffers, no halo (leading minors never wrap around) */
+	if(kk_workspace_grow(ws, 2 * (size_t) n * s * sizeof(double)))
+		return -1;
+	buf[0] = ws->mem;
+	buf[1] = buf[0] + (size_t) n * s;
+
+	/* Divisor of first iteration is 1 (a single row, in the buffer second iteration writes to) */
+	for(i = 0; i <= n; i++)
+		buf[1][i] = 1.0;
+
+	/*
+	 * Iteration k only needs rows and columns 0 to n - 1 - k of its result to reach element (0, 0), so
+	 * work drops from n^3 to about n^3 / 3 multiplications. Next matrix overwrites previous one in place:
+	 * row i needs row i + 1 of previous matrix, which rows above it do not touch.
+	 */
+	curr = in;
+	cs = n;
+	prev = buf[1];
+	ps = 0;
+	for(k = 1; k < n; k++) {
+		m = n - k;
+		for(i = 0; i < m; i++)
+			divZero |= kk_kernels.iterate_row(&buf[(k + 1) & 1][i * s], &curr[i * cs], &curr[(i + 1) * cs], &prev[(i + 1) * ps], m, 1);
+
+		prev = curr;
+		ps = cs;
+		curr = buf[(k + 1) & 1];
+		cs = s;
+	}
+
+	res->det = curr[0];
+	res->divZero = divZero;
+	res->path = KK_PATH_KK;
+
+	return 0;
+}
+
+/**
+ * @brief Calculate one row of a KK iteration, checking every element for cancellation.
+ *
+ * Same operations as the row kernels (so results are bit-identical), plus a check on the two products
+ * of each element: |a - b| <= tol * (|a| + |b|) means that the element lost all but -log10(tol)
+ * significant digits (or is zero). The check is negated so that overflows (inf or NaN) count as well.
+ *
+ * @param next Row i of next matrix (n elements).
+ * @param c0 Row i of current matrix (n + 1 elements, halo included).
+ * @param c1 Row i + 1 of current matrix (n + 1 elements, halo included).
+ * @param p1 Row i + 1 of previous matrix (n + 1 elements, halo included).
+ * @param n Number of elements in row.
+ * @param tol Relative cancellation tolerance.
+ *
+ * @return Non-zero if any divisor was zero or any element cancelled.
+ */
+KK_CHECK_CLONES static int kk_iterate_row_checked(double *restrict next, const double *restrict c0, const double *restrict c1, const double *restrict p1, int n, double tol) {
+	int j, broken = 0;
+	double a, b;
+
+	for(j = 0; j < n; j++) {
+		a = c0[j] * c1[j + 1];
+		b = c1[j] * c0[j + 1];
+		broken |= (0 == p1[j + 1]) | !(fabs(a - b) > tol * (fabs(a) + fabs(b)));
+		next[j] = (a - b) / p1[j + 1];
+	}
+
+	return broken;
+}
+
+int kk_iterate_checked(kk_workspace_t *ws, double tol) {
+	int i, j, n = ws->n, s = ws->stride, broken = 0;
+	double *next;
+	const double *prev, *curr;
+
+	/* Input elements are divisors of second iteration */
+	if(0 == ws->k) {
+		curr = ws->matrix_K[ws->curr];
+		for(i = 0; i < n; i++) {
+			for(j = 0; j < n; j++)
+				broken |= (0 == curr[i * s + j]);
+		}
+	}
+
+	/* Stop as soon as an element that will be a divisor cancels */
+	while((ws->k < n - 1) && !broken) {
+		next = ws->matrix_K[ws->next];
+		prev = ws->matrix_K[ws->prev];
+		curr = ws->matrix_K[ws->curr];
+		for(i = 0; i < n; i++) {
+			broken |= kk_iterate_row_checked(&next[i * s], &curr[i * s], &curr[(i + 1) * s], &prev[(i + 1) * s], n, tol);
+			next[i * s + n] = next[i * s];
+		}
+		memcpy(&next[n * s], next, (n + 1) * sizeof(double));
+		kk_rotate(ws, 0);
+	}
+
+	return broken;
+}
+
+int kk_invert_safe(int n, const double *in, double *out, kk_workspace_t *ws, double tol, kk_result_t *res) {
+	if(kk_workspace_reserve(ws, n))
+		return -1;
+
+	kk_transfer(ws, n, in);
+	if(kk_iterate_checked(ws, tol))
+		return kk_lu_invert(n, in, out, ws, res);
+
+	kk_final(ws, out);
+
+	if(res) {
+		res->det = kk_getdetelem(ws, 0, 0);
+		res->divZero = ws->divZero;
+		res->path = KK_PATH_KK;
+	}
+
+	return 0;
+}
@@ -0,0 +1,414 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (PC Library)                    * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_H
+#define KK_H
+
+#include <stddef.h>
+
+/**
+ * @brief Alignment (in bytes) of every scratch matrix row.
+ */
+#define KK_ALIGN 64
+
+/**
+ * @brief Iterations kk_iterate() advances together in one sweep over the scratchpad (see kk_iterate_tiled()).
+ */
+#define KK_TILE_DEPTH 8
+
+/**
+ * @brief Smallest size kk_iterate() runs tiled (below it, the three matrices stay in a 2 MiB L2 cache anyway).
+ */
+#define KK_TILE_MIN 320
+
+/**
+ * @brief KK scratchpad (three rotating matrices) plus iteration state.
+ *
+ * A workspace is either backed by caller-provided memory (see kk_workspace_init()) or owns a
+ * pooled buffer that only grows (see kk_workspace_reserve()), so that repeated inversions do not
+ * touch the heap. A workspace must not be shared between concurrent inversions.
+ */
+typedef struct {
+	/* Scratch memory, aligned to KK_ALIGN */
+	void *mem;
+	/* Size of scratch memory in bytes */
+	size_t size;
+	/* 1 if memory was allocated by (and belongs to) this workspace */
+	int owned;
+
+	/* Size of matrix currently loaded */
+	int n;
+	/* Distance (in elements) between two consecutive rows */
+	int stride;
+	/* Matrix scratchpad, each one (n+1)-by-(n+1) with row n and column n replicating row 0 and column 0 */
+	double *matrix_K[3];
+	/* Indexes for next, previous and current matrix */
+	int next, prev, curr;
+	/* Iterations done so far */
+	int k;
+	/* Division by zero flag */
+	int divZero;
+} kk_workspace_t;
+
+/**
+ * @brief Algorithm that produced an inverse.
+ */
+typedef enum {
+	/* KK iterations */
+	KK_PATH_KK = 0,
+	/* Partially pivoted LU (see kk_invert_safe()) */
+	KK_PATH_LU
+} kk_path_t;
+
+/**
+ * @brief Result of a KK inversion.
+ */
+typedef struct {
+	/* Determinant of input matrix */
+	double det;
+	/* 1 if any division by zero occurred (same meaning as hardware divZero flag), 0 otherwise */
+	int divZero;
+	/* Algorithm that ran */
+	kk_path_t path;
+} kk_result_t;
+
+/**
+ * @brief SIMD instruction sets available for KK kernels.
+ *
+ * All levels perform the same IEEE operations in the same order (no fused multiply-add), so their
+ * results are bit-identical to the scalar path (0 ULP difference).
+ */
+typedef enum {
+	KK_SIMD_SCALAR = 0,
+	KK_SIMD_SSE2,
+	KK_SIMD_AVX2,
+	KK_SIMD_AVX512
+} kk_simd_t;
+
+/**
+ * @brief Detect best SIMD level supported by this CPU (selected automatically at program start).
+ *
+ * @return SIMD level.
+ */
+kk_simd_t kk_simd_detect(void);
+
+/**
+ * @brief Get SIMD level in use.
+ *
+ * @return SIMD level.
+ */
+kk_simd_t kk_simd_get(void);
+
+/**
+ * @brief Force a SIMD level (not thread-safe, call before starting any inversion).
+ *
+ * @param level SIMD level.
+ *
+ * @return 0 on success, -1 if level is not supported by this CPU.
+ */
+int kk_simd_set(kk_simd_t level);
+
+/**
+ * @brief Return scratch memory needed to invert an n-by-n matrix.
+ *
+ * @param n Size of matrix.
+ *
+ * @return Size in bytes (three matrices with halo, then KK_TILE_DEPTH + 2 halo rows for kk_iterate_tiled()).
+ */
+size_t kk_workspace_size(int n);
+
+/**
+ * @brief Return scratch memory needed to invert an n-by-n matrix in a lean workspace.
+ *
+ * @param n Size of matrix.
+ *
+ * @return Size in bytes (two matrices with halo, see kk_workspace_reserve_lean()).
+ */
+size_t kk_workspace_size_lean(int n);
+
+/**
+ * @brief Initialise a workspace on caller-provided memory.
+ *
+ * @param ws Workspace.
+ * @param mem Scratch memory, aligned to KK_ALIGN (may be NULL for an empty pooled workspace).
+ * @param size Size of scratch memory in bytes.
+ */
+void kk_workspace_init(kk_workspace_t *ws, void *mem, size_t size);
+
+/**
+ * @brief Make sure a workspace holds at least a given amount of scratch memory.
+ *
+ * @param ws Workspace.
+ * @param size Size in bytes.
+ *
+ * @return 0 on success, -1 if memory could not be allocated or caller-provided memory is too small.
+ */
+int kk_workspace_grow(kk_workspace_t *ws, size_t size);
+
+/**
+ * @brief Make sure a workspace can hold an n-by-n inversion, growing pooled memory if needed.
+ *
+ * @param ws Workspace.
+ * @param n Size of matrix.
+ *
+ * @return 0 on success, -1 if memory could not be allocated or caller-provided memory is too small.
+ */
+int kk_workspace_reserve(kk_workspace_t *ws, int n);
+
+/**
+ * @brief Make sure a workspace can hold an n-by-n inversion with two matrices instead of three.
+ *
+ * A lean workspace only runs kk_iterate_lean() (kk_iterate() switches to it on its own), so it must not
+ * be given to kk_step(), kk_step_rows(), kk_iterate_tiled(), kk_iterate_checked() or a kk_pool_t, which
+ * need kk_workspace_reserve(). Transfer, final iteration and element getters work the same.
+ *
+ * @param ws Workspace.
+ * @param n Size of matrix.
+ *
+ * @return 0 on success, -1 if memory could not be allocated or caller-provided memory is too small.
+ */
+int kk_workspace_reserve_lean(kk_workspace_t *ws, int n);
+
+/**
+ * @brief Release pooled memory of a workspace (caller-provided memory is left untouched).
+ *
+ * @param ws Workspace.
+ */
+void kk_workspace_free(kk_workspace_t *ws);
+
+/**
+ * @brief Transfer a matrix to the scratchpad.
+ *
+ * @param ws Workspace (must be reserved for n).
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ */
+void kk_transfer(kk_workspace_t *ws, int n, const double *in);
+
+/**
+ * @brief Run a single KK iteration.
+ *
+ * @param ws Workspace (after kk_transfer()).
+ *
+ * @return 1 if any division by zero occurred so far, 0 otherwise.
+ */
+int kk_step(kk_workspace_t *ws);
+
+/**
+ * @brief Calculate a band of rows of next KK iteration (building block for parallel executors).
+ *
+ * Rows of a band only depend on the current and previous matrices, so disjoint bands of the same
+ * iteration may run concurrently. Halo of the band is updated as well (row n too, if band holds row 0).
+ * Once every row is done, kk_rotate() must be called exactly once.
+ *
+ * @param ws Workspace (after kk_transfer()).
+ * @param lo First row.
+ * @param hi One past last row.
+ *
+ * @return 1 if any division by zero occurred in band, 0 otherwise.
+ */
+int kk_step_rows(kk_workspace_t *ws, int lo, int hi);
+
+/**
+ * @brief Finish a KK iteration calculated by kk_step_rows() (next matrix becomes current one).
+ *
+ * @param ws Workspace.
+ * @param divZero Division by zero flag of the iteration (OR of all bands).
+ */
+void kk_rotate(kk_workspace_t *ws, int divZero);
+
+/**
+ * @brief Run the remaining of the n-1 KK iterations over transferred matrix.
+ *
+ * Matrices of size KK_TILE_MIN and above run through kk_iterate_tiled() with KK_TILE_DEPTH, and lean
+ * workspaces (see kk_workspace_reserve_lean()) through kk_iterate_lean().
+ *
+ * @param ws Workspace.
+ *
+ * @return 1 if any division by zero occurred, 0 otherwise.
+ */
+int kk_iterate(kk_workspace_t *ws);
+
+/**
+ * @brief Run the remaining KK iterations, depth iterations per sweep over the scratchpad.
+ *
+ * Row i of an iteration only needs rows i and i + 1 of the two before it, so a sweep calculates row
+ * r of the first iteration of a group, row r - 1 of the second one, and so on down to row r - depth + 1
+ * of the last one, for r going down the matrix. The rows in flight (about 3 * depth of them) stay in
+ * cache, and each iteration writes over the matrix of three iterations before only after every row of
+ * it was last read: matrices are streamed from memory once per depth iterations instead of once per
+ * iteration. Halo rows (row 0 of each iteration in flight, needed by its last rows) are kept apart, at
+ * the end of the scratchpad. Results are bit-identical to kk_step() repeated.
+ *
+ * @param ws Workspace (after kk_transfer()).
+ * @param depth Iterations per sweep (1 to KK_TILE_DEPTH).
+ *
+ * @return 1 if any division by zero occurred, 0 otherwise.
+ */
+int kk_iterate_tiled(kk_workspace_t *ws, int depth);
+
+/**
+ * @brief Run the remaining KK iterations over two matrices, next one overwriting previous one in place.
+ *
+ * Row i of next matrix is the last one to need row i + 1 of previous matrix, so a sweep from top to
+ * bottom writes each row over the previous matrix once it has been read (only halo row n, a copy of
+ * row 0, is refreshed after the sweep). The third matrix is neither read nor written, and each
+ * iteration writes to cache lines it just read instead of allocating fresh ones. Results are
+ * bit-identical to kk_step() repeated.
+ *
+ * @param ws Workspace (after kk_transfer(), full or lean).
+ *
+ * @return 1 if any division by zero occurred, 0 otherwise.
+ */
+int kk_iterate_lean(kk_workspace_t *ws);
+
+/**
+ * @brief Run the remaining KK iterations, stopping at the first breakdown (see kk_invert_safe()).
+ *
+ * @param ws Workspace (after kk_transfer()).
+ * @param tol Relative cancellation tolerance.
+ *
+ * @return 1 if an element cancelled or was zero (iterations were abandoned), 0 otherwise.
+ */
+int kk_iterate_checked(kk_workspace_t *ws, double tol);
+
+/**
+ * @brief Final iteration: calculate inverse.
+ *
+ * @param ws Workspace (after kk_iterate()).
+ * @param out n-by-n row-major output matrix.
+ *
+ * @return 1 if any division by zero occurred, 0 otherwise.
+ */
+int kk_final(kk_workspace_t *ws, double *out);
+
+/**
+ * @brief Final iteration on a band of rows (bands may run concurrently).
+ *
+ * @param ws Workspace (after kk_iterate()).
+ * @param out n-by-n row-major output matrix.
+ * @param lo First row.
+ * @param hi One past last row.
+ *
+ * @return 1 if any division by zero occurred in band, 0 otherwise.
+ */
+int kk_final_rows(kk_workspace_t *ws, double *out, int lo, int hi);
+
+/**
+ * @brief Get intermediate matrix element ((n-1)-by-(n-1) cyclic minors).
+ *
+ * @param ws Workspace (after kk_iterate()).
+ * @param i Line index.
+ * @param j Column index.
+ *
+ * @return The element itself.
+ */
+double kk_getintelem(const kk_workspace_t *ws, int i, int j);
+
+/**
+ * @brief Get determinant matrix element (n-by-n cyclic minors, element (0, 0) is the determinant).
+ *
+ * @param ws Workspace (after kk_iterate()).
+ * @param i Line index.
+ * @param j Column index.
+ *
+ * @return The element itself.
+ */
+double kk_getdetelem(const kk_workspace_t *ws, int i, int j);
+
+/**
+ * @brief Invert a matrix using KK Algorithm.
+ *
+ * Sizes up to KK_SMALL_MAX run on specialized kernels (see kk_small.h) that leave the workspace
+ * untouched; results are bit-identical to the generic path.
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param out n-by-n row-major output matrix (may alias in).
+ * @param ws Workspace (pooled workspaces are grown as needed).
+ * @param res Determinant and division by zero flag (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold an n-by-n inversion.
+ */
+int kk_invert(int n, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res);
+
+/**
+ * @brief Invert a matrix using KK Algorithm in a lean workspace (two matrices, see kk_iterate_lean()).
+ *
+ * Needs two thirds of the scratch memory of kk_invert(), with bit-identical results.
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param out n-by-n row-major output matrix (may alias in).
+ * @param ws Workspace (pooled workspaces are grown as needed, and left lean).
+ * @param res Determinant and division by zero flag (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold a lean n-by-n inversion.
+ */
+int kk_invert_lean(int n, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res);
+
+/**
+ * @brief Calculate the determinant of a matrix using KK Algorithm, without inverting it.
+ *
+ * Stops after the last KK iteration and only calculates the elements that element (0, 0) depends on,
+ * in two rolling buffers (about a third of the work of kk_invert() and two thirds of its memory).
+ * Determinant is bit-identical to the one kk_invert() reports. Contents of the workspace are lost.
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param ws Workspace (pooled workspaces are grown as needed).
+ * @param res Determinant and division by zero flag (only set by minors the determinant depends on).
+ *
+ * @return 0 on success, -1 if workspace could not hold two n-by-n buffers.
+ */
+int kk_determinant(int n, const double *in, kk_workspace_t *ws, kk_result_t *res);
+
+/**
+ * @brief Invert a matrix using KK Algorithm, falling back to partially pivoted LU if KK breaks down.
+ *
+ * KK divides by leading cyclic minors, so it fails on matrices that are not strongly non-singular.
+ * Every element is checked as soon as it is calculated (before it is used as a divisor): an element
+ * whose two products cancel, |a - b| <= tol * (|a| + |b|), lost all but -log10(tol) significant
+ * digits and is taken as zero, as are overflows. Remaining iterations are then skipped and the input is
+ * inverted by kk_lu_invert() instead. A tolerance of zero only catches exact zeros (any zero element
+ * makes KK divide by zero, as input elements are minors too). Otherwise, results are bit-identical to
+ * kk_invert().
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param out n-by-n row-major output matrix (may alias in).
+ * @param ws Workspace (pooled workspaces are grown as needed).
+ * @param tol Relative cancellation tolerance (0 for exact zeros only; 1e-9 catches singular leading
+ *            minors of matrices up to a few hundred rows, despite rounding).
+ * @param res Determinant, path taken and division by zero flag, which is only set if the matrix is
+ *            singular (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold an n-by-n inversion.
+ */
+int kk_invert_safe(int n, const double *in, double *out, kk_workspace_t *ws, double tol, kk_result_t *res);
+
+#endif
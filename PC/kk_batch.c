@@ -0,0 +1,222 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Batch Library)                 * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <string.h>
+
+#include "kk_batch.h"
+#include "kk_simd.h"
+
+/**
+ * @brief Short name for number of lanes.
+ */
+#define W KK_BATCH_LANES
+
+size_t kk_batch_packed_size(int n, size_t count) {
+	return ((count + W - 1) / W) * n * n * W * sizeof(double);
+}
+
+void kk_batch_pack(int n, size_t count, const double *in, double *packed) {
+	size_t m, e, nn = (size_t) n * n, padded = ((count + W - 1) / W) * W;
+
+	for(m = 0; m < padded; m++) {
+		for(e = 0; e < nn; e++) {
+			if(m < count)
+				packed[((m / W) * nn + e) * W + (m % W)] = in[m * nn + e];
+			else
+				packed[((m / W) * nn + e) * W + (m % W)] = ((e / n) == (e % n))? 1.0 : 0.0;
+		}
+	}
+}
+
+void kk_batch_unpack(int n, size_t count, const double *packed, double *out) {
+	size_t m, e, nn = (size_t) n * n;
+
+	for(m = 0; m < count; m++)
+		for(e = 0; e < nn; e++)
+			out[m * nn + e] = packed[((m / W) * nn + e) * W + (m % W)];
+}
+
+size_t kk_batch_workspace_size(int n) {
+	return 3 * (size_t) (n + 1) * (n + 1) * W * sizeof(double);
+}
+
+/**
+ * @brief Replicate row 0 and column 0 of an interleaved scratch matrix into its halo.
+ *
+ * @param matrix Interleaved scratch matrix.
+ * @param n Size of matrices.
+ * @param rs Row stride ((n + 1) * W).
+ */
+static void kk_batch_halo(double *matrix, int n, size_t rs) {
+	int i;
+
+	for(i = 0; i < n; i++)
+		memcpy(&matrix[i * rs + n * W], &matrix[i * rs], W * sizeof(double));
+	memcpy(&matrix[n * rs], matrix, rs * sizeof(double));
+}
+
+/**
+ * @brief Flag lanes whose divisors in a row are zero (only called once a kernel reported a zero divisor).
+ *
+ * @param row Interleaved row (n * W elements).
+ * @param n Size of matrices.
+ * @param divZero Per-lane division by zero flags.
+ */
+static void kk_batch_flag(const double *row, int n, int *divZero) {
+	int e;
+
+	for(e = 0; e < n * W; e++)
+		divZero[e % W] |= (0 == row[e]);
+}
+
+/**
+ * @brief Invert one group of W matrices.
+ *
+ * @param n Size of matrices.
+ * @param group Index of group.
+ * @param count Total number of matrices.
+ * @param in Input (packed if packed is 1, row-major otherwise).
+ * @param out Output (packed if packed is 1, row-major otherwise).
+ * @param packed 1 if in and out are interleaved, 0 if row-major.
+ * @param stride Distance (in elements) between two row-major matrices.
+ * @param matrix_K Three interleaved scratch matrices.
+ * @param res Array of count results (may be NULL).
+ */
+static void kk_batch_group(int n, size_t group, size_t count, const double *in, double *out, int packed, size_t stride, double *matrix_K[3], kk_result_t *res) {
+	int i, j, k, l, next = 0, prev = 1, curr = 2, tmp;
+	int divZero[W] = {0};
+	/* Offsets of a scratch matrix ((n + 1) * rs elements) overflow an int from n = 16383 */
+	size_t m, nn = (size_t) n * n, rs = (size_t) (n + 1) * W;
+	double *dst;
+
+	/* Transfer matrices (lanes past count are filled with identity) */
+	if(packed) {
+		for(i = 0; i < n; i++)
+			memcpy(&matrix_K[curr][i * rs], &in[(group * nn + i * n) * W], n * W * sizeof(double));
+	}
+	else {
+		for(l = 0; l < W; l++) {
+			m = group * W + l;
+			for(i = 0; i < n; i++)
+				for(j = 0; j < n; j++)
+					matrix_K[curr][i * rs + j * W + l] = (m < count)? in[m * stride + i * n + j] : ((i == j)? 1.0 : 0.0);
+		}
+	}
+	kk_batch_halo(matrix_K[curr], n, rs);
+
+	/* Divisor of first iteration is 1 */
+	for(m = 0; m < (n + 1) * rs; m++)
+		matrix_K[prev][m] = 1.0;
+
+	/* KK iterations, every vector operation updates W matrices */
+	for(k = 0; k < n - 1; k++) {
+		for(i = 0; i < n; i++) {
+			if(kk_kernels.iterate_row(&matrix_K[next][i * rs], &matrix_K[curr][i * rs], &matrix_K[curr][(i + 1) * rs], &matrix_K[prev][(i + 1) * rs], n * W, W))
+				kk_batch_flag(&matrix_K[prev][(i + 1) * rs + W], n, divZero);
+		}
+		kk_batch_halo(matrix_K[next], n, rs);
+
+		/* Refresh indexes */
+		tmp = prev;
+		prev = curr;
+		curr = next;
+		next = tmp;
+	}
+
+	/* Final iteration: element (i, j) of inverse is prev[j + 1][i + 1] / curr[i][j], stored in next */
+	for(i = 0; i < n; i++) {
+		for(j = 0; j < n; j++) {
+			if(kk_kernels.final_row(&matrix_K[next][i * rs + j * W], &matrix_K[prev][(j + 1) * rs + (i + 1) * W], 1, &matrix_K[curr][i * rs + j * W], W))
+				kk_batch_flag(&matrix_K[curr][i * rs + j * W], 1, divZero);
+		}
+	}
+
+	/* Transfer inverses */
+	if(packed) {
+		for(i = 0; i < n; i++)
+			memcpy(&out[(group * nn + i * n) * W], &matrix_K[next][i * rs], n * W * sizeof(double));
+	}
+	else {
+		for(l = 0; (l < W) && (group * W + l < count); l++) {
+			dst = &out[(group * W + l) * stride];
+			for(i = 0; i < n; i++)
+				for(j = 0; j < n; j++)
+					dst[i * n + j] = matrix_K[next][i * rs + j * W + l];
+		}
+	}
+
+	if(res) {
+		for(l = 0; (l < W) && (group * W + l < count); l++) {
+			res[group * W + l].det = matrix_K[curr][l];
+			res[group * W + l].divZero = divZero[l];
+			res[group * W + l].path = KK_PATH_KK;
+		}
+	}
+}
+
+/**
+ * @brief Invert a batch, group by group.
+ *
+ * @param n Size of matrices.
+ * @param count Number of matrices.
+ * @param in Input.
+ * @param out Output.
+ * @param packed 1 if in and out are interleaved, 0 if row-major.
+ * @param stride Distance (in elements) between two row-major matrices.
+ * @param ws Workspace.
+ * @param res Array of count results (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold the inversion.
+ */
+static int kk_batch_run(int n, size_t count, const double *in, double *out, int packed, size_t stride, kk_workspace_t *ws, kk_result_t *res) {
+	size_t g;
+	double *matrix_K[3];
+
+	if(kk_workspace_grow(ws, kk_batch_workspace_size(n)))
+		return -1;
+
+	matrix_K[0] = (double *) ws->mem;
+	matrix_K[1] = matrix_K[0] + (size_t) (n + 1) * (n + 1) * W;
+	matrix_K[2] = matrix_K[1] + (size_t) (n + 1) * (n + 1) * W;
+
+	for(g = 0; g * W < count; g++)
+		kk_batch_group(n, g, count, in, out, packed, stride, matrix_K, res);
+
+	return 0;
+}
+
+int kk_batch_invert_packed(int n, size_t count, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res) {
+	return kk_batch_run(n, count, in, out, 1, 0, ws, res);
+}
+
+int kk_batch_invert(int n, size_t count, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res) {
+	return kk_batch_run(n, count, in, out, 0, (size_t) n * n, ws, res);
+}
+
+int kk_batch_invert_strided(int n, size_t count, const double *in, double *out, size_t stride, kk_workspace_t *ws, kk_result_t *res) {
+	return kk_batch_run(n, count, in, out, 0, stride, ws, res);
+}
@@ -0,0 +1,125 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Batch Library)                 * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_BATCH_H
+#define KK_BATCH_H
+
+#include <stddef.h>
+
+#include "kk.h"
+
+/**
+ * @brief Number of matrices interleaved in a batch group (element (i, j) of all of them fills one vector).
+ */
+#define KK_BATCH_LANES 8
+
+/**
+ * @brief Return size of an interleaved (packed) batch.
+ *
+ * Packed layout stores groups of KK_BATCH_LANES matrices; element (i, j) of matrix (g * KK_BATCH_LANES + l)
+ * is at index ((g * n * n) + (i * n) + j) * KK_BATCH_LANES + l. Last group is padded with identity matrices.
+ *
+ * @param n Size of matrices.
+ * @param count Number of matrices.
+ *
+ * @return Size in bytes.
+ */
+size_t kk_batch_packed_size(int n, size_t count);
+
+/**
+ * @brief Pack row-major matrices into interleaved layout.
+ *
+ * @param n Size of matrices.
+ * @param count Number of matrices.
+ * @param in count consecutive n-by-n row-major matrices.
+ * @param packed Packed batch (see kk_batch_packed_size()).
+ */
+void kk_batch_pack(int n, size_t count, const double *in, double *packed);
+
+/**
+ * @brief Unpack interleaved layout into row-major matrices.
+ *
+ * @param n Size of matrices.
+ * @param count Number of matrices.
+ * @param packed Packed batch.
+ * @param out count consecutive n-by-n row-major matrices.
+ */
+void kk_batch_unpack(int n, size_t count, const double *packed, double *out);
+
+/**
+ * @brief Return scratch memory needed to invert a batch of n-by-n matrices.
+ *
+ * @param n Size of matrices.
+ *
+ * @return Size in bytes (independent of batch size).
+ */
+size_t kk_batch_workspace_size(int n);
+
+/**
+ * @brief Invert a batch of matrices stored in interleaved layout.
+ *
+ * @param n Size of matrices.
+ * @param count Number of matrices.
+ * @param in Packed input batch.
+ * @param out Packed output batch (may alias in).
+ * @param ws Workspace (pooled workspaces are grown as needed).
+ * @param res Array of count results (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold the inversion.
+ */
+int kk_batch_invert_packed(int n, size_t count, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res);
+
+/**
+ * @brief Invert a batch of row-major matrices (interleaved on the fly, one group at a time).
+ *
+ * @param n Size of matrices.
+ * @param count Number of matrices.
+ * @param in count consecutive n-by-n row-major matrices.
+ * @param out count consecutive n-by-n row-major matrices (may alias in).
+ * @param ws Workspace (pooled workspaces are grown as needed).
+ * @param res Array of count results (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold the inversion.
+ */
+int kk_batch_invert(int n, size_t count, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res);
+
+/**
+ * @brief Invert a batch of row-major matrices stored at a fixed distance from each other (padded records).
+ *
+ * @param n Size of matrices.
+ * @param count Number of matrices.
+ * @param in count n-by-n row-major matrices, stride elements apart.
+ * @param out count n-by-n row-major matrices, stride elements apart (may alias in).
+ * @param stride Distance (in elements) between two matrices (at least n * n).
+ * @param ws Workspace (pooled workspaces are grown as needed).
+ * @param res Array of count results (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold the inversion.
+ */
+int kk_batch_invert_strided(int n, size_t count, const double *in, double *out, size_t stride, kk_workspace_t *ws, kk_result_t *res);
+
+#endif
@@ -0,0 +1,1155 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Exact Integer Mode)            * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kk_exact.h"
+#include "kk_modular.h"
+
+typedef __int128 kk_i128_t;
+typedef unsigned __int128 kk_u128_t;
+
+/**
+ * @brief Drop leading zero limbs of a magnitude (little-endian 64-bit limbs).
+ *
+ * @param a Magnitude.
+ * @param la Number of limbs.
+ *
+ * @return Normalized number of limbs (0 for zero).
+ */
+static int kk_big_norm(const uint64_t *a, int la) {
+	while(la && !a[la - 1])
+		la--;
+
+	return la;
+}
+
+/**
+ * @brief Compare two magnitudes.
+ *
+ * @param a First magnitude.
+ * @param la Limbs of a.
+ * @param b Second magnitude.
+ * @param lb Limbs of b.
+ *
+ * @return Negative, zero or positive if a is less than, equal to or greater than b.
+ */
+static int kk_big_cmp(const uint64_t *a, int la, const uint64_t *b, int lb) {
+	int k;
+
+	if(la != lb)
+		return (la < lb)? -1 : 1;
+	for(k = la - 1; k >= 0; k--) {
+		if(a[k] != b[k])
+			return (a[k] < b[k])? -1 : 1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Multiply two magnitudes.
+ *
+ * @param r Product (la + lb limbs, must not alias a or b).
+ * @param a First magnitude.
+ * @param la Limbs of a.
+ * @param b Second magnitude.
+ * @param lb Limbs of b.
+ *
+ * @return Limbs of product.
+ */
+static int kk_big_mul(uint64_t *r, const uint64_t *a, int la, const uint64_t *b, int lb) {
+	int i, j;
+	kk_u128_t t;
+
+	if(!la || !lb)
+		return 0;
+
+	memset(r, 0, (size_t) (la + lb) * sizeof(uint64_t));
+	for(i = 0; i < la; i++) {
+		t = 0;
+		for(j = 0; j < lb; j++) {
+			t += (kk_u128_t) a[i] * b[j] + r[i + j];
+			r[i + j] = (uint64_t) t;
+			t >>= 64;
+		}
+		r[i + lb] = (uint64_t) t;
+	}
+
+	return kk_big_norm(r, la + lb);
+}
+
+/**
+ * @brief Add two magnitudes.
+ *
+ * @param r Sum (max(la, lb) + 1 limbs).
+ * @param a First magnitude.
+ * @param la Limbs of a.
+ * @param b Second magnitude.
+ * @param lb Limbs of b.
+ *
+ * @return Limbs of sum.
+ */
+static int kk_big_add(uint64_t *r, const uint64_t *a, int la, const uint64_t *b, int lb) {
+	int k;
+	kk_u128_t t = 0;
+
+	if(la < lb)
+		return kk_big_add(r, b, lb, a, la);
+
+	for(k = 0; k < la; k++) {
+		t += (kk_u128_t) a[k] + ((k < lb)? b[k] : 0);
+		r[k] = (uint64_t) t;
+		t >>= 64;
+	}
+	r[la] = (uint64_t) t;
+
+	return la + (int) t;
+}
+
+/**
+ * @brief Subtract two magnitudes (a must not be less than b).
+ *
+ * @param r Difference (la limbs).
+ * @param a First magnitude.
+ * @param la Limbs of a.
+ * @param b Second magnitude.
+ * @param lb Limbs of b.
+ *
+ * @return Limbs of difference.
+ */
+static int kk_big_sub(uint64_t *r, const uint64_t *a, int la, const uint64_t *b, int lb) {
+	int k;
+	kk_u128_t t;
+	uint64_t borrow = 0;
+
+	for(k = 0; k < la; k++) {
+		t = (kk_u128_t) a[k] - ((k < lb)? b[k] : 0) - borrow;
+		r[k] = (uint64_t) t;
+		borrow = (uint64_t) (t >> 127);
+	}
+
+	return kk_big_norm(r, la);
+}
+
+/**
+ * @brief Subtract two signed numbers (magnitude plus signed length, negative for negative numbers).
+ *
+ * @param r Difference magnitude (max(|sa|, |sb|) + 1 limbs).
+ * @param a First magnitude.
+ * @param sa Signed length of a.
+ * @param b Second magnitude.
+ * @param sb Signed length of b.
+ *
+ * @return Signed length of difference.
+ */
+static int kk_big_ssub(uint64_t *r, const uint64_t *a, int sa, const uint64_t *b, int sb) {
+	int la = abs(sa), lb = abs(sb), l;
+
+	if(!lb) {
+		memcpy(r, a, (size_t) la * sizeof(uint64_t));
+		return sa;
+	}
+	if(!la) {
+		memcpy(r, b, (size_t) lb * sizeof(uint64_t));
+		return -sb;
+	}
+
+	/* Opposite signs: magnitudes add up */
+	if((sa < 0) != (sb < 0)) {
+		l = kk_big_add(r, a, la, b, lb);
+		return (sa < 0)? -l : l;
+	}
+
+	if(kk_big_cmp(a, la, b, lb) >= 0) {
+		l = kk_big_sub(r, a, la, b, lb);
+		return (sa < 0)? -l : l;
+	}
+	l = kk_big_sub(r, b, lb, a, la);
+
+	return (sa < 0)? l : -l;
+}
+
+/**
+ * @brief Shift a magnitude right.
+ *
+ * @param r Shifted magnitude (may be a, or below a).
+ * @param a Magnitude.
+ * @param la Limbs of a.
+ * @param sh Shift (0 to 63 bits).
+ *
+ * @return Limbs of shifted magnitude.
+ */
+static int kk_big_shr(uint64_t *r, const uint64_t *a, int la, int sh) {
+	int k;
+
+	if(!sh) {
+		memmove(r, a, (size_t) la * sizeof(uint64_t));
+		return la;
+	}
+
+	for(k = 0; k < la - 1; k++)
+		r[k] = (a[k] >> sh) | (a[k + 1] << (64 - sh));
+	r[la - 1] = a[la - 1] >> sh;
+
+	return kk_big_norm(r, la);
+}
+
+/**
+ * @brief Divide two magnitudes, knowing that division is exact (KK divisions always are).
+ *
+ * Factors of two are removed from both, then quotient is found from the lowest limb up by multiplying
+ * by the inverse of divisor modulo 2^64, so no trial quotient or correction step is needed.
+ *
+ * @param q Quotient (la - lb + 1 limbs, must not alias a, b or t).
+ * @param a Dividend (destroyed).
+ * @param la Limbs of a.
+ * @param b Divisor (not zero).
+ * @param lb Limbs of b.
+ * @param t Scratch (lb limbs).
+ *
+ * @return Limbs of quotient.
+ */
+static int kk_big_divexact(uint64_t *q, uint64_t *a, int la, const uint64_t *b, int lb, uint64_t *t) {
+	int i, k, z, sh, lq;
+	uint64_t inv, qi, carry, borrow;
+	kk_u128_t prod, diff;
+
+	for(z = 0; !b[z]; z++);
+	sh = __builtin_ctzll(b[z]);
+	lb = kk_big_shr(t, b + z, lb - z, sh);
+	if(la <= z)
+		return 0;
+	la = kk_big_shr(a, a + z, la - z, sh);
+	if(la < lb)
+		return 0;
+
+	/* Inverse of t[0] (odd) modulo 2^64, Newton iteration doubles correct bits from three */
+	inv = t[0];
+	for(k = 0; k < 5; k++)
+		inv *= 2 - t[0] * inv;
+
+	lq = la - lb + 1;
+	for(i = 0; i < lq; i++) {
+		qi = a[i] * inv;
+		q[i] = qi;
+
+		/* a -= qi * t << (64 * i), which clears limb i */
+		carry = borrow = 0;
+		for(k = 0; k < lb; k++) {
+			prod = (kk_u128_t) qi * t[k] + carry;
+			carry = (uint64_t) (prod >> 64);
+			diff = (kk_u128_t) a[i + k] - (uint64_t) prod - borrow;
+			a[i + k] = (uint64_t) diff;
+			borrow = (uint64_t) (diff >> 127);
+		}
+		for(k += i; (k < la) && (carry || borrow); k++) {
+			diff = (kk_u128_t) a[k] - carry - borrow;
+			a[k] = (uint64_t) diff;
+			borrow = (uint64_t) (diff >> 127);
+			carry = 0;
+		}
+	}
+
+	return kk_big_norm(q, lq);
+}
+
+/**
+ * @brief Multiply a magnitude by a limb and add another one, in place.
+ *
+ * @param a Magnitude (room for la + 1 limbs).
+ * @param la Limbs of a.
+ * @param mul Factor.
+ * @param add Addend.
+ *
+ * @return Limbs of result.
+ */
+static int kk_big_muladd(uint64_t *a, int la, uint64_t mul, uint64_t add) {
+	int k;
+	kk_u128_t t = add;
+
+	for(k = 0; k < la; k++) {
+		t += (kk_u128_t) a[k] * mul;
+		a[k] = (uint64_t) t;
+		t >>= 64;
+	}
+	a[la] = (uint64_t) t;
+
+	return kk_big_norm(a, la + 1);
+}
+
+/**
+ * @brief Bits needed by any minor of a matrix (Hadamard bound plus margin for rounding).
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major matrix.
+ *
+ * @return Number of bits of magnitude.
+ */
+static int kk_exact_bound(int n, const int64_t *in) {
+	int i, j;
+	double norm, bits = 0;
+
+	/* A minor is bounded by the product of the norms of its rows, each one bounded by full row norm */
+	for(i = 0; i < n; i++) {
+		norm = 0;
+		for(j = 0; j < n; j++)
+			norm += (double) in[i * n + j] * (double) in[i * n + j];
+		if(norm > 1)
+			bits += 0.5 * log2(norm);
+	}
+
+	return (int) ceil(bits) + 2;
+}
+
+/**
+ * @brief Grow scratch memory, keeping its contents.
+ *
+ * @param ex Exact state.
+ * @param size Size in bytes.
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int kk_exact_grow(kk_exact_t *ex, size_t size) {
+	void *mem;
+
+	if(size <= ex->size)
+		return 0;
+
+	mem = realloc(ex->mem, size);
+	if(!mem)
+		return -1;
+	ex->mem = mem;
+	ex->size = size;
+
+	return 0;
+}
+
+/**
+ * @brief Get a multi-precision element (signed length on first word, then limbs).
+ *
+ * @param ex Exact state.
+ * @param m Register matrix.
+ * @param i Line index.
+ * @param j Column index.
+ *
+ * @return The element itself.
+ */
+static inline uint64_t *kk_exact_big(const kk_exact_t *ex, int m, int i, int j) {
+	int s = ex->n + 1;
+
+	return (uint64_t *) ex->mem + (((size_t) m * s + i) * s + j) * (ex->limbs + 1);
+}
+
+/**
+ * @brief Get signed length of a multi-precision element.
+ *
+ * @param e Element.
+ *
+ * @return Signed length (negative for negative numbers).
+ */
+static inline int kk_exact_len(const uint64_t *e) {
+	return (int) (int64_t) e[0];
+}
+
+/**
+ * @brief Calculate a block of rows and columns of next KK iteration on 64-bit integers.
+ *
+ * @param ex Exact state.
+ * @param next Next register matrix.
+ * @param rows Number of rows (n, or 1 for determinant only).
+ * @param cols Number of columns (n, or 1 for determinant only).
+ *
+ * @return 0 on success, -1 on overflow.
+ */
+static int kk_exact_rows_64(kk_exact_t *ex, int next, int rows, int cols) {
+	int i, j, n = ex->n, s = n + 1;
+	int64_t *m = ex->mem, *x, *c0, *c1, *p1;
+	int64_t a, b, d;
+
+	for(i = 0; i < rows; i++) {
+		x = m + ((size_t) next * s + i) * s;
+		c0 = m + ((size_t) ex->curr * s + i) * s;
+		c1 = c0 + s;
+		p1 = m + ((size_t) ex->prev * s + i + 1) * s;
+
+		for(j = 0; j < cols; j++) {
+			if(__builtin_mul_overflow(c0[j], c1[j + 1], &a) || __builtin_mul_overflow(c1[j], c0[j + 1], &b) || __builtin_sub_overflow(a, b, &d))
+				return -1;
+			if(!p1[j + 1]) {
+				ex->divZero = 1;
+				x[j] = 0;
+			}
+			else if((INT64_MIN == d) && (-1 == p1[j + 1])) {
+				return -1;
+			}
+			else {
+				x[j] = d / p1[j + 1];
+			}
+		}
+		if(cols == n)
+			x[n] = x[0];
+	}
+	if(rows == n)
+		memcpy(m + ((size_t) next * s + n) * s, m + (size_t) next * s * s, s * sizeof(int64_t));
+
+	return 0;
+}
+
+/**
+ * @brief Calculate a block of rows and columns of next KK iteration on 128-bit integers.
+ *
+ * @param ex Exact state.
+ * @param next Next register matrix.
+ * @param rows Number of rows (n, or 1 for determinant only).
+ * @param cols Number of columns (n, or 1 for determinant only).
+ *
+ * @return 0 on success, -1 on overflow.
+ */
+static int kk_exact_rows_128(kk_exact_t *ex, int next, int rows, int cols) {
+	int i, j, n = ex->n, s = n + 1;
+	kk_i128_t *m = ex->mem, *x, *c0, *c1, *p1;
+	kk_i128_t a, b, d, min = (kk_i128_t) ((kk_u128_t) 1 << 127);
+
+	for(i = 0; i < rows; i++) {
+		x = m + ((size_t) next * s + i) * s;
+		c0 = m + ((size_t) ex->curr * s + i) * s;
+		c1 = c0 + s;
+		p1 = m + ((size_t) ex->prev * s + i + 1) * s;
+
+		for(j = 0; j < cols; j++) {
+			if(__builtin_mul_overflow(c0[j], c1[j + 1], &a) || __builtin_mul_overflow(c1[j], c0[j + 1], &b) || __builtin_sub_overflow(a, b, &d))
+				return -1;
+			if(!p1[j + 1]) {
+				ex->divZero = 1;
+				x[j] = 0;
+			}
+			else if((min == d) && (-1 == p1[j + 1])) {
+				return -1;
+			}
+			else {
+				x[j] = d / p1[j + 1];
+			}
+		}
+		if(cols == n)
+			x[n] = x[0];
+	}
+	if(rows == n)
+		memcpy(m + ((size_t) next * s + n) * s, m + (size_t) next * s * s, s * sizeof(kk_i128_t));
+
+	return 0;
+}
+
+/**
+ * @brief Calculate a block of rows and columns of next KK iteration on multi-precision integers.
+ *
+ * @param ex Exact state.
+ * @param next Next register matrix.
+ * @param rows Number of rows (n, or 1 for determinant only).
+ * @param cols Number of columns (n, or 1 for determinant only).
+ */
+static void kk_exact_rows_big(kk_exact_t *ex, int next, int rows, int cols) {
+	int i, j, n = ex->n, l = ex->limbs, w = l + 1;
+	int s1, s2, s3, sp, lq;
+	uint64_t *a, *b, *c, *d, *p, *x;
+	/* Temporaries after register matrices: two products, their difference, shifted divisor */
+	uint64_t *t1 = kk_exact_big(ex, 3, 0, 0), *t2 = t1 + 2 * l + 2, *t3 = t2 + 2 * l + 2, *tb = t3 + 2 * l + 2;
+
+	for(i = 0; i < rows; i++) {
+		for(j = 0; j < cols; j++) {
+			a = kk_exact_big(ex, ex->curr, i, j);
+			b = kk_exact_big(ex, ex->curr, i + 1, j);
+			c = kk_exact_big(ex, ex->curr, i, j + 1);
+			d = kk_exact_big(ex, ex->curr, i + 1, j + 1);
+			p = kk_exact_big(ex, ex->prev, i + 1, j + 1);
+			x = kk_exact_big(ex, next, i, j);
+
+			s1 = kk_big_mul(t1, a + 1, abs(kk_exact_len(a)), d + 1, abs(kk_exact_len(d)));
+			s1 = ((kk_exact_len(a) < 0) != (kk_exact_len(d) < 0))? -s1 : s1;
+			s2 = kk_big_mul(t2, b + 1, abs(kk_exact_len(b)), c + 1, abs(kk_exact_len(c)));
+			s2 = ((kk_exact_len(b) < 0) != (kk_exact_len(c) < 0))? -s2 : s2;
+			s3 = kk_big_ssub(t3, t1, s1, t2, s2);
+
+			sp = kk_exact_len(p);
+			if(!sp) {
+				ex->divZero = 1;
+				x[0] = 0;
+				continue;
+			}
+
+			/* Quotient is a minor, so it fits in l limbs (Hadamard bound), unless an earlier division by
+			 * zero broke exactness */
+			lq = kk_big_divexact(t1, t3, abs(s3), p + 1, abs(sp), tb);
+			if(lq > l) {
+				ex->divZero = 1;
+				x[0] = 0;
+				continue;
+			}
+			memcpy(x + 1, t1, (size_t) lq * sizeof(uint64_t));
+			x[0] = (uint64_t) (((s3 < 0) != (sp < 0))? -lq : lq);
+		}
+		if(cols == n)
+			memcpy(kk_exact_big(ex, next, i, n), kk_exact_big(ex, next, i, 0), (size_t) w * sizeof(uint64_t));
+	}
+	if(rows == n)
+		memcpy(kk_exact_big(ex, next, n, 0), kk_exact_big(ex, next, 0, 0), (size_t) (n + 1) * w * sizeof(uint64_t));
+}
+
+/**
+ * @brief Calculate a block of rows and columns of next KK iteration at current width.
+ *
+ * @param ex Exact state.
+ * @param next Next register matrix.
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ *
+ * @return 0 on success, -1 on overflow (width must be increased).
+ */
+static int kk_exact_rows(kk_exact_t *ex, int next, int rows, int cols) {
+	switch(ex->width) {
+		case KK_EXACT_64:
+			return kk_exact_rows_64(ex, next, rows, cols);
+		case KK_EXACT_128:
+			return kk_exact_rows_128(ex, next, rows, cols);
+		default:
+			kk_exact_rows_big(ex, next, rows, cols);
+			return 0;
+	}
+}
+
+/**
+ * @brief Widen register matrices to next width, in place (previous and current ones are kept).
+ *
+ * Elements are converted from last to first, so that no wider element overwrites a narrower one not
+ * yet converted.
+ *
+ * @param ex Exact state.
+ * @param in Input matrix (sizes multi-precision elements).
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+static int kk_exact_widen(kk_exact_t *ex, const int64_t *in) {
+	int k, s = ex->n + 1, next = 3 - ex->prev - ex->curr;
+	size_t e, w, area = (size_t) s * s;
+	int64_t v64;
+	kk_i128_t v128;
+	kk_u128_t u;
+	uint64_t big[3];
+
+	if(KK_EXACT_64 == ex->width) {
+		if(kk_exact_grow(ex, 3 * area * sizeof(kk_i128_t)))
+			return -1;
+
+		for(e = 3 * area; e-- > 0;) {
+			memcpy(&v64, (int64_t *) ex->mem + e, sizeof(v64));
+			v128 = ((int) (e / area) == next)? 0 : v64;
+			memcpy((kk_i128_t *) ex->mem + e, &v128, sizeof(v128));
+		}
+		ex->width = KK_EXACT_128;
+
+		return 0;
+	}
+
+	/* At least two limbs, so that any 128-bit element fits */
+	ex->limbs = kk_exact_bound(ex->n, in) / 64 + 1;
+	if(ex->limbs < 2)
+		ex->limbs = 2;
+	w = ex->limbs + 1;
+	if(kk_exact_grow(ex, (3 * area * w + 7 * ex->limbs + 6) * sizeof(uint64_t)))
+		return -1;
+
+	for(e = 3 * area; e-- > 0;) {
+		memcpy(&v128, (kk_i128_t *) ex->mem + e, sizeof(v128));
+		if((int) (e / area) == next)
+			v128 = 0;
+		u = (v128 < 0)? -(kk_u128_t) v128 : (kk_u128_t) v128;
+		big[1] = (uint64_t) u;
+		big[2] = (uint64_t) (u >> 64);
+		k = kk_big_norm(big + 1, 2);
+		big[0] = (uint64_t) ((v128 < 0)? -k : k);
+		memcpy((uint64_t *) ex->mem + e * w, big, sizeof(big));
+	}
+	ex->width = KK_EXACT_BIG;
+
+	return 0;
+}
+
+/**
+ * @brief Load a result element as a magnitude.
+ *
+ * @param ex Exact state.
+ * @param m Register matrix.
+ * @param i Line index.
+ * @param j Column index.
+ * @param buf Room for magnitude of 64- and 128-bit elements (2 limbs).
+ * @param len Signed length of magnitude.
+ *
+ * @return Magnitude.
+ */
+static const uint64_t *kk_exact_load(const kk_exact_t *ex, int m, int i, int j, uint64_t *buf, int *len) {
+	int k, s = ex->n + 1;
+	size_t e = ((size_t) m * s + i) * s + j;
+	kk_i128_t v;
+	kk_u128_t u;
+	const uint64_t *big;
+
+	if(KK_EXACT_BIG == ex->width) {
+		big = kk_exact_big(ex, m, i, j);
+		*len = kk_exact_len(big);
+		return big + 1;
+	}
+
+	v = (KK_EXACT_64 == ex->width)? ((const int64_t *) ex->mem)[e] : ((const kk_i128_t *) ex->mem)[e];
+	u = (v < 0)? -(kk_u128_t) v : (kk_u128_t) v;
+	buf[0] = (uint64_t) u;
+	buf[1] = (uint64_t) (u >> 64);
+	k = kk_big_norm(buf, 2);
+	*len = (v < 0)? -k : k;
+
+	return buf;
+}
+
+/**
+ * @brief Load an adjugate element as a magnitude.
+ *
+ * Element (i, j) of last KK matrix is the determinant with rows and columns rotated by i and j, so
+ * adjugate is read from the previous one with sign (-1)^((n-1)(i+j)).
+ *
+ * @param ex Exact state.
+ * @param i Line index.
+ * @param j Column index.
+ * @param buf Room for magnitude of 64- and 128-bit elements (2 limbs).
+ * @param len Signed length of magnitude.
+ *
+ * @return Magnitude.
+ */
+static const uint64_t *kk_exact_load_adj(const kk_exact_t *ex, int i, int j, uint64_t *buf, int *len) {
+	const uint64_t *mag = kk_exact_load(ex, ex->prev, j + 1, i + 1, buf, len);
+
+	if(((ex->n - 1) * (i + j)) % 2)
+		*len = -*len;
+
+	return mag;
+}
+
+/**
+ * @brief Convert a magnitude to a 64-bit integer.
+ *
+ * @param mag Magnitude.
+ * @param len Signed length.
+ * @param v Value.
+ *
+ * @return 0 on success, -1 if it does not fit.
+ */
+static int kk_exact_to_i64(const uint64_t *mag, int len, int64_t *v) {
+	uint64_t u;
+
+	if(abs(len) > 1)
+		return -1;
+	u = len? mag[0] : 0;
+	if(u > ((len < 0)? (uint64_t) INT64_MAX + 1 : (uint64_t) INT64_MAX))
+		return -1;
+	*v = (len < 0)? (int64_t) (0 - u) : (int64_t) u;
+
+	return 0;
+}
+
+/**
+ * @brief Format a magnitude as a decimal string.
+ *
+ * @param mag Magnitude.
+ * @param len Signed length.
+ * @param buf Output buffer.
+ * @param size Size of output buffer.
+ *
+ * @return Length of string, -1 if buffer is too small or memory could not be allocated.
+ */
+static int kk_exact_format(const uint64_t *mag, int len, char *buf, size_t size) {
+	int k, d, l = abs(len), pos = 0;
+	kk_u128_t r;
+	/* Copy of magnitude, then digits (least significant first, at most twenty per limb) */
+	uint64_t *t = malloc((size_t) (l + 1) * sizeof(uint64_t) + (size_t) (l + 1) * 20);
+	char *digits = (char *) (t + l + 1);
+
+	if(!t)
+		return -1;
+	memcpy(t, mag, (size_t) l * sizeof(uint64_t));
+
+	/* Nineteen digits at a time (fewer on most significant group) */
+	do {
+		r = 0;
+		for(k = l - 1; k >= 0; k--) {
+			r = (r << 64) | t[k];
+			t[k] = (uint64_t) (r / 10000000000000000000ull);
+			r %= 10000000000000000000ull;
+		}
+		l = kk_big_norm(t, l);
+		for(d = 0; (d < 19) && (l || r); d++) {
+			digits[pos++] = '0' + (char) (r % 10);
+			r /= 10;
+		}
+	} while(l);
+	if(!pos)
+		digits[pos++] = '0';
+	if(len < 0)
+		digits[pos++] = '-';
+
+	if((size_t) pos >= size) {
+		free(t);
+		return -1;
+	}
+	for(k = 0; k < pos; k++)
+		buf[k] = digits[pos - 1 - k];
+	buf[pos] = '\0';
+	free(t);
+
+	return pos;
+}
+
+/**
+ * @brief Get leading bits of a magnitude.
+ *
+ * @param mag Magnitude.
+ * @param len Signed length.
+ * @param exp Power of two to scale result with.
+ *
+ * @return Leading (up to 128) bits, signed.
+ */
+static long double kk_exact_lead(const uint64_t *mag, int len, int *exp) {
+	int k, l = abs(len), lo = (l > 2)? l - 2 : 0;
+	long double v = 0;
+
+	for(k = l - 1; k >= lo; k--)
+		v = v * 18446744073709551616.0L + mag[k];
+	*exp = 64 * lo;
+
+	return (len < 0)? -v : v;
+}
+
+/**
+ * @brief Elements rebuilt per reconstruction task (their residues under every prime stay in cache).
+ */
+#define KK_EXACT_CRT_CHUNK 256
+
+/**
+ * @brief Shared state of a multi-modular inversion.
+ */
+typedef struct {
+	/* Input */
+	int n;
+	const int64_t *in;
+	/* Exact state receiving results */
+	kk_exact_t *ex;
+
+	/* Constants of primes (room for cap primes) */
+	kk_mont_t *mont;
+	int cap;
+	/* First prime of current round */
+	int base;
+	/* Residues: per prime, n * n minors of order n - 1 then determinant */
+	uint32_t *res;
+	size_t stride;
+	/* Lanes with a zero divisor, per group of current round */
+	unsigned *bad;
+	/* Per-worker scratch of residue runs */
+	void **scratch;
+
+	/* Primes in use for reconstruction */
+	int count;
+	/* Garner constants: element (i, j), j < i, is p_j^-1 mod p_i in Montgomery form */
+	uint32_t *garner;
+	/* Product of primes, and half of it */
+	uint64_t *prod, *half;
+	int lprod, lhalf;
+	/* Per-worker room for one rebuilt element */
+	uint64_t **acc;
+} kk_exact_crt_t;
+
+/**
+ * @brief Pool task: residue run of a group of primes.
+ *
+ * @param arg Shared state.
+ * @param index Group index within current round.
+ * @param worker Worker index.
+ */
+static void kk_exact_crt_run(void *arg, int index, int worker) {
+	kk_exact_crt_t *crt = arg;
+	int first = crt->base + index * KK_MODULAR_LANES;
+
+	crt->bad[index] = kk_modular_run(crt->n, crt->in, crt->mont + first, crt->res + first * crt->stride, crt->stride, crt->scratch[worker]);
+}
+
+/**
+ * @brief Turn residues of a chunk of elements into mixed-radix digits (Garner), in place.
+ *
+ * Digit i is ((r_i - d_0) / p_0 - d_1) / p_1 ... - d_(i-1)) / p_(i-1) mod p_i, with every division a
+ * product by a precomputed inverse; elements are innermost, so the loop runs across SIMD lanes.
+ *
+ * @param crt Shared state.
+ * @param lo First element.
+ * @param hi One past last element.
+ */
+KK_MODULAR_CLONES static void kk_exact_crt_garner(kk_exact_crt_t *crt, int lo, int hi) {
+	int i, j, e;
+	uint32_t c, v, p, q, *ri;
+	const uint32_t *rj;
+
+	for(i = 1; i < crt->count; i++) {
+		p = crt->mont[i].p;
+		q = crt->mont[i].q;
+		ri = crt->res + i * crt->stride;
+
+		for(j = 0; j < i; j++) {
+			c = crt->garner[i * crt->count + j];
+			rj = crt->res + j * crt->stride;
+			for(e = lo; e < hi; e++) {
+				/* Digits of larger primes are below 2p */
+				v = (rj[e] >= p)? rj[e] - p : rj[e];
+				ri[e] = kk_mont_mul(kk_mont_sub(ri[e], v, p), c, p, q);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Store a rebuilt element on exact state (halo included).
+ *
+ * @param ex Exact state.
+ * @param e Element (i * n + j of minors of order n - 1, n * n for determinant).
+ * @param mag Magnitude.
+ * @param len Signed length.
+ */
+static void kk_exact_crt_store(kk_exact_t *ex, int e, const uint64_t *mag, int len) {
+	int n = ex->n, i = e / n, j = e % n, c;
+	/* Element itself, then its halo copies (row n mirrors row 0, column n mirrors column 0) */
+	uint64_t *x[4] = {NULL, NULL, NULL, NULL};
+
+	if(n * n == e) {
+		x[0] = kk_exact_big(ex, ex->curr, 0, 0);
+	}
+	else {
+		x[0] = kk_exact_big(ex, ex->prev, i, j);
+		x[1] = i? NULL : kk_exact_big(ex, ex->prev, n, j);
+		x[2] = j? NULL : kk_exact_big(ex, ex->prev, i, n);
+		x[3] = (i || j)? NULL : kk_exact_big(ex, ex->prev, n, n);
+	}
+
+	/* Only possible without exactness (a minor that is zero modulo every prime of a round) */
+	if(abs(len) > ex->limbs)
+		len = 0;
+
+	for(c = 0; c < 4; c++) {
+		if(x[c]) {
+			x[c][0] = (uint64_t) len;
+			memcpy(x[c] + 1, mag, (size_t) abs(len) * sizeof(uint64_t));
+		}
+	}
+}
+
+/**
+ * @brief Pool task: rebuild a chunk of elements from their residues.
+ *
+ * @param arg Shared state.
+ * @param index Chunk index.
+ * @param worker Worker index.
+ */
+static void kk_exact_crt_rebuild(void *arg, int index, int worker) {
+	kk_exact_crt_t *crt = arg;
+	int i, e, len, lo = index * KK_EXACT_CRT_CHUNK, hi = lo + KK_EXACT_CRT_CHUNK;
+	uint64_t *acc = crt->acc[worker];
+
+	if(hi > crt->n * crt->n + 1)
+		hi = crt->n * crt->n + 1;
+
+	kk_exact_crt_garner(crt, lo, hi);
+
+	for(e = lo; e < hi; e++) {
+		/* Horner on mixed-radix digits: d_0 + p_0 (d_1 + p_1 (d_2 + ...)) */
+		acc[0] = crt->res[(crt->count - 1) * crt->stride + e];
+		len = kk_big_norm(acc, 1);
+		for(i = crt->count - 2; i >= 0; i--)
+			len = kk_big_muladd(acc, len, crt->mont[i].p, crt->res[i * crt->stride + e]);
+
+		/* Symmetric range: values above half of the product are negative */
+		if(kk_big_cmp(acc, len, crt->half, crt->lhalf) > 0)
+			len = -kk_big_sub(acc, crt->prod, crt->lprod, acc, len);
+
+		kk_exact_crt_store(crt->ex, e, acc, len);
+	}
+}
+
+/**
+ * @brief Release memory of a multi-modular inversion.
+ *
+ * @param crt Shared state.
+ * @param threads Number of workers.
+ */
+static void kk_exact_crt_free(kk_exact_crt_t *crt, int threads) {
+	int t;
+
+	for(t = 0; t < threads; t++) {
+		if(crt->scratch)
+			free(crt->scratch[t]);
+		if(crt->acc)
+			free(crt->acc[t]);
+	}
+	free(crt->acc);
+	free(crt->scratch);
+	free(crt->prod);
+	free(crt->garner);
+	free(crt->bad);
+	free(crt->res);
+	free(crt->mont);
+}
+
+void kk_exact_init(kk_exact_t *ex) {
+	memset(ex, 0, sizeof(*ex));
+}
+
+void kk_exact_free(kk_exact_t *ex) {
+	free(ex->mem);
+	kk_exact_init(ex);
+}
+
+int kk_exact_invert(int n, const int64_t *in, kk_exact_t *ex) {
+	int i, j, k, s = n + 1, next, last;
+	int64_t *m;
+
+	if(kk_exact_grow(ex, (size_t) 3 * s * s * sizeof(int64_t)))
+		return -1;
+
+	ex->n = n;
+	ex->width = KK_EXACT_64;
+	ex->limbs = 0;
+	ex->prev = 0;
+	ex->curr = 1;
+	ex->divZero = 0;
+
+	/* Ones on previous register, input (with halo) on current one */
+	m = ex->mem;
+	for(i = 0; i < s; i++) {
+		for(j = 0; j < s; j++) {
+			m[i * s + j] = 1;
+			m[(s + i) * s + j] = in[(i % n) * n + (j % n)];
+		}
+	}
+
+	for(k = 0; k < n - 1; k++) {
+		next = 3 - ex->prev - ex->curr;
+		/* Last iteration only needs determinant (the rest are rotations of it) */
+		last = (n - 2 == k);
+
+		while(kk_exact_rows(ex, next, last? 1 : n, last? 1 : n)) {
+			if(kk_exact_widen(ex, in))
+				return -1;
+		}
+
+		ex->prev = ex->curr;
+		ex->curr = next;
+	}
+
+	return 0;
+}
+
+size_t kk_exact_digits(const kk_exact_t *ex) {
+	int bits = (KK_EXACT_BIG == ex->width)? 64 * ex->limbs : ((KK_EXACT_128 == ex->width)? 128 : 64);
+
+	/* Digits plus sign and terminator (log10(2) < 0.30103) */
+	return (size_t) (bits * 0.30103) + 3;
+}
+
+int kk_exact_det_i64(const kk_exact_t *ex, int64_t *det) {
+	int len;
+	uint64_t buf[2];
+	const uint64_t *mag = kk_exact_load(ex, ex->curr, 0, 0, buf, &len);
+
+	return kk_exact_to_i64(mag, len, det);
+}
+
+int kk_exact_adj_i64(const kk_exact_t *ex, int i, int j, int64_t *adj) {
+	int len;
+	uint64_t buf[2];
+	const uint64_t *mag = kk_exact_load_adj(ex, i, j, buf, &len);
+
+	return kk_exact_to_i64(mag, len, adj);
+}
+
+int kk_exact_det_str(const kk_exact_t *ex, char *buf, size_t size) {
+	int len;
+	uint64_t tmp[2];
+	const uint64_t *mag = kk_exact_load(ex, ex->curr, 0, 0, tmp, &len);
+
+	return kk_exact_format(mag, len, buf, size);
+}
+
+int kk_exact_adj_str(const kk_exact_t *ex, int i, int j, char *buf, size_t size) {
+	int len;
+	uint64_t tmp[2];
+	const uint64_t *mag = kk_exact_load_adj(ex, i, j, tmp, &len);
+
+	return kk_exact_format(mag, len, buf, size);
+}
+
+void kk_exact_inverse(const kk_exact_t *ex, double *out) {
+	int i, j, len, eDet, eAdj, n = ex->n;
+	uint64_t buf[2];
+	const uint64_t *mag = kk_exact_load(ex, ex->curr, 0, 0, buf, &len);
+	long double det = kk_exact_lead(mag, len, &eDet), adj;
+
+	for(i = 0; i < n; i++) {
+		for(j = 0; j < n; j++) {
+			mag = kk_exact_load_adj(ex, i, j, buf, &len);
+			adj = kk_exact_lead(mag, len, &eAdj);
+			out[i * n + j] = (double) ldexpl(adj / det, eAdj - eDet);
+		}
+	}
+}
+
+int kk_exact_invert_modular(int n, const int64_t *in, kk_exact_t *ex, kk_pool_t *pool) {
+	int i, j, l, g, groups, need, good, ok = -1, threads = pool? kk_pool_threads(pool) : 1;
+	int bits = kk_exact_bound(n, in), s = n + 1;
+	uint32_t prime = (uint32_t) 1 << 31, x;
+	kk_exact_crt_t crt;
+
+	memset(&crt, 0, sizeof(crt));
+	crt.n = n;
+	crt.in = in;
+	crt.ex = ex;
+	crt.stride = (size_t) n * n + 1;
+
+	/* Primes are above 2^30, product must exceed twice any minor (sign) */
+	need = (bits + 1) / 30 + 1;
+
+	ex->n = n;
+	ex->width = KK_EXACT_BIG;
+	ex->limbs = (bits / 64 + 1 < 2)? 2 : bits / 64 + 1;
+	ex->prev = 0;
+	ex->curr = 1;
+	ex->divZero = 0;
+	if(kk_exact_grow(ex, ((size_t) 3 * s * s * (ex->limbs + 1) + 7 * ex->limbs + 6) * sizeof(uint64_t)))
+		return -1;
+
+	/* Every round ends before need + KK_MODULAR_LANES primes (good ones are packed at the beginning) */
+	crt.cap = need + KK_MODULAR_LANES;
+	crt.mont = malloc(crt.cap * sizeof(kk_mont_t));
+	crt.res = malloc(crt.cap * crt.stride * sizeof(uint32_t));
+	crt.bad = malloc(crt.cap / KK_MODULAR_LANES * sizeof(unsigned));
+	crt.scratch = calloc(threads, sizeof(void *));
+	crt.acc = calloc(threads, sizeof(uint64_t *));
+	if(!crt.mont || !crt.res || !crt.bad || !crt.scratch || !crt.acc)
+		goto out;
+	for(i = 0; i < threads; i++) {
+		if(posix_memalign(&crt.scratch[i], 64, kk_modular_size(n)))
+			goto out;
+	}
+
+	/* Rounds of residue runs, until enough primes went through with no zero divisor */
+	for(good = 0; good < need;) {
+		groups = (need - good + KK_MODULAR_LANES - 1) / KK_MODULAR_LANES;
+		for(i = 0; i < groups * KK_MODULAR_LANES; i++) {
+			prime = kk_modular_prime(prime);
+			crt.mont[good + i] = kk_mont_init(prime);
+		}
+
+		crt.base = good;
+		if(pool)
+			kk_pool_for(pool, groups, kk_exact_crt_run, &crt);
+		else
+			for(g = 0; g < groups; g++)
+				kk_exact_crt_run(&crt, g, 0);
+
+		/* Keep primes whose lanes did not divide by zero */
+		i = good;
+		for(g = 0; g < groups; g++) {
+			for(l = 0; l < KK_MODULAR_LANES; l++) {
+				j = crt.base + g * KK_MODULAR_LANES + l;
+				if((crt.bad[g] >> l) & 1)
+					continue;
+				crt.mont[good] = crt.mont[j];
+				memmove(crt.res + good * crt.stride, crt.res + j * crt.stride, crt.stride * sizeof(uint32_t));
+				good++;
+			}
+		}
+		if(good == i) {
+			/* Zero divisor under every prime: a minor is zero */
+			ex->divZero = 1;
+			break;
+		}
+	}
+	/* Surplus good primes of last round are not needed */
+	crt.count = (good < need)? good : need;
+
+	if(ex->divZero) {
+		/* Results are undefined, leave them zero */
+		for(i = 0; i < s; i++) {
+			for(j = 0; j < s; j++)
+				kk_exact_big(ex, ex->prev, i, j)[0] = 0;
+		}
+		kk_exact_big(ex, ex->curr, 0, 0)[0] = 0;
+		ok = 0;
+		goto out;
+	}
+
+	/* Garner constants, product of primes and half of it */
+	crt.garner = malloc((size_t) crt.count * crt.count * sizeof(uint32_t));
+	crt.prod = malloc((size_t) 2 * (crt.count / 2 + 2) * sizeof(uint64_t));
+	if(!crt.garner || !crt.prod)
+		goto out;
+	crt.half = crt.prod + crt.count / 2 + 2;
+	for(i = 0; i < crt.count; i++) {
+		for(j = 0; j < i; j++) {
+			x = crt.mont[j].p % crt.mont[i].p;
+			crt.garner[i * crt.count + j] = kk_mont_inv(kk_mont_mul(x, crt.mont[i].r2, crt.mont[i].p, crt.mont[i].q), crt.mont[i]);
+		}
+	}
+	crt.prod[0] = 1;
+	crt.lprod = 1;
+	for(i = 0; i < crt.count; i++)
+		crt.lprod = kk_big_muladd(crt.prod, crt.lprod, crt.mont[i].p, 0);
+	crt.lhalf = kk_big_shr(crt.half, crt.prod, crt.lprod, 1);
+
+	for(i = 0; i < threads; i++) {
+		crt.acc[i] = malloc((size_t) (crt.lprod + 1) * sizeof(uint64_t));
+		if(!crt.acc[i])
+			goto out;
+	}
+
+	g = (n * n + KK_EXACT_CRT_CHUNK) / KK_EXACT_CRT_CHUNK;
+	if(pool)
+		kk_pool_for(pool, g, kk_exact_crt_rebuild, &crt);
+	else
+		for(i = 0; i < g; i++)
+			kk_exact_crt_rebuild(&crt, i, 0);
+	ok = 0;
+
+out:
+	kk_exact_crt_free(&crt, threads);
+
+	return ok;
+}
@@ -0,0 +1,182 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Exact Integer Mode)            * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_EXACT_H
+#define KK_EXACT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "kk_pool.h"
+
+/**
+ * @brief Integer width of exact KK iterations.
+ *
+ * Every KK element is a contiguous minor of the input matrix, so for integer input all divisions are
+ * exact. Iterations start on 64-bit integers and are widened (only) when a product or difference
+ * overflows: first to 128 bits, then to multi-precision integers sized by the Hadamard bound.
+ */
+typedef enum {
+	KK_EXACT_64 = 0,
+	KK_EXACT_128,
+	KK_EXACT_BIG
+} kk_exact_width_t;
+
+/**
+ * @brief Exact KK state: scratchpad (pooled, only grows) plus results of last inversion.
+ *
+ * A state must not be shared between concurrent inversions.
+ */
+typedef struct {
+	/* Scratch memory (register matrices, then multi-precision temporaries) */
+	void *mem;
+	/* Size of scratch memory in bytes */
+	size_t size;
+
+	/* Size of matrix */
+	int n;
+	/* Width of elements in use (that of results) */
+	kk_exact_width_t width;
+	/* 64-bit limbs per element when width is KK_EXACT_BIG */
+	int limbs;
+	/* Indexes for previous and current register matrices */
+	int prev, curr;
+	/* Division by zero flag (results are undefined if set) */
+	int divZero;
+} kk_exact_t;
+
+/**
+ * @brief Initialise an empty exact state.
+ *
+ * @param ex Exact state.
+ */
+void kk_exact_init(kk_exact_t *ex);
+
+/**
+ * @brief Release scratch memory of an exact state.
+ *
+ * @param ex Exact state.
+ */
+void kk_exact_free(kk_exact_t *ex);
+
+/**
+ * @brief Compute determinant and adjugate of an integer matrix with no rounding.
+ *
+ * Adjugate is read (with cyclic signs) from the (n-1)-by-(n-1) minors of the KK iterations, so the
+ * final division is not needed and singular matrices are fine as long as no division by zero occurs
+ * in the iterations (flagged in ex->divZero).
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param ex Exact state (holds results until next call).
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int kk_exact_invert(int n, const int64_t *in, kk_exact_t *ex);
+
+/**
+ * @brief Same as kk_exact_invert(), computed modulo many 31-bit primes and rebuilt by Chinese remainders.
+ *
+ * Residue runs need no multi-precision arithmetic and are independent: KK_MODULAR_LANES primes run
+ * together across SIMD lanes, and groups of primes run on pool workers. Enough primes are used to
+ * cover the Hadamard bound; primes dividing some KK divisor are replaced. A zero divisor under every
+ * prime is a zero minor (flagged in ex->divZero, as kk_exact_invert() does).
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param ex Exact state (holds results until next call).
+ * @param pool Pool running residue runs and reconstruction (NULL to run on calling thread).
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int kk_exact_invert_modular(int n, const int64_t *in, kk_exact_t *ex, kk_pool_t *pool);
+
+/**
+ * @brief Return buffer size (including terminator) that fits any result of kk_exact_det_str() or
+ * kk_exact_adj_str().
+ *
+ * @param ex Exact state (after kk_exact_invert()).
+ *
+ * @return Size in bytes.
+ */
+size_t kk_exact_digits(const kk_exact_t *ex);
+
+/**
+ * @brief Get determinant as a 64-bit integer.
+ *
+ * @param ex Exact state (after kk_exact_invert()).
+ * @param det Determinant.
+ *
+ * @return 0 on success, -1 if it does not fit.
+ */
+int kk_exact_det_i64(const kk_exact_t *ex, int64_t *det);
+
+/**
+ * @brief Get adjugate element as a 64-bit integer.
+ *
+ * @param ex Exact state (after kk_exact_invert()).
+ * @param i Line index.
+ * @param j Column index.
+ * @param adj Adjugate element.
+ *
+ * @return 0 on success, -1 if it does not fit.
+ */
+int kk_exact_adj_i64(const kk_exact_t *ex, int i, int j, int64_t *adj);
+
+/**
+ * @brief Get determinant as a decimal string.
+ *
+ * @param ex Exact state (after kk_exact_invert()).
+ * @param buf Output buffer.
+ * @param size Size of output buffer (see kk_exact_digits()).
+ *
+ * @return Length of string, -1 if buffer is too small or memory could not be allocated.
+ */
+int kk_exact_det_str(const kk_exact_t *ex, char *buf, size_t size);
+
+/**
+ * @brief Get adjugate element as a decimal string.
+ *
+ * @param ex Exact state (after kk_exact_invert()).
+ * @param i Line index.
+ * @param j Column index.
+ * @param buf Output buffer.
+ * @param size Size of output buffer (see kk_exact_digits()).
+ *
+ * @return Length of string, -1 if buffer is too small or memory could not be allocated.
+ */
+int kk_exact_adj_str(const kk_exact_t *ex, int i, int j, char *buf, size_t size);
+
+/**
+ * @brief Get inverse (adjugate over determinant), rounded to double only once at the end.
+ *
+ * @param ex Exact state (after kk_exact_invert()).
+ * @param out n-by-n row-major output matrix (not finite if determinant is zero).
+ */
+void kk_exact_inverse(const kk_exact_t *ex, double *out);
+
+#endif
@@ -0,0 +1,293 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Matrix Files)                  * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "kk_batch.h"
+#include "kk_file.h"
+
+/**
+ * @brief Store value one in an element of a type (padding matrices are identities).
+ *
+ * @param type Element type.
+ * @param dst Element.
+ */
+static void kk_file_one(kk_file_type_t type, void *dst) {
+	double f64 = 1.0;
+	float f32 = 1.0f;
+	int32_t q16 = 1 << 16;
+	int64_t i64 = 1;
+
+	switch(type) {
+		case KK_FILE_F64: memcpy(dst, &f64, sizeof(f64)); break;
+		case KK_FILE_F32: memcpy(dst, &f32, sizeof(f32)); break;
+		case KK_FILE_Q16: memcpy(dst, &q16, sizeof(q16)); break;
+		case KK_FILE_I64: memcpy(dst, &i64, sizeof(i64)); break;
+	}
+}
+
+size_t kk_file_elem_size(kk_file_type_t type) {
+	switch(type) {
+		case KK_FILE_F64: return sizeof(double);
+		case KK_FILE_F32: return sizeof(float);
+		case KK_FILE_Q16: return sizeof(int32_t);
+		case KK_FILE_I64: return sizeof(int64_t);
+	}
+
+	return 0;
+}
+
+int kk_file_header_init(kk_file_header_t *hdr, int n, kk_file_type_t type, kk_file_layout_t layout, uint64_t count) {
+	uint64_t bytes, size;
+
+	if(!kk_file_elem_size(type) || ((KK_FILE_ROWMAJOR != layout) && (KK_FILE_PACKED != layout)))
+		return -1;
+	if((n < 1) || (n > KK_FILE_MAX_N))
+		return -1;
+
+	memset(hdr, 0, sizeof(*hdr));
+	memcpy(hdr->magic, KK_FILE_MAGIC, sizeof(hdr->magic));
+	hdr->version = KK_FILE_VERSION;
+	hdr->bom = KK_FILE_BOM;
+	hdr->type = type;
+	hdr->layout = layout;
+	hdr->n = n;
+	hdr->align = KK_ALIGN;
+	hdr->count = count;
+
+	if(__builtin_mul_overflow((uint64_t) n * n, kk_file_elem_size(type) * ((KK_FILE_PACKED == layout)? KK_BATCH_LANES : 1), &bytes))
+		return -1;
+	hdr->record = ((bytes + KK_ALIGN - 1) / KK_ALIGN) * KK_ALIGN;
+	hdr->offset = ((sizeof(*hdr) + KK_ALIGN - 1) / KK_ALIGN) * KK_ALIGN;
+
+	/* Whole file must be addressable */
+	return kk_file_bytes(hdr, &size);
+}
+
+uint64_t kk_file_records(const kk_file_header_t *hdr) {
+	return (KK_FILE_PACKED == hdr->layout)? (hdr->count + KK_BATCH_LANES - 1) / KK_BATCH_LANES : hdr->count;
+}
+
+int kk_file_bytes(const kk_file_header_t *hdr, uint64_t *size) {
+	uint64_t data;
+
+	if(__builtin_mul_overflow(kk_file_records(hdr), hdr->record, &data) || __builtin_add_overflow(hdr->offset, data, size) ||
+			(*size > (uint64_t) SIZE_MAX) || (*size > (uint64_t) INT64_MAX))
+		return -1;
+
+	return 0;
+}
+
+/**
+ * @brief Check that a header is valid and describes a file of a given size.
+ *
+ * @param hdr Header.
+ * @param size File size in bytes.
+ *
+ * @return 0 if valid, -1 otherwise.
+ */
+static int kk_file_check(const kk_file_header_t *hdr, size_t size) {
+	uint64_t bytes;
+	kk_file_header_t ref;
+
+	if(memcmp(hdr->magic, KK_FILE_MAGIC, sizeof(hdr->magic)) || (KK_FILE_VERSION != hdr->version) || (KK_FILE_BOM != hdr->bom))
+		return -1;
+	if(hdr->n > KK_FILE_MAX_N)
+		return -1;
+
+	/* Records must be where this library would put them (so that they are aligned and do not overlap) */
+	if(kk_file_header_init(&ref, hdr->n, hdr->type, hdr->layout, hdr->count) || (ref.record != hdr->record) || (ref.offset != hdr->offset) || (ref.align != hdr->align))
+		return -1;
+
+	return (kk_file_bytes(hdr, &bytes) || (bytes > size))? -1 : 0;
+}
+
+int kk_file_map(kk_file_t *f, const char *path, int writable) {
+	struct stat st;
+	void *base;
+
+	f->fd = open(path, writable? O_RDWR : O_RDONLY);
+	if(f->fd < 0)
+		return -1;
+
+	if(fstat(f->fd, &st) || ((size_t) st.st_size < sizeof(kk_file_header_t))) {
+		close(f->fd);
+		return -1;
+	}
+
+	base = mmap(NULL, st.st_size, writable? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, f->fd, 0);
+	if(MAP_FAILED == base) {
+		close(f->fd);
+		return -1;
+	}
+
+	f->hdr = base;
+	f->size = st.st_size;
+	if(kk_file_check(f->hdr, f->size)) {
+		kk_file_unmap(f);
+		return -1;
+	}
+
+	/* Batch inversions stream through records */
+	madvise(base, f->size, MADV_SEQUENTIAL);
+
+	return 0;
+}
+
+int kk_file_create(kk_file_t *f, const char *path, const kk_file_header_t *hdr) {
+	uint64_t bytes;
+	void *base;
+
+	if(kk_file_bytes(hdr, &bytes))
+		return -1;
+
+	f->size = bytes;
+	f->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(f->fd < 0)
+		return -1;
+
+	/* Extended files read as zeros, and only pages written to take disk space */
+	if(ftruncate(f->fd, f->size)) {
+		close(f->fd);
+		return -1;
+	}
+
+	base = mmap(NULL, f->size, PROT_READ | PROT_WRITE, MAP_SHARED, f->fd, 0);
+	if(MAP_FAILED == base) {
+		close(f->fd);
+		return -1;
+	}
+
+	f->hdr = base;
+	memcpy(f->hdr, hdr, sizeof(*hdr));
+
+	return 0;
+}
+
+void kk_file_unmap(kk_file_t *f) {
+	munmap(f->hdr, f->size);
+	close(f->fd);
+	f->hdr = NULL;
+	f->size = 0;
+	f->fd = -1;
+}
+
+void *kk_file_record(const kk_file_t *f, uint64_t r) {
+	return (char *) f->hdr + f->hdr->offset + r * f->hdr->record;
+}
+
+int kk_file_invert(const kk_file_t *in, kk_file_t *out, kk_workspace_t *ws, kk_result_t *res) {
+	const kk_file_header_t *h = in->hdr;
+
+	if((KK_FILE_F64 != h->type) || memcmp(h, out->hdr, sizeof(*h)))
+		return -1;
+
+	/* Records are KK_ALIGN-aligned, so the batch engine reads them where they lie */
+	if(KK_FILE_PACKED == h->layout)
+		return kk_batch_invert_packed(h->n, h->count, kk_file_record(in, 0), kk_file_record(out, 0), ws, res);
+
+	return kk_batch_invert_strided(h->n, h->count, kk_file_record(in, 0), kk_file_record(out, 0), h->record / sizeof(double), ws, res);
+}
+
+int kk_file_writer_open(kk_file_writer_t *w, const char *path, int n, kk_file_type_t type, kk_file_layout_t layout) {
+	if(kk_file_header_init(&w->hdr, n, type, layout, 0))
+		return -1;
+
+	w->buf = calloc(1, w->hdr.record);
+	w->fp = fopen(path, "wb");
+	if(!w->buf || !w->fp)
+		goto fail;
+
+	/* Header is written again once count is known */
+	if(fwrite(&w->hdr, sizeof(w->hdr), 1, w->fp) != 1)
+		goto fail;
+	if(fseek(w->fp, w->hdr.offset, SEEK_SET))
+		goto fail;
+
+	return 0;
+
+fail:
+	if(w->fp)
+		fclose(w->fp);
+	free(w->buf);
+	w->fp = NULL;
+	w->buf = NULL;
+
+	return -1;
+}
+
+int kk_file_writer_put(kk_file_writer_t *w, const void *matrix) {
+	size_t e, nn = (size_t) w->hdr.n * w->hdr.n, es = kk_file_elem_size(w->hdr.type);
+	size_t l = w->hdr.count % KK_BATCH_LANES;
+	const unsigned char *src = matrix;
+
+	if(KK_FILE_ROWMAJOR == w->hdr.layout) {
+		memcpy(w->buf, matrix, nn * es);
+		w->hdr.count++;
+		return (fwrite(w->buf, w->hdr.record, 1, w->fp) == 1)? 0 : -1;
+	}
+
+	/* Packed: element e of lane l goes to (e * KK_BATCH_LANES + l) */
+	for(e = 0; e < nn; e++)
+		memcpy(&w->buf[(e * KK_BATCH_LANES + l) * es], &src[e * es], es);
+	w->hdr.count++;
+	if(KK_BATCH_LANES - 1 == l)
+		return (fwrite(w->buf, w->hdr.record, 1, w->fp) == 1)? 0 : -1;
+
+	return 0;
+}
+
+int kk_file_writer_close(kk_file_writer_t *w) {
+	int ret = 0;
+	size_t e, l, n = w->hdr.n, es = kk_file_elem_size(w->hdr.type);
+
+	/* Last packed record is completed with identities */
+	if((KK_FILE_PACKED == w->hdr.layout) && (w->hdr.count % KK_BATCH_LANES)) {
+		for(l = w->hdr.count % KK_BATCH_LANES; l < KK_BATCH_LANES; l++) {
+			for(e = 0; e < n * n; e++) {
+				memset(&w->buf[(e * KK_BATCH_LANES + l) * es], 0, es);
+				if(e / n == e % n)
+					kk_file_one(w->hdr.type, &w->buf[(e * KK_BATCH_LANES + l) * es]);
+			}
+		}
+		ret |= (fwrite(w->buf, w->hdr.record, 1, w->fp) != 1);
+	}
+
+	ret |= fseek(w->fp, 0, SEEK_SET) || (fwrite(&w->hdr, sizeof(w->hdr), 1, w->fp) != 1);
+	ret |= fclose(w->fp);
+	free(w->buf);
+	w->fp = NULL;
+	w->buf = NULL;
+
+	return ret? -1 : 0;
+}
@@ -0,0 +1,262 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Matrix Files)                  * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_FILE_H
+#define KK_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "kk.h"
+
+/**
+ * @brief File signature (first 8 bytes).
+ */
+#define KK_FILE_MAGIC "KKMATRIX"
+
+/**
+ * @brief Format version written by this library (files of other versions are rejected).
+ */
+#define KK_FILE_VERSION 1
+
+/**
+ * @brief Written in byte order of the writer, so that files from a machine of another endianness are rejected.
+ */
+#define KK_FILE_BOM 0x01020304u
+
+/**
+ * @brief Largest matrix size of a file (element offsets i * stride of kk_invert() scratchpads, about
+ * n * (n + 8), must fit in an int; batch scratchpads use size_t offsets).
+ */
+#define KK_FILE_MAX_N 32768
+
+/**
+ * @brief Element types.
+ */
+typedef enum {
+	/* double (kk_invert()) */
+	KK_FILE_F64 = 1,
+	/* float (kk_invert_f()) */
+	KK_FILE_F32,
+	/* Q16.16 fixed point in int32_t (kk_invert_q(), accelerator format) */
+	KK_FILE_Q16,
+	/* int64_t (kk_exact_invert()) */
+	KK_FILE_I64
+} kk_file_type_t;
+
+/**
+ * @brief Record layouts.
+ */
+typedef enum {
+	/* One n-by-n row-major matrix per record */
+	KK_FILE_ROWMAJOR = 0,
+	/* KK_BATCH_LANES interleaved matrices per record, as kk_batch_pack() (last one padded with identities) */
+	KK_FILE_PACKED
+} kk_file_layout_t;
+
+/**
+ * @brief File header (64 bytes, at offset 0). Records follow at offset, record bytes apart.
+ */
+typedef struct {
+	/* KK_FILE_MAGIC */
+	char magic[8];
+	/* KK_FILE_VERSION */
+	uint32_t version;
+	/* KK_FILE_BOM */
+	uint32_t bom;
+	/* Element type (kk_file_type_t) */
+	uint32_t type;
+	/* Record layout (kk_file_layout_t) */
+	uint32_t layout;
+	/* Size of matrices */
+	uint32_t n;
+	/* Alignment of every record in bytes (KK_ALIGN) */
+	uint32_t align;
+	/* Number of matrices */
+	uint64_t count;
+	/* Distance between two records in bytes (multiple of align) */
+	uint64_t record;
+	/* Offset of first record in bytes (multiple of align) */
+	uint64_t offset;
+	/* Reserved (zero) */
+	uint64_t reserved;
+} kk_file_header_t;
+
+/**
+ * @brief Matrix file mapped in memory.
+ */
+typedef struct {
+	/* Header (start of mapping) */
+	kk_file_header_t *hdr;
+	/* Size of mapping in bytes */
+	size_t size;
+	/* File descriptor */
+	int fd;
+} kk_file_t;
+
+/**
+ * @brief Streaming writer (matrices are appended one at a time, so files may be larger than memory).
+ */
+typedef struct {
+	/* Header written so far (count is final once kk_file_writer_close() returns) */
+	kk_file_header_t hdr;
+	/* Output stream */
+	FILE *fp;
+	/* One record, zero-padded (packed layout gathers KK_BATCH_LANES matrices in it) */
+	unsigned char *buf;
+} kk_file_writer_t;
+
+/**
+ * @brief Return size of one element of a type.
+ *
+ * @param type Element type.
+ *
+ * @return Size in bytes, 0 if type is unknown.
+ */
+size_t kk_file_elem_size(kk_file_type_t type);
+
+/**
+ * @brief Fill a header for count n-by-n matrices (records padded to KK_ALIGN bytes).
+ *
+ * @param hdr Header.
+ * @param n Size of matrices.
+ * @param type Element type.
+ * @param layout Record layout.
+ * @param count Number of matrices.
+ *
+ * @return 0 on success, -1 if type or layout is unknown, n is not within 1 to KK_FILE_MAX_N, or the
+ *         whole file would not be addressable.
+ */
+int kk_file_header_init(kk_file_header_t *hdr, int n, kk_file_type_t type, kk_file_layout_t layout, uint64_t count);
+
+/**
+ * @brief Return number of records of a file (count, or count of groups for packed layout).
+ *
+ * @param hdr Header.
+ *
+ * @return Number of records.
+ */
+uint64_t kk_file_records(const kk_file_header_t *hdr);
+
+/**
+ * @brief Return size of a file (header, then every record), checking for overflow.
+ *
+ * @param hdr Header.
+ * @param size Size in bytes.
+ *
+ * @return 0 on success, -1 if size does not fit in a file offset or in memory.
+ */
+int kk_file_bytes(const kk_file_header_t *hdr, uint64_t *size);
+
+/**
+ * @brief Map an existing file (header is validated against file size).
+ *
+ * @param f Mapped file.
+ * @param path File path.
+ * @param writable 1 to map for writing (records may be updated in place), 0 for reading only.
+ *
+ * @return 0 on success, -1 if file could not be mapped or is not a valid matrix file.
+ */
+int kk_file_map(kk_file_t *f, const char *path, int writable);
+
+/**
+ * @brief Create a file of a given header (records zeroed) and map it for writing.
+ *
+ * @param f Mapped file.
+ * @param path File path (replaced if it exists).
+ * @param hdr Header.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int kk_file_create(kk_file_t *f, const char *path, const kk_file_header_t *hdr);
+
+/**
+ * @brief Unmap a file (changes to writable mappings are written back).
+ *
+ * @param f Mapped file.
+ */
+void kk_file_unmap(kk_file_t *f);
+
+/**
+ * @brief Return address of a record of a mapped file (aligned to the header alignment).
+ *
+ * @param f Mapped file.
+ * @param r Record index.
+ *
+ * @return Address of record.
+ */
+void *kk_file_record(const kk_file_t *f, uint64_t r);
+
+/**
+ * @brief Invert every matrix of a mapped double file with the batch engine, straight from mapping to
+ * mapping (no parsing, no copies).
+ *
+ * @param in Mapped input (KK_FILE_F64).
+ * @param out Mapped output with same header (may be in itself, for an in-place inversion).
+ * @param ws Workspace (pooled workspaces are grown as needed).
+ * @param res Array of count results (may be NULL).
+ *
+ * @return 0 on success, -1 if headers do not match, type is not KK_FILE_F64, or workspace could not
+ *         hold the inversion.
+ */
+int kk_file_invert(const kk_file_t *in, kk_file_t *out, kk_workspace_t *ws, kk_result_t *res);
+
+/**
+ * @brief Start writing a file record by record.
+ *
+ * @param w Writer.
+ * @param path File path (replaced if it exists).
+ * @param n Size of matrices.
+ * @param type Element type.
+ * @param layout Record layout.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+int kk_file_writer_open(kk_file_writer_t *w, const char *path, int n, kk_file_type_t type, kk_file_layout_t layout);
+
+/**
+ * @brief Append a matrix.
+ *
+ * @param w Writer.
+ * @param matrix n-by-n row-major matrix of the file element type.
+ *
+ * @return 0 on success, -1 on write error.
+ */
+int kk_file_writer_put(kk_file_writer_t *w, const void *matrix);
+
+/**
+ * @brief Finish a file: flush last record (padded with identities for packed layout), write final
+ * header and close it.
+ *
+ * @param w Writer.
+ *
+ * @return 0 on success, -1 on write error.
+ */
+int kk_file_writer_close(kk_file_writer_t *w);
+
+#endif
@@ -0,0 +1,344 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Fixed-Point Model)             * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <math.h>
+#include <string.h>
+
+#include "kk_fixed.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KK_FIXED_X86
+#endif
+
+/**
+ * @brief Largest iw + 2 * fw handled by SIMD kernels (shifted dividend is then exact in a double and
+ * so is its truncated quotient).
+ */
+#define KK_FIXED_SIMD_BITS 52
+
+/**
+ * @brief Row kernel: calculate a row of next matrix for KK_FIXED_LANES matrices.
+ *
+ * Element j of a row holds KK_FIXED_LANES consecutive values, one per matrix.
+ *
+ * @param next Row i of next matrix.
+ * @param c0 Row i of current matrix.
+ * @param c1 Row i + 1 of current matrix.
+ * @param p1 Row i + 1 of previous matrix.
+ * @param n Size of matrices.
+ * @param iw Integer part (in bits).
+ * @param fw Fractional part (in bits).
+ *
+ * @return Mask of lanes that divided by zero.
+ */
+typedef int (*kk_fixed_row_t)(int32_t *restrict next, const int32_t *restrict c0, const int32_t *restrict c1, const int32_t *restrict p1, int n, int iw, int fw);
+
+/**
+ * @brief Scalar row kernel.
+ */
+static int kk_fixed_row_scalar(int32_t *restrict next, const int32_t *restrict c0, const int32_t *restrict c1, const int32_t *restrict p1, int n, int iw, int fw) {
+	int j, l, divZero = 0;
+	int32_t x, y, p;
+	const int w = KK_FIXED_LANES;
+
+	for(j = 0; j < n; j++) {
+		for(l = 0; l < KK_FIXED_LANES; l++) {
+			x = kk_fixed_mul(c0[j * w + l], c1[(j + 1) * w + l], iw, fw);
+			y = kk_fixed_mul(c1[j * w + l], c0[(j + 1) * w + l], iw, fw);
+			p = p1[(j + 1) * w + l];
+			divZero |= (0 == p) << l;
+			next[j * w + l] = kk_fixed_div(kk_fixed_sub(x, y, iw, fw), p, iw, fw);
+		}
+	}
+
+	return divZero;
+}
+
+#ifdef KK_FIXED_X86
+/**
+ * @brief Multiply 8 fixed-point values with AVX2 (result not yet wrapped).
+ */
+__attribute__((target("avx2")))
+static inline __m256i kk_fixed_mul_avx2(__m256i a, __m256i b, __m128i fw) {
+	/* 32x32 to 64-bit products of even and odd lanes, shifted and merged back into 32-bit lanes */
+	__m256i even = _mm256_srl_epi64(_mm256_mul_epi32(a, b), fw);
+	__m256i odd = _mm256_srl_epi64(_mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), fw);
+
+	return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xaa);
+}
+
+/**
+ * @brief Divide 4 fixed-point values with AVX2 (result wrapped to 32 bits only).
+ */
+__attribute__((target("avx2")))
+static inline __m128i kk_fixed_quot_avx2(__m128i num, __m128i den, __m256d scale) {
+	const __m256d two32 = _mm256_set1_pd(4294967296.0), two31 = _mm256_set1_pd(2147483648.0);
+	__m256d q;
+
+	q = _mm256_div_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(num), scale), _mm256_cvtepi32_pd(den));
+	q = _mm256_round_pd(q, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+
+	/* Reduce to [-2^31, 2^31) (every step is exact) */
+	q = _mm256_sub_pd(q, _mm256_mul_pd(_mm256_floor_pd(_mm256_div_pd(q, two32)), two32));
+	q = _mm256_sub_pd(q, _mm256_and_pd(_mm256_cmp_pd(q, two31, _CMP_GE_OQ), two32));
+
+	return _mm256_cvttpd_epi32(q);
+}
+
+/**
+ * @brief AVX2 row kernel (two vectors of 8 lanes per element).
+ */
+__attribute__((target("avx2")))
+static int kk_fixed_row_avx2(int32_t *restrict next, const int32_t *restrict c0, const int32_t *restrict c1, const int32_t *restrict p1, int n, int iw, int fw) {
+	int j, h, divZero = 0;
+	__m256i a, b, c, d, p, x, zero;
+	__m128i shift = _mm_cvtsi32_si128(fw), wrap = _mm_cvtsi32_si128(32 - (iw + fw));
+	__m256d scale = _mm256_set1_pd(ldexp(1.0, fw));
+	const __m256i one = _mm256_set1_epi32(1);
+	const int w = KK_FIXED_LANES;
+
+	for(j = 0; j < n; j++) {
+		for(h = 0; h < KK_FIXED_LANES; h += 8) {
+			a = _mm256_load_si256((const __m256i *) &c0[j * w + h]);
+			b = _mm256_load_si256((const __m256i *) &c0[(j + 1) * w + h]);
+			c = _mm256_load_si256((const __m256i *) &c1[j * w + h]);
+			d = _mm256_load_si256((const __m256i *) &c1[(j + 1) * w + h]);
+			p = _mm256_load_si256((const __m256i *) &p1[(j + 1) * w + h]);
+
+			a = _mm256_sra_epi32(_mm256_sll_epi32(kk_fixed_mul_avx2(a, d, shift), wrap), wrap);
+			c = _mm256_sra_epi32(_mm256_sll_epi32(kk_fixed_mul_avx2(c, b, shift), wrap), wrap);
+			x = _mm256_sra_epi32(_mm256_sll_epi32(_mm256_sub_epi32(a, c), wrap), wrap);
+
+			/* Zero divisors are replaced by 1 and their quotients by 0 */
+			zero = _mm256_cmpeq_epi32(p, _mm256_setzero_si256());
+			divZero |= _mm256_movemask_ps(_mm256_castsi256_ps(zero)) << h;
+			p = _mm256_blendv_epi8(p, one, zero);
+
+			x = _mm256_set_m128i(kk_fixed_quot_avx2(_mm256_extracti128_si256(x, 1), _mm256_extracti128_si256(p, 1), scale),
+								kk_fixed_quot_avx2(_mm256_castsi256_si128(x), _mm256_castsi256_si128(p), scale));
+			x = _mm256_sra_epi32(_mm256_sll_epi32(x, wrap), wrap);
+			_mm256_store_si256((__m256i *) &next[j * w + h], _mm256_andnot_si256(zero, x));
+		}
+	}
+
+	return divZero;
+}
+
+/**
+ * @brief Multiply 16 fixed-point values with AVX-512 (result not yet wrapped).
+ */
+__attribute__((target("avx512f")))
+static inline __m512i kk_fixed_mul_avx512(__m512i a, __m512i b, __m128i fw) {
+	__m512i even = _mm512_srl_epi64(_mm512_mul_epi32(a, b), fw);
+	__m512i odd = _mm512_srl_epi64(_mm512_mul_epi32(_mm512_srli_epi64(a, 32), _mm512_srli_epi64(b, 32)), fw);
+
+	return _mm512_mask_blend_epi32(0xaaaa, even, _mm512_slli_epi64(odd, 32));
+}
+
+/**
+ * @brief Divide 8 fixed-point values with AVX-512 (result wrapped to 32 bits only).
+ */
+__attribute__((target("avx512f")))
+static inline __m256i kk_fixed_quot_avx512(__m256i num, __m256i den, __m512d scale) {
+	const __m512d two32 = _mm512_set1_pd(4294967296.0), two31 = _mm512_set1_pd(2147483648.0);
+	__m512d q;
+
+	q = _mm512_div_pd(_mm512_mul_pd(_mm512_cvtepi32_pd(num), scale), _mm512_cvtepi32_pd(den));
+	q = _mm512_roundscale_pd(q, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+
+	/* Reduce to [-2^31, 2^31) (every step is exact) */
+	q = _mm512_sub_pd(q, _mm512_mul_pd(_mm512_roundscale_pd(_mm512_div_pd(q, two32), _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC), two32));
+	q = _mm512_mask_sub_pd(q, _mm512_cmp_pd_mask(q, two31, _CMP_GE_OQ), q, two32);
+
+	return _mm512_cvttpd_epi32(q);
+}
+
+/**
+ * @brief AVX-512 row kernel (one vector of 16 lanes per element).
+ */
+__attribute__((target("avx512f")))
+static int kk_fixed_row_avx512(int32_t *restrict next, const int32_t *restrict c0, const int32_t *restrict c1, const int32_t *restrict p1, int n, int iw, int fw) {
+	int j, divZero = 0;
+	__m512i a, b, c, d, p, x;
+	__mmask16 zero;
+	__m128i shift = _mm_cvtsi32_si128(fw), wrap = _mm_cvtsi32_si128(32 - (iw + fw));
+	__m512d scale = _mm512_set1_pd(ldexp(1.0, fw));
+	const __m512i one = _mm512_set1_epi32(1);
+	const int w = KK_FIXED_LANES;
+
+	for(j = 0; j < n; j++) {
+		a = _mm512_load_si512(&c0[j * w]);
+		b = _mm512_load_si512(&c0[(j + 1) * w]);
+		c = _mm512_load_si512(&c1[j * w]);
+		d = _mm512_load_si512(&c1[(j + 1) * w]);
+		p = _mm512_load_si512(&p1[(j + 1) * w]);
+
+		a = _mm512_sra_epi32(_mm512_sll_epi32(kk_fixed_mul_avx512(a, d, shift), wrap), wrap);
+		c = _mm512_sra_epi32(_mm512_sll_epi32(kk_fixed_mul_avx512(c, b, shift), wrap), wrap);
+		x = _mm512_sra_epi32(_mm512_sll_epi32(_mm512_sub_epi32(a, c), wrap), wrap);
+
+		/* Zero divisors are replaced by 1 and their quotients by 0 */
+		zero = _mm512_cmpeq_epi32_mask(p, _mm512_setzero_si512());
+		divZero |= zero;
+		p = _mm512_mask_blend_epi32(zero, p, one);
+
+		x = _mm512_inserti64x4(_mm512_castsi256_si512(kk_fixed_quot_avx512(_mm512_castsi512_si256(x), _mm512_castsi512_si256(p), scale)),
+								kk_fixed_quot_avx512(_mm512_extracti64x4_epi64(x, 1), _mm512_extracti64x4_epi64(p, 1), scale), 1);
+		x = _mm512_sra_epi32(_mm512_sll_epi32(x, wrap), wrap);
+		_mm512_store_si512(&next[j * w], _mm512_maskz_mov_epi32((__mmask16) ~zero, x));
+	}
+
+	return divZero;
+}
+#endif
+
+int32_t kk_fixed_from_double(double x, int iw, int fw) {
+	/* Truncate, then wrap (exactly) to iw + fw bits */
+	double v = fmod(trunc(ldexp(x, fw)), ldexp(1.0, iw + fw));
+
+	return kk_fixed_wrap((int64_t) v, iw + fw);
+}
+
+double kk_fixed_to_double(int32_t x, int fw) {
+	return ldexp(x, -fw);
+}
+
+size_t kk_fixed_workspace_size(int n) {
+	return 3 * (size_t) (n + 1) * (n + 1) * KK_FIXED_LANES * sizeof(int32_t);
+}
+
+/**
+ * @brief Replicate row 0 and column 0 of a matrix into row n and column n.
+ *
+ * @param matrix (n+1)-by-(n+1) matrix of KK_FIXED_LANES lanes per element.
+ * @param n Size of matrices.
+ */
+static void kk_fixed_halo(int32_t *matrix, int n) {
+	int i, s = (n + 1) * KK_FIXED_LANES;
+
+	for(i = 0; i < n; i++)
+		memcpy(&matrix[i * s + n * KK_FIXED_LANES], &matrix[i * s], KK_FIXED_LANES * sizeof(int32_t));
+	memcpy(&matrix[n * s], matrix, s * sizeof(int32_t));
+}
+
+/**
+ * @brief Run the model on a group of up to KK_FIXED_LANES matrices.
+ *
+ * @param row Row kernel.
+ * @param iw Integer part (in bits).
+ * @param fw Fractional part (in bits).
+ * @param n Size of matrices.
+ * @param count Number of matrices in group.
+ * @param in count n-by-n input matrices.
+ * @param intElem count n-by-n intermediate matrices (may be NULL).
+ * @param detElem count n-by-n determinant matrices (may be NULL).
+ * @param res count flags (may be NULL).
+ * @param mem Scratch memory.
+ */
+static void kk_fixed_group(kk_fixed_row_t row, int iw, int fw, int n, int count, const int32_t *in, int32_t *intElem, int32_t *detElem, kk_fixed_result_t *res, int32_t *mem) {
+	int i, j, l, k, tmp, undefined = 0, divZero = 0;
+	int s = (n + 1) * KK_FIXED_LANES;
+	int32_t one = kk_fixed_wrap((int64_t) 1 << fw, iw + fw);
+	int32_t *matrix_K[3];
+	/* Input is put on register set 1, as putElem does */
+	int next = 2, prev = 0, curr = 1;
+
+	for(k = 0; k < 3; k++)
+		matrix_K[k] = &mem[k * (n + 1) * s];
+
+	/* Transfer matrices (unused lanes repeat first matrix) */
+	for(i = 0; i < n; i++)
+		for(j = 0; j < n; j++)
+			for(l = 0; l < KK_FIXED_LANES; l++)
+				matrix_K[curr][i * s + j * KK_FIXED_LANES + l] = in[((size_t) ((l < count)? l : 0) * n + i) * n + j];
+	kk_fixed_halo(matrix_K[curr], n);
+
+	/* State 0 divides by 1.0 */
+	for(i = 0; i < (n + 1) * s; i++)
+		matrix_K[prev][i] = one;
+
+	/* States 0..n-2: the last state (n-1) only matters for its division by zero check */
+	for(k = 0; k < n - 1; k++) {
+		for(i = 0; i < n; i++)
+			undefined |= row(&matrix_K[next][i * s], &matrix_K[curr][i * s], &matrix_K[curr][(i + 1) * s], &matrix_K[prev][(i + 1) * s], n, iw, fw);
+		kk_fixed_halo(matrix_K[next], n);
+
+		tmp = prev;
+		prev = curr;
+		curr = next;
+		next = tmp;
+	}
+
+	/* checkDivZero is overwritten every state, so only divisors of state n-1 (getIntElem matrix) count */
+	if(n > 1)
+		for(i = 0; i < n; i++)
+			for(j = 0; j < n; j++)
+				for(l = 0; l < KK_FIXED_LANES; l++)
+					divZero |= (0 == matrix_K[prev][i * s + j * KK_FIXED_LANES + l]) << l;
+
+	for(l = 0; l < count; l++) {
+		for(i = 0; i < n; i++) {
+			for(j = 0; j < n; j++) {
+				if(intElem)
+					intElem[((size_t) l * n + i) * n + j] = matrix_K[prev][i * s + j * KK_FIXED_LANES + l];
+				if(detElem)
+					detElem[((size_t) l * n + i) * n + j] = matrix_K[curr][i * s + j * KK_FIXED_LANES + l];
+			}
+		}
+
+		if(res) {
+			res[l].divZero = (divZero >> l) & 1;
+			res[l].undefined = (undefined >> l) & 1;
+		}
+	}
+}
+
+int kk_fixed_run(int iw, int fw, int n, int count, const int32_t *in, int32_t *intElem, int32_t *detElem, kk_fixed_result_t *res, void *mem) {
+	int g, m;
+	kk_fixed_row_t row = kk_fixed_row_scalar;
+
+	if((iw < 2) || (fw < 0) || (iw + fw > 32))
+		return -1;
+
+#ifdef KK_FIXED_X86
+	if(iw + 2 * fw <= KK_FIXED_SIMD_BITS) {
+		if(KK_SIMD_AVX512 == kk_simd_get())
+			row = kk_fixed_row_avx512;
+		else if(KK_SIMD_AVX2 == kk_simd_get())
+			row = kk_fixed_row_avx2;
+	}
+#endif
+
+	for(g = 0; g < count; g += KK_FIXED_LANES) {
+		m = (count - g < KK_FIXED_LANES)? count - g : KK_FIXED_LANES;
+		kk_fixed_group(row, iw, fw, n, m, &in[(size_t) g * n * n], intElem? &intElem[(size_t) g * n * n] : NULL,
+						detElem? &detElem[(size_t) g * n * n] : NULL, res? &res[g] : NULL, mem);
+	}
+
+	return 0;
+}
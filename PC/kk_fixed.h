@@ -0,0 +1,169 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Fixed-Point Model)             * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_FIXED_H
+#define KK_FIXED_H
+
+#include <stdint.h>
+
+#include "kk.h"
+
+/**
+ * @brief Integer part (in bits) of the accelerator fixed-point format.
+ */
+#define KK_FIXED_IW 16
+
+/**
+ * @brief Fractional part (in bits) of the accelerator fixed-point format.
+ */
+#define KK_FIXED_FW 16
+
+/**
+ * @brief Number of matrices processed side by side (one per 32-bit SIMD lane of a 512-bit vector).
+ */
+#define KK_FIXED_LANES 16
+
+/**
+ * @brief Flags reported by the model for each matrix.
+ */
+typedef struct {
+	/* Same as divZero method of mkFixedPointKKIteration (checkDivZero of last state only) */
+	int divZero;
+	/* 1 if any state feeding getIntElem/getDetElem divided by zero (hardware holds undefined values) */
+	int undefined;
+} kk_fixed_result_t;
+
+/**
+ * @brief Wrap a value to b bits and sign-extend it (FixedPoint results never saturate).
+ *
+ * @param x Value.
+ * @param b Number of bits (iw + fw).
+ *
+ * @return Wrapped value.
+ */
+static inline int32_t kk_fixed_wrap(int64_t x, int b) {
+	return (int32_t) ((int64_t) ((uint64_t) x << (64 - b)) >> (64 - b));
+}
+
+/**
+ * @brief FixedPoint#(iw, fw) multiply: full product truncated (floor) to fw fractional bits.
+ *
+ * @param a First operand.
+ * @param b Second operand.
+ * @param iw Integer part (in bits).
+ * @param fw Fractional part (in bits).
+ *
+ * @return Product.
+ */
+static inline int32_t kk_fixed_mul(int32_t a, int32_t b, int iw, int fw) {
+	return kk_fixed_wrap(((int64_t) a * b) >> fw, iw + fw);
+}
+
+/**
+ * @brief FixedPoint#(iw, fw) subtract.
+ *
+ * @param a First operand.
+ * @param b Second operand.
+ * @param iw Integer part (in bits).
+ * @param fw Fractional part (in bits).
+ *
+ * @return Difference.
+ */
+static inline int32_t kk_fixed_sub(int32_t a, int32_t b, int iw, int fw) {
+	return kk_fixed_wrap((int64_t) a - b, iw + fw);
+}
+
+/**
+ * @brief FixedPoint#(iw, fw) divide: (a << fw) / b truncated towards zero.
+ *
+ * @param a Dividend.
+ * @param b Divisor.
+ * @param iw Integer part (in bits).
+ * @param fw Fractional part (in bits).
+ *
+ * @return Quotient (0 if b is zero, where hardware would give an undefined value).
+ */
+static inline int32_t kk_fixed_div(int32_t a, int32_t b, int iw, int fw) {
+	return b? kk_fixed_wrap(((int64_t) a * ((int64_t) 1 << fw)) / b, iw + fw) : 0;
+}
+
+/**
+ * @brief Convert a real number to fixed point, as to_bit() of the Nios driver does (truncating).
+ *
+ * @param x Real number.
+ * @param iw Integer part (in bits).
+ * @param fw Fractional part (in bits).
+ *
+ * @return Fixed-point bits, sign-extended to 32 bits.
+ */
+int32_t kk_fixed_from_double(double x, int iw, int fw);
+
+/**
+ * @brief Convert fixed point to a real number.
+ *
+ * @param x Fixed-point bits.
+ * @param fw Fractional part (in bits).
+ *
+ * @return Real number.
+ */
+double kk_fixed_to_double(int32_t x, int fw);
+
+/**
+ * @brief Return scratch memory needed by kk_fixed_run() for n-by-n matrices.
+ *
+ * @param n Size of matrices.
+ *
+ * @return Size in bytes.
+ */
+size_t kk_fixed_workspace_size(int n);
+
+/**
+ * @brief Bit-exact model of mkFixedPointKKIteration on FixedPoint#(iw, fw).
+ *
+ * Multiply keeps the full product and truncates it to fw fractional bits, subtract wraps, divide
+ * is (a << fw) / b truncated towards zero, and every result wraps to iw + fw bits, as Bluespec
+ * FixedPoint arithmetic does. The hardware register holds X after a division by zero; the model
+ * stores 0 there and reports it through the undefined flag. As in hardware, getIntElem of a 1-by-1
+ * matrix is never written (the model returns 1.0).
+ *
+ * Matrices are processed in groups of KK_FIXED_LANES, one per 32-bit SIMD lane.
+ *
+ * @param iw Integer part (in bits, at least 2).
+ * @param fw Fractional part (in bits, iw + fw at most 32).
+ * @param n Size of matrices.
+ * @param count Number of matrices.
+ * @param in count n-by-n row-major input matrices (fixed-point bits, as given to putElem).
+ * @param intElem count n-by-n matrices read back with getIntElem (may be NULL).
+ * @param detElem count n-by-n matrices read back with getDetElem (may be NULL).
+ * @param res count flags (may be NULL).
+ * @param mem Scratch memory of kk_fixed_workspace_size(n) bytes, aligned to KK_ALIGN.
+ *
+ * @return 0 on success, -1 if format is not supported.
+ */
+int kk_fixed_run(int iw, int fw, int n, int count, const int32_t *in, int32_t *intElem, int32_t *detElem, kk_fixed_result_t *res, void *mem);
+
+#endif
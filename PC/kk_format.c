@@ -0,0 +1,523 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Buffered Output)               * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <errno.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "kk_format.h"
+
+/**
+ * @brief Expected length of a value in text mode (separator included), to keep matrices in one write().
+ */
+#define KK_FORMAT_TYPICAL 16
+
+/**
+ * @brief Number of cached powers of ten (10^-348 to 10^340).
+ */
+#define KK_FORMAT_CACHED 87
+
+/**
+ * @brief Powers of ten that are exact doubles, up to 10^KK_FORMAT_MAX_PREC.
+ */
+static const double kk_format_pow10[KK_FORMAT_MAX_PREC + 1] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+
+/**
+ * @brief Powers of ten as integers, up to 10^19.
+ */
+static const uint64_t kk_format_pow10u[20] = {
+	1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+	10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+	1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull,
+	10000000000000000000ull
+};
+
+/**
+ * @brief Cached powers of ten for shortest output (Grisu2): 10^k ~ f * 2^e for k = -348 + 8 * i,
+ * f normalized to 64 bits and rounded to nearest.
+ */
+static const uint64_t kk_format_cached_f[KK_FORMAT_CACHED] = {
+	0xfa8fd5a0081c0288ull, 0xbaaee17fa23ebf76ull, 0x8b16fb203055ac76ull, 0xcf42894a5dce35eaull,
+	0x9a6bb0aa55653b2dull, 0xe61acf033d1a45dfull, 0xab70fe17c79ac6caull, 0xff77b1fcbebcdc4full,
+	0xbe5691ef416bd60cull, 0x8dd01fad907ffc3cull, 0xd3515c2831559a83ull, 0x9d71ac8fada6c9b5ull,
+	0xea9c227723ee8bcbull, 0xaecc49914078536dull, 0x823c12795db6ce57ull, 0xc21094364dfb5637ull,
+	0x9096ea6f3848984full, 0xd77485cb25823ac7ull, 0xa086cfcd97bf97f4ull, 0xef340a98172aace5ull,
+	0xb23867fb2a35b28eull, 0x84c8d4dfd2c63f3bull, 0xc5dd44271ad3cdbaull, 0x936b9fcebb25c996ull,
+	0xdbac6c247d62a584ull, 0xa3ab66580d5fdaf6ull, 0xf3e2f893dec3f126ull, 0xb5b5ada8aaff80b8ull,
+	0x87625f056c7c4a8bull, 0xc9bcff6034c13053ull, 0x964e858c91ba2655ull, 0xdff9772470297ebdull,
+	0xa6dfbd9fb8e5b88full, 0xf8a95fcf88747d94ull, 0xb94470938fa89bcfull, 0x8a08f0f8bf0f156bull,
+	0xcdb02555653131b6ull, 0x993fe2c6d07b7facull, 0xe45c10c42a2b3b06ull, 0xaa242499697392d3ull,
+	0xfd87b5f28300ca0eull, 0xbce5086492111aebull, 0x8cbccc096f5088ccull, 0xd1b71758e219652cull,
+	0x9c40000000000000ull, 0xe8d4a51000000000ull, 0xad78ebc5ac620000ull, 0x813f3978f8940984ull,
+	0xc097ce7bc90715b3ull, 0x8f7e32ce7bea5c70ull, 0xd5d238a4abe98068ull, 0x9f4f2726179a2245ull,
+	0xed63a231d4c4fb27ull, 0xb0de65388cc8ada8ull, 0x83c7088e1aab65dbull, 0xc45d1df942711d9aull,
+	0x924d692ca61be758ull, 0xda01ee641a708deaull, 0xa26da3999aef774aull, 0xf209787bb47d6b85ull,
+	0xb454e4a179dd1877ull, 0x865b86925b9bc5c2ull, 0xc83553c5c8965d3dull, 0x952ab45cfa97a0b3ull,
+	0xde469fbd99a05fe3ull, 0xa59bc234db398c25ull, 0xf6c69a72a3989f5cull, 0xb7dcbf5354e9beceull,
+	0x88fcf317f22241e2ull, 0xcc20ce9bd35c78a5ull, 0x98165af37b2153dfull, 0xe2a0b5dc971f303aull,
+	0xa8d9d1535ce3b396ull, 0xfb9b7cd9a4a7443cull, 0xbb764c4ca7a44410ull, 0x8bab8eefb6409c1aull,
+	0xd01fef10a657842cull, 0x9b10a4e5e9913129ull, 0xe7109bfba19c0c9dull, 0xac2820d9623bf429ull,
+	0x80444b5e7aa7cf85ull, 0xbf21e44003acdd2dull, 0x8e679c2f5e44ff8full, 0xd433179d9c8cb841ull,
+	0x9e19db92b4e31ba9ull, 0xeb96bf6ebadf77d9ull, 0xaf87023b9bf0ee6bull
+};
+
+/**
+ * @brief Binary exponents of cached powers of ten.
+ */
+static const int16_t kk_format_cached_e[KK_FORMAT_CACHED] = {
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927, -901, -874, -847, -821,
+	-794, -768, -741, -715, -688, -661, -635, -608, -582, -555, -529, -502, -475, -449, -422, -396,
+	-369, -343, -316, -289, -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+	56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348, 375, 402, 428, 455,
+	481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+	907, 933, 960, 986, 1013, 1039, 1066
+};
+
+/**
+ * @brief Extended floating-point value f * 2^e.
+ */
+typedef struct {
+	uint64_t f;
+	int e;
+} kk_format_fp_t;
+
+/**
+ * @brief Write a number of decimal digits of an unsigned integer (with leading zeros).
+ *
+ * @param dst Output.
+ * @param u Integer (below 10^digits).
+ * @param digits Number of digits.
+ */
+static void kk_format_digits(char *dst, uint64_t u, int digits) {
+	while(digits--) {
+		dst[digits] = '0' + (u % 10);
+		u /= 10;
+	}
+}
+
+/**
+ * @brief Return number of decimal digits of an unsigned integer (at least 1).
+ *
+ * @param u Integer.
+ *
+ * @return Number of digits.
+ */
+static int kk_format_count(uint64_t u) {
+	int digits = 1;
+
+	while(u >= 10) {
+		u /= 10;
+		digits++;
+	}
+
+	return digits;
+}
+
+/**
+ * @brief Multiply two extended values (64-bit mantissa of product, rounded).
+ *
+ * @param a First value.
+ * @param b Second value.
+ *
+ * @return Product.
+ */
+static kk_format_fp_t kk_format_mul(kk_format_fp_t a, kk_format_fp_t b) {
+	unsigned __int128 p = (unsigned __int128) a.f * b.f;
+	kk_format_fp_t r;
+
+	r.f = (uint64_t) (p >> 64) + (((uint64_t) p >> 63) & 1);
+	r.e = a.e + b.e + 64;
+
+	return r;
+}
+
+/**
+ * @brief Round last digit of shortest output towards the exact value, while it stays within bounds.
+ *
+ * @param digits Digits.
+ * @param len Number of digits.
+ * @param delta Width of rounding interval.
+ * @param rest Distance from digits to upper bound.
+ * @param ten Unit of last digit.
+ * @param wpw Distance from exact value to upper bound.
+ */
+static void kk_format_round(char *digits, int len, uint64_t delta, uint64_t rest, uint64_t ten, uint64_t wpw) {
+	while((rest < wpw) && (delta - rest >= ten) && ((rest + ten < wpw) || (wpw - rest > rest + ten - wpw))) {
+		digits[len - 1]--;
+		rest += ten;
+	}
+}
+
+/**
+ * @brief Calculate shortest digits of a positive finite double (Grisu2, as in Florian Loitsch's "Printing
+ * Floating-Point Numbers Quickly and Accurately with Integers").
+ *
+ * Digits always read back as v; they are the shortest such digits for all but a tiny fraction of values
+ * (those get one more digit).
+ *
+ * @param v Value.
+ * @param digits Output digits (at least 18 bytes, not terminated).
+ * @param k Decimal exponent (v is digits * 10^k).
+ *
+ * @return Number of digits.
+ */
+static int kk_format_grisu(double v, char *digits, int *k) {
+	kk_format_fp_t w, wp, wm, c, one;
+	uint64_t bits, delta, wpw, rest, p2;
+	uint32_t p1, q;
+	int kappa, len = 0, index, s;
+	double dk;
+	char d, top[10];
+
+	memcpy(&bits, &v, sizeof(bits));
+	w.f = bits & ((1ull << 52) - 1);
+	w.e = (int) ((bits >> 52) & 0x7ff);
+	if(w.e) {
+		w.f |= 1ull << 52;
+		w.e -= 1075;
+	}
+	else {
+		w.e = -1074;
+	}
+
+	/* Halfway points to the neighbour doubles (the lower one is closer at powers of two), same exponent */
+	wp.f = (w.f << 1) + 1;
+	wp.e = w.e - 1;
+	while(!(wp.f & (1ull << 53))) {
+		wp.f <<= 1;
+		wp.e--;
+	}
+	wp.f <<= 10;
+	wp.e -= 10;
+	if(w.f == (1ull << 52)) {
+		wm.f = (w.f << 2) - 1;
+		wm.e = w.e - 2;
+	}
+	else {
+		wm.f = (w.f << 1) - 1;
+		wm.e = w.e - 1;
+	}
+	wm.f <<= wm.e - wp.e;
+	wm.e = wp.e;
+	s = __builtin_clzll(w.f);
+	w.f <<= s;
+	w.e -= s;
+
+	/* Scale by a cached power of ten so that the upper bound has a binary exponent in [-60, -32] */
+	dk = (-61 - wp.e) * 0.30102999566398114 + 347;
+	index = (int) dk;
+	if(dk - index > 0)
+		index++;
+	index = (index >> 3) + 1;
+	*k = 348 - index * 8;
+	c.f = kk_format_cached_f[index];
+	c.e = kk_format_cached_e[index];
+	w = kk_format_mul(w, c);
+	wp = kk_format_mul(wp, c);
+	wm = kk_format_mul(wm, c);
+	wm.f++;
+	wp.f--;
+
+	/* Digits of upper bound, until they are within the interval */
+	delta = wp.f - wm.f;
+	wpw = wp.f - w.f;
+	one.e = wp.e;
+	one.f = 1ull << -one.e;
+	p1 = (uint32_t) (wp.f >> -one.e);
+	p2 = wp.f & (one.f - 1);
+	for(kappa = 1; (kappa < 10) && (p1 >= kk_format_pow10u[kappa]); kappa++)
+		;
+
+	/* Split integer part once (constant divisors are cheap, variable ones are not) */
+	for(s = kappa - 1, q = p1; s >= 0; s--, q /= 10)
+		top[s] = (char) (q % 10);
+
+	for(s = 0; kappa > 0; s++) {
+		d = top[s];
+		p1 -= d * (uint32_t) kk_format_pow10u[kappa - 1];
+		if(d || len)
+			digits[len++] = '0' + d;
+		kappa--;
+		rest = ((uint64_t) p1 << -one.e) + p2;
+		if(rest <= delta) {
+			*k += kappa;
+			kk_format_round(digits, len, delta, rest, kk_format_pow10u[kappa] << -one.e, wpw);
+			return len;
+		}
+	}
+
+	for(;;) {
+		p2 *= 10;
+		delta *= 10;
+		d = (char) (p2 >> -one.e);
+		if(d || len)
+			digits[len++] = '0' + d;
+		p2 &= one.f - 1;
+		kappa--;
+		if(p2 < delta) {
+			*k += kappa;
+			kk_format_round(digits, len, delta, p2, one.f, wpw * ((-kappa < 20)? kk_format_pow10u[-kappa] : 0));
+			return len;
+		}
+	}
+}
+
+/**
+ * @brief Lay out shortest digits as "%.17g" would (fixed notation for decimal exponents -5 to 16,
+ * scientific with at least two exponent digits otherwise).
+ *
+ * @param dst Output.
+ * @param digits Digits.
+ * @param len Number of digits.
+ * @param k Decimal exponent (value is digits * 10^k).
+ *
+ * @return Number of characters written.
+ */
+static int kk_format_layout(char *dst, const char *digits, int len, int k) {
+	int x = len + k - 1, n = 0, i;
+
+	if((x < -4) || (x >= 17)) {
+		dst[n++] = digits[0];
+		if(len > 1) {
+			dst[n++] = '.';
+			memcpy(&dst[n], &digits[1], len - 1);
+			n += len - 1;
+		}
+		dst[n++] = 'e';
+		dst[n++] = (x < 0)? '-' : '+';
+		x = abs(x);
+		i = (x >= 100)? 3 : 2;
+		kk_format_digits(&dst[n], x, i);
+		return n + i;
+	}
+
+	if(x < 0) {
+		dst[n++] = '0';
+		dst[n++] = '.';
+		for(i = -1; i > x; i--)
+			dst[n++] = '0';
+		memcpy(&dst[n], digits, len);
+		return n + len;
+	}
+
+	for(i = 0; i <= x; i++)
+		dst[n++] = (i < len)? digits[i] : '0';
+	if(len > x + 1) {
+		dst[n++] = '.';
+		memcpy(&dst[n], &digits[x + 1], len - x - 1);
+		n += len - x - 1;
+	}
+
+	return n;
+}
+
+int kk_format_double(char *dst, double v, int prec) {
+	int len, digits, k;
+	char tmp[KK_FORMAT_MAX_CHARS + 1];
+	double t, f, d, p;
+	uint64_t u, ip;
+
+	if(KK_FORMAT_SHORTEST == prec) {
+		/* Zero, infinities and NaN as printf() writes them */
+		if(!isfinite(v) || (0 == v)) {
+			len = snprintf(tmp, sizeof(tmp), "%.17g", v);
+			memcpy(dst, tmp, len);
+			return len;
+		}
+
+		len = 0;
+		if(signbit(v))
+			dst[len++] = '-';
+		digits = kk_format_grisu(fabs(v), tmp, &k);
+		return len + kk_format_layout(&dst[len], tmp, digits, k);
+	}
+
+	/*
+	 * t is v * 10^prec rounded once (10^prec is exact), so the exact product is within 2^-53 * t of it.
+	 * Unless that interval holds a tie (or t is too large to be split into integers), rounding t to the
+	 * nearest integer gives the same digits as printf() rounding the exact value.
+	 */
+	p = kk_format_pow10[prec];
+	t = fabs(v) * p;
+	if(!(t < 9007199254740992.0)) {
+		len = snprintf(tmp, sizeof(tmp), "%.*f", prec, v);
+		memcpy(dst, tmp, len);
+		return len;
+	}
+	f = floor(t);
+	d = t - f;
+	if(fabs(d - 0.5) <= t * 0x1p-52) {
+		len = snprintf(tmp, sizeof(tmp), "%.*f", prec, v);
+		memcpy(dst, tmp, len);
+		return len;
+	}
+	u = (uint64_t) f + (d > 0.5);
+
+	len = 0;
+	if(signbit(v))
+		dst[len++] = '-';
+	ip = u / (uint64_t) p;
+	digits = kk_format_count(ip);
+	kk_format_digits(&dst[len], ip, digits);
+	len += digits;
+	if(prec) {
+		dst[len++] = '.';
+		kk_format_digits(&dst[len], u - ip * (uint64_t) p, prec);
+		len += prec;
+	}
+
+	return len;
+}
+
+int kk_format_init(kk_format_t *f, int fd, kk_format_mode_t mode, int prec, size_t size) {
+	if((prec < KK_FORMAT_SHORTEST) || (prec > KK_FORMAT_MAX_PREC))
+		return -1;
+
+	if(!size)
+		size = KK_FORMAT_BUFFER;
+	if(size < 4096)
+		size = 4096;
+
+	f->buf = malloc(size);
+	if(!f->buf)
+		return -1;
+	f->fd = fd;
+	f->mode = mode;
+	f->prec = prec;
+	f->size = size;
+	f->len = 0;
+	f->err = 0;
+
+	return 0;
+}
+
+/**
+ * @brief Write out a block of bytes, retrying partial and interrupted writes.
+ *
+ * @param f Writer (err is set on failure).
+ * @param p Bytes.
+ * @param len Number of bytes.
+ */
+static void kk_format_write(kk_format_t *f, const char *p, size_t len) {
+	ssize_t w;
+
+	while(len && !f->err) {
+		w = write(f->fd, p, len);
+		if(w < 0) {
+			if(EINTR != errno)
+				f->err = 1;
+			continue;
+		}
+		p += w;
+		len -= w;
+	}
+}
+
+int kk_format_flush(kk_format_t *f) {
+	kk_format_write(f, f->buf, f->len);
+	f->len = 0;
+
+	return f->err? -1 : 0;
+}
+
+/**
+ * @brief Make room in the buffer of a writer (flushing it if needed).
+ *
+ * @param f Writer.
+ * @param len Number of bytes about to be appended (at most buffer size).
+ */
+static void kk_format_room(kk_format_t *f, size_t len) {
+	if(f->len + len > f->size)
+		kk_format_flush(f);
+}
+
+/**
+ * @brief Append raw bytes to a writer (blocks larger than the buffer are written directly).
+ *
+ * @param f Writer.
+ * @param p Bytes.
+ * @param len Number of bytes.
+ */
+static void kk_format_append(kk_format_t *f, const char *p, size_t len) {
+	if(len > f->size) {
+		kk_format_flush(f);
+		kk_format_write(f, p, len);
+		return;
+	}
+
+	kk_format_room(f, len);
+	memcpy(&f->buf[f->len], p, len);
+	f->len += len;
+}
+
+int kk_format_text(kk_format_t *f, const char *s) {
+	kk_format_append(f, s, strlen(s));
+
+	return f->err? -1 : 0;
+}
+
+int kk_format_matrix(kk_format_t *f, int n, const double *m) {
+	int i, j;
+	char *p;
+
+	if(KK_FORMAT_BINARY == f->mode) {
+		kk_format_append(f, (const char *) m, (size_t) n * n * sizeof(double));
+		return f->err? -1 : 0;
+	}
+
+	/* Start matrices that would not fit in what is left on a new buffer */
+	kk_format_room(f, ((size_t) n * n * KK_FORMAT_TYPICAL + n + 1 <= f->size)? (size_t) n * n * KK_FORMAT_TYPICAL + n + 1 : 0);
+
+	for(i = 0; i < n; i++) {
+		for(j = 0; j < n; j++) {
+			kk_format_room(f, KK_FORMAT_MAX_CHARS + 2);
+			p = &f->buf[f->len];
+			p[0] = '\t';
+			p[1] = ' ';
+			f->len += 2 + kk_format_double(&p[2], m[(size_t) i * n + j], f->prec);
+		}
+		kk_format_room(f, 1);
+		f->buf[f->len++] = '\n';
+	}
+	kk_format_room(f, 1);
+	f->buf[f->len++] = '\n';
+
+	return f->err? -1 : 0;
+}
+
+int kk_format_free(kk_format_t *f) {
+	int ret = kk_format_flush(f);
+
+	free(f->buf);
+	f->buf = NULL;
+
+	return ret;
+}
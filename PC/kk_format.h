@@ -0,0 +1,158 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Buffered Output)               * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_FORMAT_H
+#define KK_FORMAT_H
+
+#include <stddef.h>
+
+/**
+ * @brief Default buffer size of a writer (bytes).
+ */
+#define KK_FORMAT_BUFFER (1 << 20)
+
+/**
+ * @brief Largest fixed precision (10^KK_FORMAT_MAX_PREC times any value handled without snprintf() is
+ * below 2^53).
+ */
+#define KK_FORMAT_MAX_PREC 9
+
+/**
+ * @brief Precision that selects shortest round-trip output instead of fixed digits.
+ */
+#define KK_FORMAT_SHORTEST -1
+
+/**
+ * @brief Longest text of a single value (shortest or fixed, sign and terminator included).
+ */
+#define KK_FORMAT_MAX_CHARS 352
+
+/**
+ * @brief Output modes.
+ */
+typedef enum {
+	/* Rows of tab-separated text, as print_matrix() in main.c */
+	KK_FORMAT_TEXT = 0,
+	/* Raw row-major doubles in host byte order */
+	KK_FORMAT_BINARY
+} kk_format_mode_t;
+
+/**
+ * @brief Buffered writer on a file descriptor.
+ *
+ * Writers bypass stdio: each thread may own one (on the same descriptor or not) and never waits for
+ * the others while formatting. Bytes go out in a single write() per full buffer, and a matrix that is
+ * expected to fit in what is left of the buffer is never split across two of them.
+ */
+typedef struct {
+	/* Output file descriptor */
+	int fd;
+	/* Output mode */
+	kk_format_mode_t mode;
+	/* Digits after decimal point, or KK_FORMAT_SHORTEST */
+	int prec;
+	/* Buffer, its size and bytes pending */
+	char *buf;
+	size_t size;
+	size_t len;
+	/* Set after any failed write (later output is dropped) */
+	int err;
+} kk_format_t;
+
+/**
+ * @brief Format a double as printf("%.*f", prec, v) would, or as its shortest round-trip text.
+ *
+ * Fixed output is calculated with integer arithmetic whenever the correctly rounded result is certain
+ * (that is, unless v * 10^prec lies within rounding error of a tie, is too large or is not finite, when
+ * snprintf() is used). Output is then byte-identical to printf() in the default rounding mode.
+ *
+ * @param dst Output (at least KK_FORMAT_MAX_CHARS bytes, not terminated).
+ * @param v Value.
+ * @param prec Digits after decimal point (0 to KK_FORMAT_MAX_PREC), or KK_FORMAT_SHORTEST for digits
+ *             that read back as v (Grisu2: the shortest ones for all but about 0.05% of values, which
+ *             get up to 17), laid out as "%.17g" would.
+ *
+ * @return Number of characters written.
+ */
+int kk_format_double(char *dst, double v, int prec);
+
+/**
+ * @brief Initialize a writer.
+ *
+ * @param f Writer.
+ * @param fd Output file descriptor.
+ * @param mode Output mode.
+ * @param prec Digits after decimal point, or KK_FORMAT_SHORTEST (text mode only).
+ * @param size Buffer size (0 for KK_FORMAT_BUFFER, at least 4096 bytes are allocated).
+ *
+ * @return 0 on success, -1 on invalid precision or allocation failure.
+ */
+int kk_format_init(kk_format_t *f, int fd, kk_format_mode_t mode, int prec, size_t size);
+
+/**
+ * @brief Append a string (text mode) or raw bytes (binary mode, excluding terminator) to a writer.
+ *
+ * @param f Writer.
+ * @param s String.
+ *
+ * @return 0 on success, -1 if an earlier or current write failed.
+ */
+int kk_format_text(kk_format_t *f, const char *s);
+
+/**
+ * @brief Append a matrix to a writer.
+ *
+ * In text mode, each element is a tab, a space and the formatted value, each row ends with a newline
+ * and the matrix with an empty line. In binary mode, the n * n doubles are copied as they are.
+ *
+ * @param f Writer.
+ * @param n Size of matrix.
+ * @param m n-by-n row-major matrix.
+ *
+ * @return 0 on success, -1 if an earlier or current write failed.
+ */
+int kk_format_matrix(kk_format_t *f, int n, const double *m);
+
+/**
+ * @brief Write out pending bytes of a writer.
+ *
+ * @param f Writer.
+ *
+ * @return 0 on success, -1 if an earlier or current write failed.
+ */
+int kk_format_flush(kk_format_t *f);
+
+/**
+ * @brief Flush and release a writer (the descriptor is left open).
+ *
+ * @param f Writer.
+ *
+ * @return 0 on success, -1 if an earlier or final write failed.
+ */
+int kk_format_free(kk_format_t *f);
+
+#endif
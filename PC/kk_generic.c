@@ -0,0 +1,72 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Generic Engine)                * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "kk_fixed.h"
+#include "kk_generic.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+/* Vectorizable types get one clone per instruction set, picked by the loader */
+#define KK_GENERIC_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define KK_GENERIC_CLONES
+#endif
+
+/* Single precision */
+#define KK_T float
+#define KK_S(name) name##_f
+#define KK_RESULT kk_result_f_t
+#define KK_ONE 1.0f
+#define KK_MUL(a, b) ((a) * (b))
+#define KK_SUB(a, b) ((a) - (b))
+#define KK_DIV(a, b) ((a) / (b))
+#define KK_ROW_ATTR KK_GENERIC_CLONES
+#include "kk_generic_impl.h"
+
+/* Extended precision (x87, not vectorizable) */
+#define KK_T long double
+#define KK_S(name) name##_l
+#define KK_RESULT kk_result_l_t
+#define KK_ONE 1.0L
+#define KK_MUL(a, b) ((a) * (b))
+#define KK_SUB(a, b) ((a) - (b))
+#define KK_DIV(a, b) ((a) / (b))
+#define KK_ROW_ATTR
+#include "kk_generic_impl.h"
+
+/* Q16.16, with FixedPoint#(16, 16) semantics of the accelerator */
+#define KK_T kk_q16_t
+#define KK_S(name) name##_q
+#define KK_RESULT kk_result_q_t
+#define KK_ONE ((kk_q16_t) 1 << KK_FIXED_FW)
+#define KK_MUL(a, b) kk_fixed_mul((a), (b), KK_FIXED_IW, KK_FIXED_FW)
+#define KK_SUB(a, b) kk_fixed_sub((a), (b), KK_FIXED_IW, KK_FIXED_FW)
+#define KK_DIV(a, b) kk_fixed_div((a), (b), KK_FIXED_IW, KK_FIXED_FW)
+#define KK_ROW_ATTR
+#include "kk_generic_impl.h"
@@ -0,0 +1,67 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Generic Engine)                * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_GENERIC_H
+#define KK_GENERIC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Q16.16 fixed-point element (FixedPoint#(16, 16) bits, converted with kk_fixed_from_double()).
+ */
+typedef int32_t kk_q16_t;
+
+/**
+ * @brief Declare the KK engine for an element type.
+ *
+ * For element type T and suffix S, declares:
+ * - kk_result_S_t: determinant (of type T) and division by zero flag;
+ * - size_t kk_workspace_size_S(int n): scratch memory (in bytes) needed to invert an n-by-n matrix;
+ * - int kk_invert_S(int n, const T *in, T *out, void *mem, kk_result_S_t *res): same as kk_invert(),
+ *   with mem holding kk_workspace_size_S(n) bytes (or NULL to allocate it for the call only).
+ *   Returns 0 on success, -1 if memory could not be allocated.
+ *
+ * @param T Element type.
+ * @param S Suffix of declared names.
+ */
+#define KK_GENERIC_DECLARE(T, S) \
+	typedef struct { \
+		T det; \
+		int divZero; \
+	} kk_result_##S##_t; \
+	size_t kk_workspace_size_##S(int n); \
+	int kk_invert_##S(int n, const T *in, T *out, void *mem, kk_result_##S##_t *res);
+
+/* Single precision (kk_invert_f) */
+KK_GENERIC_DECLARE(float, f)
+/* Extended precision (kk_invert_l) */
+KK_GENERIC_DECLARE(long double, l)
+/* Q16.16, bit-exact with accelerator arithmetic (kk_invert_q) */
+KK_GENERIC_DECLARE(kk_q16_t, q)
+
+#endif
@@ -0,0 +1,141 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Generic Engine)                * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+/*
+ * KK engine template, included by kk_generic.c once per element type. Expects:
+ * - KK_T: element type;
+ * - KK_S(name): name with type suffix appended;
+ * - KK_RESULT: result type;
+ * - KK_ONE: 1 in element type;
+ * - KK_MUL(a, b), KK_SUB(a, b), KK_DIV(a, b): element arithmetic;
+ * - KK_ROW_ATTR: attributes of row kernel (e.g. target clones).
+ * Every parameter is undefined at the end of this file.
+ */
+
+/**
+ * @brief Row kernel: calculate row i of next matrix.
+ *
+ * @param next Row i of next matrix.
+ * @param c0 Row i of current matrix.
+ * @param c1 Row i + 1 of current matrix.
+ * @param p1 Row i + 1 of previous matrix.
+ * @param n Size of matrix.
+ *
+ * @return 1 if any division by zero occurred, 0 otherwise.
+ */
+KK_ROW_ATTR
+static int KK_S(kk_generic_row)(KK_T *restrict next, const KK_T *restrict c0, const KK_T *restrict c1, const KK_T *restrict p1, int n) {
+	int j;
+	/* Division by zero flag, kept as element type so that the loop may still be auto-vectorized */
+	KK_T divZero = 0;
+
+	for(j = 0; j < n; j++) {
+		divZero = (0 == p1[j + 1])? 1 : divZero;
+		next[j] = KK_DIV(KK_SUB(KK_MUL(c0[j], c1[j + 1]), KK_MUL(c1[j], c0[j + 1])), p1[j + 1]);
+	}
+
+	return (0 != divZero);
+}
+
+/**
+ * @brief Replicate row 0 and column 0 of a matrix into row n and column n.
+ *
+ * @param matrix (n+1)-by-(n+1) matrix.
+ * @param n Size of matrix.
+ */
+static void KK_S(kk_generic_halo)(KK_T *matrix, int n) {
+	int i;
+
+	for(i = 0; i < n; i++)
+		matrix[i * (n + 1) + n] = matrix[i * (n + 1)];
+	memcpy(&matrix[n * (n + 1)], matrix, (n + 1) * sizeof(KK_T));
+}
+
+size_t KK_S(kk_workspace_size)(int n) {
+	return 3 * (size_t) (n + 1) * (n + 1) * sizeof(KK_T);
+}
+
+int KK_S(kk_invert)(int n, const KK_T *in, KK_T *out, void *mem, KK_RESULT *res) {
+	int i, j, k, tmp, divZero = 0, s = n + 1;
+	int next = 0, prev = 1, curr = 2;
+	KK_T *matrix_K[3], *scratch = mem;
+
+	if(!scratch) {
+		scratch = malloc(KK_S(kk_workspace_size)(n));
+		if(!scratch)
+			return -1;
+	}
+	for(k = 0; k < 3; k++)
+		matrix_K[k] = &scratch[k * (size_t) s * s];
+
+	/* Transfer matrix, previous matrix starts as ones */
+	for(i = 0; i < n; i++)
+		memcpy(&matrix_K[curr][i * s], &in[i * n], n * sizeof(KK_T));
+	KK_S(kk_generic_halo)(matrix_K[curr], n);
+	for(i = 0; i < s * s; i++)
+		matrix_K[prev][i] = KK_ONE;
+
+	/* KK iterations */
+	for(k = 0; k < n - 1; k++) {
+		for(i = 0; i < n; i++)
+			divZero |= KK_S(kk_generic_row)(&matrix_K[next][i * s], &matrix_K[curr][i * s], &matrix_K[curr][(i + 1) * s], &matrix_K[prev][(i + 1) * s], n);
+		KK_S(kk_generic_halo)(matrix_K[next], n);
+
+		tmp = prev;
+		prev = curr;
+		curr = next;
+		next = tmp;
+	}
+
+	if(res)
+		res->det = matrix_K[curr][0];
+
+	/* Final iteration: element (i, j) of inverse is prev[j + 1][i + 1] / curr[i][j] */
+	for(i = 0; i < n; i++) {
+		for(j = 0; j < n; j++) {
+			divZero |= (0 == matrix_K[curr][i * s + j]);
+			out[i * n + j] = KK_DIV(matrix_K[prev][(j + 1) * s + (i + 1)], matrix_K[curr][i * s + j]);
+		}
+	}
+
+	if(res)
+		res->divZero = divZero;
+
+	if(scratch != mem)
+		free(scratch);
+
+	return 0;
+}
+
+#undef KK_T
+#undef KK_S
+#undef KK_RESULT
+#undef KK_ONE
+#undef KK_MUL
+#undef KK_SUB
+#undef KK_DIV
+#undef KK_ROW_ATTR
@@ -0,0 +1,206 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (LU Fallback)                   * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <math.h>
+#include <string.h>
+
+#include "kk_lu.h"
+
+/**
+ * @brief Subtract a multiple of a row from another (y = y - a * x).
+ *
+ * @param y Row updated.
+ * @param x Row subtracted.
+ * @param a Factor.
+ * @param n Number of elements.
+ */
+static inline void kk_lu_axpy(double *restrict y, const double *restrict x, double a, int n) {
+	int j;
+
+	for(j = 0; j < n; j++)
+		y[j] -= a * x[j];
+}
+
+/**
+ * @brief Swap two rows.
+ *
+ * @param x First row.
+ * @param y Second row.
+ * @param n Number of elements.
+ */
+static void kk_lu_swap(double *restrict x, double *restrict y, int n) {
+	int j;
+	double t;
+
+	for(j = 0; j < n; j++) {
+		t = x[j];
+		x[j] = y[j];
+		y[j] = t;
+	}
+}
+
+/**
+ * @brief Factorize a matrix in place as P A = L U (L has unit diagonal and is stored below U).
+ *
+ * @param a n-by-n matrix, rows s elements apart.
+ * @param n Size of matrix.
+ * @param s Row stride.
+ * @param piv Row swapped with row k at step k.
+ * @param det Determinant.
+ *
+ * @return 1 if a pivot was zero (singular matrix), 0 otherwise.
+ */
+static int kk_lu_factor(double *a, int n, int s, int *piv, double *det) {
+	int i, k, p, k0, kb, rest, singular = 0;
+	double d = 1;
+
+	for(k0 = 0; k0 < n; k0 += KK_LU_BLOCK) {
+		kb = (n - k0 < KK_LU_BLOCK)? n - k0 : KK_LU_BLOCK;
+		rest = n - k0 - kb;
+
+		/* Panel: columns k0 to k0 + kb - 1 only (whole rows are swapped) */
+		for(k = k0; k < k0 + kb; k++) {
+			p = k;
+			for(i = k + 1; i < n; i++) {
+				if(fabs(a[i * s + k]) > fabs(a[p * s + k]))
+					p = i;
+			}
+			piv[k] = p;
+			if(p != k) {
+				kk_lu_swap(&a[k * s], &a[p * s], n);
+				d = -d;
+			}
+
+			d *= a[k * s + k];
+			if(0 == a[k * s + k]) {
+				/* Column is zero from row k down, nothing to eliminate */
+				singular = 1;
+				continue;
+			}
+
+			for(i = k + 1; i < n; i++) {
+				a[i * s + k] /= a[k * s + k];
+				kk_lu_axpy(&a[i * s + k + 1], &a[k * s + k + 1], a[i * s + k], k0 + kb - k - 1);
+			}
+		}
+
+		/* Rows of U right of panel: U12 = L11^-1 A12 */
+		for(k = k0; k < k0 + kb; k++) {
+			for(i = k + 1; i < k0 + kb; i++)
+				kk_lu_axpy(&a[i * s + k0 + kb], &a[k * s + k0 + kb], a[i * s + k], rest);
+		}
+
+		/* Trailing matrix: A22 = A22 - L21 U12, row by row (the kb rows of U12 stay in cache) */
+		for(i = k0 + kb; i < n; i++) {
+			for(k = k0; k < k0 + kb; k++)
+				kk_lu_axpy(&a[i * s + k0 + kb], &a[k * s + k0 + kb], a[i * s + k], rest);
+		}
+	}
+
+	*det = d;
+
+	return singular;
+}
+
+/**
+ * @brief Solve L U X = P (P is the identity with the rows swapped as in factorization), giving A^-1.
+ *
+ * Both substitutions are blocked as the factorization: KK_LU_BLOCK solved rows of X update every
+ * remaining row before moving on.
+ *
+ * @param a Factorized matrix, rows s elements apart.
+ * @param n Size of matrix.
+ * @param s Row stride.
+ * @param piv Row swaps of factorization.
+ * @param x n-by-n row-major solution.
+ */
+static void kk_lu_solve(const double *a, int n, int s, const int *piv, double *x) {
+	int i, j, k, k0, k1;
+
+	memset(x, 0, (size_t) n * n * sizeof(double));
+	for(i = 0; i < n; i++)
+		x[i * n + i] = 1;
+	for(k = 0; k < n; k++) {
+		if(piv[k] != k)
+			kk_lu_swap(&x[k * n], &x[piv[k] * n], n);
+	}
+
+	/* Forward substitution, L has unit diagonal */
+	for(k0 = 0; k0 < n; k0 = k1) {
+		k1 = (n - k0 < KK_LU_BLOCK)? n : k0 + KK_LU_BLOCK;
+		for(k = k0; k < k1; k++) {
+			for(i = k + 1; i < k1; i++)
+				kk_lu_axpy(&x[i * n], &x[k * n], a[i * s + k], n);
+		}
+		for(i = k1; i < n; i++) {
+			for(k = k0; k < k1; k++)
+				kk_lu_axpy(&x[i * n], &x[k * n], a[i * s + k], n);
+		}
+	}
+
+	/* Backward substitution */
+	for(k1 = n; k1 > 0; k1 = k0) {
+		k0 = (k1 < KK_LU_BLOCK)? 0 : k1 - KK_LU_BLOCK;
+		for(k = k1 - 1; k >= k0; k--) {
+			for(j = 0; j < n; j++)
+				x[k * n + j] /= a[k * s + k];
+			for(i = k0; i < k; i++)
+				kk_lu_axpy(&x[i * n], &x[k * n], a[i * s + k], n);
+		}
+		for(i = 0; i < k0; i++) {
+			for(k = k0; k < k1; k++)
+				kk_lu_axpy(&x[i * n], &x[k * n], a[i * s + k], n);
+		}
+	}
+}
+
+int kk_lu_invert(int n, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res) {
+	int i, s, singular;
+	double det, *a;
+	int *piv;
+
+	if(kk_workspace_reserve(ws, n))
+		return -1;
+
+	/* Factors on first scratch matrix, row swaps on second one */
+	s = ws->stride;
+	a = ws->matrix_K[0];
+	piv = (int *) ws->matrix_K[1];
+	for(i = 0; i < n; i++)
+		memcpy(&a[i * s], &in[i * n], n * sizeof(double));
+
+	singular = kk_lu_factor(a, n, s, piv, &det);
+	kk_lu_solve(a, n, s, piv, out);
+
+	if(res) {
+		res->det = det;
+		res->divZero = singular;
+		res->path = KK_PATH_LU;
+	}
+
+	return 0;
+}
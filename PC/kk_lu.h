@@ -0,0 +1,55 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (LU Fallback)                   * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_LU_H
+#define KK_LU_H
+
+#include "kk.h"
+
+/**
+ * @brief Width of the column panels factorized at once (trailing updates run panel by panel).
+ */
+#define KK_LU_BLOCK 32
+
+/**
+ * @brief Invert a matrix with a blocked, partially pivoted LU decomposition.
+ *
+ * Works on any non-singular matrix (no strong non-singularity needed), on the scratch memory of a KK
+ * workspace. Panels of KK_LU_BLOCK columns are factorized first, then the rest of the matrix is
+ * updated by row, KK_LU_BLOCK rows of U at a time, so that the update streams over cached rows.
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param out n-by-n row-major output matrix (may alias in).
+ * @param ws Workspace (pooled workspaces are grown as needed, contents are lost).
+ * @param res Determinant, path (KK_PATH_LU) and singularity as division by zero flag (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold an n-by-n inversion.
+ */
+int kk_lu_invert(int n, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res);
+
+#endif
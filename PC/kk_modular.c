@@ -0,0 +1,366 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Modular Residues)              * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "kk_modular.h"
+
+/**
+ * @brief Interleaved prefix product chains when inverting divisors.
+ */
+#define KK_MODULAR_CHAINS 4
+
+/**
+ * @brief Largest primes below 2^31 kept once found (enough for matrices of a few thousand bits).
+ */
+#define KK_MODULAR_CACHE 64
+
+/**
+ * @brief One residue per lane, and their products.
+ */
+typedef uint32_t kk_lanes_t __attribute__((vector_size(KK_MODULAR_LANES * sizeof(uint32_t))));
+typedef uint64_t kk_wide_t __attribute__((vector_size(KK_MODULAR_LANES * sizeof(uint64_t))));
+
+/**
+ * @brief Deterministic Miller-Rabin test (bases 2, 7 and 61 suffice below 2^32).
+ *
+ * @param n Candidate (below 2^31).
+ *
+ * @return 1 if n is prime, 0 otherwise.
+ */
+static int kk_modular_is_prime(uint32_t n) {
+	static const uint32_t bases[] = {2, 7, 61};
+	static const uint32_t small[] = {3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61};
+	int b, k, r = 0;
+	uint32_t d = n - 1, e, x, y, one, minus;
+	kk_mont_t m;
+
+	if(n < 2)
+		return 0;
+	if(!(n & 1))
+		return 2 == n;
+
+	/* Trial division rejects most candidates before the (much slower) strong probable prime tests */
+	for(b = 0; b < (int) (sizeof(small) / sizeof(small[0])); b++) {
+		if(!(n % small[b]))
+			return n == small[b];
+	}
+
+	while(!(d & 1)) {
+		d >>= 1;
+		r++;
+	}
+
+	/* Powers in Montgomery form (n is odd, which is all Montgomery reduction needs) */
+	m = kk_mont_init(n);
+	one = kk_mont_mul(1, m.r2, n, m.q);
+	minus = n - one;
+
+	for(b = 0; b < 3; b++) {
+		y = kk_mont_mul(bases[b], m.r2, n, m.q);
+		for(x = one, e = d; e; e >>= 1) {
+			if(e & 1)
+				x = kk_mont_mul(x, y, n, m.q);
+			y = kk_mont_mul(y, y, n, m.q);
+		}
+		for(k = 1; (k < r) && (x != one) && (x != minus); k++)
+			x = kk_mont_mul(x, x, n, m.q);
+		if((x != one) && (x != minus))
+			return 0;
+	}
+
+	return 1;
+}
+
+kk_mont_t kk_mont_init(uint32_t p) {
+	int k;
+	uint32_t inv = p;
+	kk_mont_t m;
+
+	/* Newton iteration doubles correct bits of p^-1 mod 2^32 (p * p = 1 mod 8) */
+	for(k = 0; k < 4; k++)
+		inv *= 2 - p * inv;
+
+	m.p = p;
+	m.q = -inv;
+	m.r2 = (uint32_t) ((UINT64_MAX % p + 1) % p);
+
+	return m;
+}
+
+uint32_t kk_mont_inv(uint32_t a, kk_mont_t m) {
+	int b;
+	uint32_t r = a;
+
+	/* Fermat: a^(p-2), leading bit of p - 2 is bit 30 */
+	for(b = 29; b >= 0; b--) {
+		r = kk_mont_mul(r, r, m.p, m.q);
+		if(((m.p - 2) >> b) & 1)
+			r = kk_mont_mul(r, a, m.p, m.q);
+	}
+
+	return r;
+}
+
+/* Largest primes below 2^31, in descending order */
+static uint32_t kk_modular_cache[KK_MODULAR_CACHE];
+static pthread_once_t kk_modular_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Search the largest prime below a bound.
+ *
+ * @param below Bound.
+ *
+ * @return Prime.
+ */
+static uint32_t kk_modular_search(uint32_t below) {
+	do {
+		below--;
+	} while(!kk_modular_is_prime(below));
+
+	return below;
+}
+
+/**
+ * @brief Fill prime cache (runs once).
+ */
+static void kk_modular_fill(void) {
+	int k;
+	uint32_t p = (uint32_t) 1 << 31;
+
+	for(k = 0; k < KK_MODULAR_CACHE; k++)
+		kk_modular_cache[k] = p = kk_modular_search(p);
+}
+
+uint32_t kk_modular_prime(uint32_t below) {
+	int lo = 0, hi = KK_MODULAR_CACHE, mid;
+
+	pthread_once(&kk_modular_once, kk_modular_fill);
+	if(below <= kk_modular_cache[KK_MODULAR_CACHE - 1])
+		return kk_modular_search(below);
+
+	/* First cached prime below bound */
+	while(lo < hi) {
+		mid = (lo + hi) / 2;
+		if(kk_modular_cache[mid] < below)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return kk_modular_cache[lo];
+}
+
+size_t kk_modular_size(int n) {
+	size_t s = n + 1;
+
+	/* Three register matrices plus inverses of divisors */
+	return (3 * s * s + (size_t) n * n) * sizeof(kk_lanes_t);
+}
+
+/**
+ * @brief Montgomery product, lane-wise.
+ *
+ * @param a First factors.
+ * @param b Second factors.
+ * @param p Primes.
+ * @param q -p^-1 mod R.
+ *
+ * @return Products.
+ */
+static inline __attribute__((always_inline)) kk_lanes_t kk_lanes_mul(kk_lanes_t a, kk_lanes_t b, kk_lanes_t p, kk_lanes_t q) {
+	kk_wide_t t = __builtin_convertvector(a, kk_wide_t) * __builtin_convertvector(b, kk_wide_t);
+	kk_lanes_t m = __builtin_convertvector(t, kk_lanes_t) * q;
+	kk_lanes_t u = __builtin_convertvector((t + __builtin_convertvector(m, kk_wide_t) * __builtin_convertvector(p, kk_wide_t)) >> 32, kk_lanes_t);
+
+	return u - ((kk_lanes_t) (u >= p) & p);
+}
+
+/**
+ * @brief Invert the divisors of a KK iteration (elements (i + 1, j + 1) of previous matrix), lane-wise.
+ *
+ * Prefix products need a single inversion per lane; inverse of element e is then the product of
+ * elements before e over the product up to e. Products are split in KK_MODULAR_CHAINS interleaved
+ * chains so that multiplications overlap. Zero residues are taken as one, and their lane flagged.
+ *
+ * @param inv Inverses (rows * cols elements).
+ * @param prev Previous register matrix.
+ * @param s Row stride (in elements) of register matrices.
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ * @param primes Primes.
+ * @param consts Montgomery constants of primes.
+ * @param ones Montgomery form of one, per prime.
+ * @param zero Set (all ones) on lanes with a zero divisor.
+ */
+static inline __attribute__((always_inline)) void kk_modular_invert(kk_lanes_t *restrict inv, const kk_lanes_t *restrict prev, int s, int rows, int cols, const kk_lanes_t *primes, const kk_lanes_t *consts, const kk_lanes_t *ones, kk_lanes_t *zero) {
+	int i, j, c, b, tail = cols % KK_MODULAR_CHAINS;
+	kk_lanes_t p = *primes, q = *consts, one = *ones;
+	kk_lanes_t x, t, all, acc[KK_MODULAR_CHAINS], r[KK_MODULAR_CHAINS], bit, two = one - one + 2;
+	const kk_lanes_t *d;
+	kk_lanes_t *v;
+
+	for(c = 0; c < KK_MODULAR_CHAINS; c++)
+		acc[c] = one;
+
+	/* Column j goes to chain j % KK_MODULAR_CHAINS, columns of incomplete last block to chain 0 */
+	for(i = 0; i < rows; i++) {
+		d = prev + (i + 1) * s + 1;
+		v = inv + i * cols;
+		for(j = 0; j < cols - tail; j += KK_MODULAR_CHAINS) {
+			for(c = 0; c < KK_MODULAR_CHAINS; c++) {
+				x = d[j + c];
+				*zero |= (kk_lanes_t) (x == 0);
+				x |= (kk_lanes_t) (x == 0) & one;
+				v[j + c] = acc[c];
+				acc[c] = kk_lanes_mul(acc[c], x, p, q);
+			}
+		}
+		for(; j < cols; j++) {
+			x = d[j];
+			*zero |= (kk_lanes_t) (x == 0);
+			x |= (kk_lanes_t) (x == 0) & one;
+			v[j] = acc[0];
+			acc[0] = kk_lanes_mul(acc[0], x, p, q);
+		}
+	}
+
+	/* Single inversion (Fermat: all^(p-2), leading bit of p - 2 is bit 30) */
+	all = acc[0];
+	for(c = 1; c < KK_MODULAR_CHAINS; c++)
+		all = kk_lanes_mul(all, acc[c], p, q);
+	t = all;
+	for(b = 29; b >= 0; b--) {
+		t = kk_lanes_mul(t, t, p, q);
+		bit = (kk_lanes_t) ((((p - two) >> b) & 1) != 0);
+		t = (kk_lanes_mul(t, all, p, q) & bit) | (t & ~bit);
+	}
+
+	/* Inverse of each chain: inverse of all times the other chains */
+	for(c = 0; c < KK_MODULAR_CHAINS; c++) {
+		r[c] = t;
+		for(b = 0; b < KK_MODULAR_CHAINS; b++) {
+			if(b != c)
+				r[c] = kk_lanes_mul(r[c], acc[b], p, q);
+		}
+	}
+
+	/* Same walk backwards: inverse of element is product before it over product up to it */
+	for(i = rows - 1; i >= 0; i--) {
+		d = prev + (i + 1) * s + 1;
+		v = inv + i * cols;
+		for(j = cols - 1; j >= cols - tail; j--) {
+			x = d[j];
+			x |= (kk_lanes_t) (x == 0) & one;
+			v[j] = kk_lanes_mul(r[0], v[j], p, q);
+			r[0] = kk_lanes_mul(r[0], x, p, q);
+		}
+		for(j = cols - tail - KK_MODULAR_CHAINS; j >= 0; j -= KK_MODULAR_CHAINS) {
+			for(c = KK_MODULAR_CHAINS - 1; c >= 0; c--) {
+				x = d[j + c];
+				x |= (kk_lanes_t) (x == 0) & one;
+				v[j + c] = kk_lanes_mul(r[c], v[j + c], p, q);
+				r[c] = kk_lanes_mul(r[c], x, p, q);
+			}
+		}
+	}
+}
+
+KK_MODULAR_CLONES unsigned kk_modular_run(int n, const int64_t *in, const kk_mont_t *mont, uint32_t *out, size_t stride, void *mem) {
+	int i, j, k, l, s = n + 1, rows, cols, prev = 0, curr = 1, next = 2;
+	size_t area = (size_t) s * s;
+	int64_t r;
+	unsigned mask = 0;
+	kk_lanes_t a, b, p, q, one, r2, zero, raw = {0};
+	kk_lanes_t *m = mem, *inv = m + 3 * area, *x, *c0, *c1, *v;
+
+	for(l = 0; l < KK_MODULAR_LANES; l++) {
+		p[l] = mont[l].p;
+		q[l] = mont[l].q;
+		r2[l] = mont[l].r2;
+	}
+	one = kk_lanes_mul(r2 - r2 + 1, r2, p, q);
+	zero = p - p;
+
+	/* Ones on previous register, input (with halo, in Montgomery form) on current one */
+	for(i = 0; i < s; i++) {
+		for(j = 0; j < s; j++) {
+			for(l = 0; l < KK_MODULAR_LANES; l++) {
+				r = in[(i % n) * n + (j % n)] % (int64_t) p[l];
+				raw[l] = (r < 0)? (uint32_t) (r + p[l]) : (uint32_t) r;
+			}
+			m[i * s + j] = one;
+			m[area + i * s + j] = kk_lanes_mul(raw, r2, p, q);
+		}
+	}
+
+	for(k = 0; k < n - 1; k++) {
+		/* Last iteration only needs determinant */
+		rows = cols = (n - 2 == k)? 1 : n;
+		kk_modular_invert(inv, m + prev * area, s, rows, cols, &p, &q, &one, &zero);
+
+		for(i = 0; i < rows; i++) {
+			x = m + next * area + i * s;
+			c0 = m + curr * area + i * s;
+			c1 = c0 + s;
+			v = inv + i * cols;
+
+			for(j = 0; j < cols; j++) {
+				a = kk_lanes_mul(c0[j], c1[j + 1], p, q);
+				b = kk_lanes_mul(c1[j], c0[j + 1], p, q);
+				a = a - b + ((kk_lanes_t) (a < b) & p);
+				x[j] = kk_lanes_mul(a, v[j], p, q);
+			}
+			if(cols == n)
+				x[n] = x[0];
+		}
+		if(rows == n)
+			memcpy(m + next * area + n * s, m + next * area, s * sizeof(kk_lanes_t));
+
+		prev = curr;
+		curr = next;
+		next = 3 - prev - curr;
+	}
+
+	/* Back from Montgomery form (times R^-1) */
+	one = p - p + 1;
+	for(i = 0; i < n; i++) {
+		for(j = 0; j < n; j++) {
+			a = kk_lanes_mul(m[prev * area + i * s + j], one, p, q);
+			for(l = 0; l < KK_MODULAR_LANES; l++)
+				out[l * stride + i * n + j] = a[l];
+		}
+	}
+	a = kk_lanes_mul(m[curr * area], one, p, q);
+	for(l = 0; l < KK_MODULAR_LANES; l++) {
+		out[l * stride + n * n] = a[l];
+		mask |= (zero[l]? 1u : 0u) << l;
+	}
+
+	return mask;
+}
@@ -0,0 +1,147 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Modular Residues)              * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_MODULAR_H
+#define KK_MODULAR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Primes run together, one per SIMD lane (products of 31-bit residues fill 64-bit lanes).
+ */
+#define KK_MODULAR_LANES 16
+
+#if defined(__x86_64__) || defined(__i386__)
+/* Residue loops get one clone per instruction set, picked by the loader */
+#define KK_MODULAR_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define KK_MODULAR_CLONES
+#endif
+
+/**
+ * @brief Montgomery constants of an odd prime below 2^31 (R = 2^32).
+ */
+typedef struct {
+	/* Prime */
+	uint32_t p;
+	/* -p^-1 mod R */
+	uint32_t q;
+	/* R^2 mod p */
+	uint32_t r2;
+} kk_mont_t;
+
+/**
+ * @brief Montgomery product a * b / R mod p.
+ *
+ * @param a First factor (below p).
+ * @param b Second factor (below p).
+ * @param p Prime.
+ * @param q -p^-1 mod R.
+ *
+ * @return Product (below p).
+ */
+static inline uint32_t kk_mont_mul(uint32_t a, uint32_t b, uint32_t p, uint32_t q) {
+	uint64_t t = (uint64_t) a * b;
+	uint32_t m = (uint32_t) t * q;
+	uint32_t u = (uint32_t) ((t + (uint64_t) m * p) >> 32);
+
+	return (u >= p)? u - p : u;
+}
+
+/**
+ * @brief Modular difference a - b mod p.
+ *
+ * @param a Minuend (below p).
+ * @param b Subtrahend (below p).
+ * @param p Prime.
+ *
+ * @return Difference (below p).
+ */
+static inline uint32_t kk_mont_sub(uint32_t a, uint32_t b, uint32_t p) {
+	return (a >= b)? a - b : a - b + p;
+}
+
+/**
+ * @brief Compute Montgomery constants of a prime.
+ *
+ * @param p Odd prime below 2^31.
+ *
+ * @return Constants.
+ */
+kk_mont_t kk_mont_init(uint32_t p);
+
+/**
+ * @brief Modular inverse, in Montgomery form (x R -> x^-1 R).
+ *
+ * @param a Element in Montgomery form (not zero).
+ * @param m Constants of prime.
+ *
+ * @return Inverse in Montgomery form.
+ */
+uint32_t kk_mont_inv(uint32_t a, kk_mont_t m);
+
+/**
+ * @brief Return the largest prime below a bound (the largest primes below 2^31 are cached on first use).
+ *
+ * @param below Bound (at most 2^31).
+ *
+ * @return Prime.
+ */
+uint32_t kk_modular_prime(uint32_t below);
+
+/**
+ * @brief Return scratch memory needed by kk_modular_run().
+ *
+ * @param n Size of matrix.
+ *
+ * @return Size in bytes.
+ */
+size_t kk_modular_size(int n);
+
+/**
+ * @brief Run KK iterations of an integer matrix modulo KK_MODULAR_LANES primes at once.
+ *
+ * Elements of the three register matrices hold one residue per lane, so every operation is a vector
+ * operation across primes. Divisions become products by inverses, found for a whole matrix with a
+ * single modular inversion per lane (prefix products).
+ *
+ * For lane l, out[l * stride + i * n + j] receives element (i, j) of the (n-1)-by-(n-1) minors matrix
+ * and out[l * stride + n * n] the determinant, modulo prime l.
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param mont Constants of the primes (one per lane).
+ * @param out Residues (see above).
+ * @param stride Distance between residues of two lanes (at least n * n + 1).
+ * @param mem Scratch memory (kk_modular_size(n) bytes, aligned to 64 bytes).
+ *
+ * @return Mask of lanes that divided by a zero residue (their results are useless).
+ */
+unsigned kk_modular_run(int n, const int64_t *in, const kk_mont_t *mont, uint32_t *out, size_t stride, void *mem);
+
+#endif
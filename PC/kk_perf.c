@@ -0,0 +1,166 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Performance Counters)          * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "kk_perf.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief Type and configuration of each event.
+ */
+static const struct {
+	uint32_t type;
+	uint64_t config;
+} kk_perf_events[KK_PERF_EVENTS] = {
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+	{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+	{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+};
+
+/**
+ * @brief Read an event.
+ *
+ * @param fd Event file descriptor.
+ *
+ * @return Count so far (0 if it could not be read).
+ */
+static uint64_t kk_perf_read(int fd) {
+	uint64_t value;
+
+	return (read(fd, &value, sizeof(value)) == sizeof(value))? value : 0;
+}
+
+int kk_perf_open(kk_perf_t *perf) {
+	int e, available = 0;
+	struct perf_event_attr attr;
+
+	memset(perf, 0, sizeof(*perf));
+
+	for(e = 0; e < KK_PERF_EVENTS; e++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = kk_perf_events[e].type;
+		attr.config = kk_perf_events[e].config;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		/* Calling thread, any CPU; counting starts at once */
+		perf->fd[e] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+		available += (perf->fd[e] >= 0);
+	}
+
+	return available;
+}
+
+void kk_perf_close(kk_perf_t *perf) {
+	int e;
+
+	for(e = 0; e < KK_PERF_EVENTS; e++) {
+		if(perf->fd[e] >= 0)
+			close(perf->fd[e]);
+		perf->fd[e] = -1;
+	}
+}
+
+void kk_perf_begin(kk_perf_t *perf, int section) {
+	int e;
+
+	for(e = 0; e < KK_PERF_EVENTS; e++)
+		perf->start[section][e] = (perf->fd[e] >= 0)? kk_perf_read(perf->fd[e]) : 0;
+}
+
+void kk_perf_end(kk_perf_t *perf, int section) {
+	int e;
+
+	for(e = 0; e < KK_PERF_EVENTS; e++)
+		perf->count[section][e] += (perf->fd[e] >= 0)? kk_perf_read(perf->fd[e]) - perf->start[section][e] : 0;
+}
+#else
+int kk_perf_open(kk_perf_t *perf) {
+	int e;
+
+	memset(perf, 0, sizeof(*perf));
+	for(e = 0; e < KK_PERF_EVENTS; e++)
+		perf->fd[e] = -1;
+
+	return 0;
+}
+
+void kk_perf_close(kk_perf_t *perf) {
+}
+
+void kk_perf_begin(kk_perf_t *perf, int section) {
+}
+
+void kk_perf_end(kk_perf_t *perf, int section) {
+}
+#endif
+
+void kk_perf_report(const kk_perf_t *perf, int sections, const char *const *names) {
+	static const char *events[KK_PERF_EVENTS] = {"cycles", "instructions", "L1D misses", "LLC misses", "branch misses"};
+	int s, e;
+	const uint64_t *c;
+
+	printf("%-24s", "Section");
+	for(e = 0; e < KK_PERF_EVENTS; e++)
+		printf(" %14s", events[e]);
+	printf(" %8s %10s %10s\n", "IPC", "L1D MPKI", "LLC MPKI");
+
+	for(s = 0; s < sections; s++) {
+		c = perf->count[s];
+		printf("%-24s", names[s]);
+		for(e = 0; e < KK_PERF_EVENTS; e++) {
+			if(perf->fd[e] >= 0)
+				printf(" %14llu", (unsigned long long) c[e]);
+			else
+				printf(" %14s", "n/a");
+		}
+
+		/* Ratios need both of their events */
+		if((perf->fd[0] >= 0) && (perf->fd[1] >= 0) && c[0])
+			printf(" %8.2lf", (double) c[1] / c[0]);
+		else
+			printf(" %8s", "n/a");
+		if((perf->fd[1] >= 0) && (perf->fd[2] >= 0) && c[1])
+			printf(" %10.3lf", 1000.0 * c[2] / c[1]);
+		else
+			printf(" %10s", "n/a");
+		if((perf->fd[1] >= 0) && (perf->fd[3] >= 0) && c[1])
+			printf(" %10.3lf\n", 1000.0 * c[3] / c[1]);
+		else
+			printf(" %10s\n", "n/a");
+	}
+}
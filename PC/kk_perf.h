@@ -0,0 +1,105 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Performance Counters)          * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_PERF_H
+#define KK_PERF_H
+
+#include <stdint.h>
+
+/**
+ * @brief Number of hardware events counted (cycles, instructions, L1 data cache read misses, last level
+ * cache misses and branch misses).
+ */
+#define KK_PERF_EVENTS 5
+
+/**
+ * @brief Maximum number of sections (program phases) counted separately.
+ */
+#define KK_PERF_SECTIONS 8
+
+/**
+ * @brief Hardware performance counters of a thread (Linux perf_event_open()), split by section.
+ *
+ * Counters run from kk_perf_open() on; each section accumulates the counts between its
+ * kk_perf_begin() and kk_perf_end() calls, which cost one read() per event. Events this CPU (or
+ * kernel, or virtual machine) does not provide are reported as n/a.
+ */
+typedef struct {
+	/* Event file descriptors (-1 if unavailable) */
+	int fd[KK_PERF_EVENTS];
+	/* Counts at last kk_perf_begin() of each section */
+	uint64_t start[KK_PERF_SECTIONS][KK_PERF_EVENTS];
+	/* Accumulated counts of each section */
+	uint64_t count[KK_PERF_SECTIONS][KK_PERF_EVENTS];
+} kk_perf_t;
+
+/**
+ * @brief Open and start counters of calling thread (user space only).
+ *
+ * @param perf Counters.
+ *
+ * @return Number of events available (0 if perf events are not supported or not allowed, see
+ *         /proc/sys/kernel/perf_event_paranoid).
+ */
+int kk_perf_open(kk_perf_t *perf);
+
+/**
+ * @brief Close counters.
+ *
+ * @param perf Counters.
+ */
+void kk_perf_close(kk_perf_t *perf);
+
+/**
+ * @brief Start counting a section.
+ *
+ * @param perf Counters.
+ * @param section Section index (0 to KK_PERF_SECTIONS - 1).
+ */
+void kk_perf_begin(kk_perf_t *perf, int section);
+
+/**
+ * @brief Stop counting a section (counts are added to those of previous runs of the section).
+ *
+ * @param perf Counters.
+ * @param section Section index.
+ */
+void kk_perf_end(kk_perf_t *perf, int section);
+
+/**
+ * @brief Print counts, instructions per cycle and misses per thousand instructions of each section.
+ *
+ * Low IPC with many last level cache misses per thousand instructions means a section is bound by
+ * memory; high IPC with few misses means it is bound by computation.
+ *
+ * @param perf Counters.
+ * @param sections Number of sections to print (from section 0).
+ * @param names Name of each section.
+ */
+void kk_perf_report(const kk_perf_t *perf, int sections, const char *const *names);
+
+#endif
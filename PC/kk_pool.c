@@ -0,0 +1,433 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Thread Pool)                   * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kk_pool.h"
+
+/**
+ * @brief Spins before a waiting worker starts yielding its CPU.
+ */
+#define KK_POOL_SPINS 1024
+
+/**
+ * @brief Spin barrier counting the times it opened (epoch).
+ *
+ * A single sense bit would flip back if the next job did an odd number of barriers before a slow worker
+ * saw it, leaving that worker spinning for good: an epoch only grows, so late workers always get out.
+ */
+typedef struct {
+	/* Workers still to arrive */
+	int count;
+	/* Times barrier opened, advanced by the last worker to arrive */
+	unsigned epoch;
+	/* Number of workers taking part */
+	int total;
+} kk_barrier_t;
+
+/**
+ * @brief Parallel job.
+ */
+typedef struct {
+	/* Workspace (after kk_transfer()) */
+	kk_workspace_t *ws;
+	/* Inverse output (NULL for iterations only) */
+	double *out;
+	/* Independent tasks instead of KK iterations (see kk_pool_for()), NULL if none */
+	void (*fn)(void *arg, int index, int worker);
+	void *arg;
+	int count;
+	/* Number of workers taking part */
+	int active;
+	/* Barrier epoch when job starts */
+	unsigned epoch;
+	/* 1 to synchronise neighbouring bands through progress counters instead of barriers */
+	int pipelined;
+} kk_job_t;
+
+/**
+ * @brief Per-worker state.
+ */
+typedef struct {
+	/* Owning pool */
+	kk_pool_t *pool;
+	/* Worker index */
+	int id;
+	/* Barrier epoch the worker waits for next, minus one */
+	unsigned epoch;
+	/* Division by zero flag of last job */
+	int divZero;
+	/* Thread handle (unused for worker 0) */
+	pthread_t thread;
+	/* Iterations done by band of worker (pipelined jobs), padded away from next worker's counter */
+	int done;
+	char pad[64];
+} kk_worker_t;
+
+struct kk_pool {
+	/* Number of workers */
+	int threads;
+	/* Workers (worker 0 is the calling thread) */
+	kk_worker_t *workers;
+
+	/* Job start: generation counter protected by lock */
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned long generation;
+	int quit;
+
+	/* Current job (protected by lock) */
+	kk_job_t job;
+
+	/* Barrier between iterations */
+	kk_barrier_t barrier;
+	/* 1 if iterations are pipelined (see kk_pool_set_pipelined()) */
+	int pipelined;
+};
+
+/**
+ * @brief Wait on barrier.
+ *
+ * @param b Barrier.
+ * @param epoch Local epoch of calling worker.
+ */
+static void kk_barrier_wait(kk_barrier_t *b, unsigned *epoch) {
+	int spins = 0;
+
+	++*epoch;
+
+	if(1 == __atomic_fetch_sub(&b->count, 1, __ATOMIC_ACQ_REL)) {
+		/* Last one to arrive: reset and release everyone */
+		__atomic_store_n(&b->count, b->total, __ATOMIC_RELAXED);
+		__atomic_store_n(&b->epoch, *epoch, __ATOMIC_RELEASE);
+	}
+	else {
+		/* Later jobs may have opened it again already (difference taken modulo 2^32) */
+		while((int) (__atomic_load_n(&b->epoch, __ATOMIC_ACQUIRE) - *epoch) < 0) {
+			/* Do not starve other workers when oversubscribed */
+			if(++spins > KK_POOL_SPINS)
+				sched_yield();
+		}
+	}
+}
+
+/**
+ * @brief Wait until a worker's band is done with an iteration.
+ *
+ * @param w Worker.
+ * @param k Iterations the band must have done.
+ */
+static void kk_pool_wait_done(const kk_worker_t *w, int k) {
+	int spins = 0;
+
+	while(__atomic_load_n(&w->done, __ATOMIC_ACQUIRE) < k) {
+		/* Do not starve other workers when oversubscribed */
+		if(++spins > KK_POOL_SPINS)
+			sched_yield();
+	}
+}
+
+/**
+ * @brief Run a job on a worker's row band.
+ *
+ * @param w Worker.
+ * @param job Job.
+ */
+static void kk_pool_work(kk_worker_t *w, kk_job_t job) {
+	kk_pool_t *pool = w->pool;
+	int n = job.fn? 0 : job.ws->n, lo = (n * w->id) / job.active, hi = (n * (w->id + 1)) / job.active;
+	int k;
+	/* Local copy of workspace, so that indexes are rotated without sharing writes */
+	kk_workspace_t local;
+	/* Bands above and below (row n of last band is row 0 of first one) */
+	const kk_worker_t *above = &pool->workers[(w->id + job.active - 1) % job.active];
+	const kk_worker_t *below = &pool->workers[(w->id + 1) % job.active];
+
+	w->epoch = job.epoch;
+	w->divZero = 0;
+
+	if(job.fn) {
+		for(k = w->id; k < job.count; k += job.active)
+			job.fn(job.arg, k, w->id);
+		kk_barrier_wait(&pool->barrier, &w->epoch);
+		return;
+	}
+
+	local = *job.ws;
+
+	if(job.pipelined) {
+		/*
+		 * Iteration k + 1 of a band reads rows of iterations k and k - 1 up to its first row below,
+		 * and overwrites iteration k - 2, whose first row the band above still reads until it is
+		 * done with iteration k. Bands therefore only wait for their two neighbours, and never get
+		 * more than one iteration ahead of them.
+		 */
+		for(k = local.k; k < n - 1; k++) {
+			kk_pool_wait_done(above, k);
+			kk_pool_wait_done(below, k);
+			w->divZero |= kk_step_rows(&local, lo, hi);
+			__atomic_store_n(&w->done, k + 1, __ATOMIC_RELEASE);
+			kk_rotate(&local, 0);
+		}
+
+		/* Final iteration reads every row, and caller reads divZero of every worker */
+		kk_barrier_wait(&pool->barrier, &w->epoch);
+	}
+	else {
+		for(k = local.k; k < n - 1; k++) {
+			w->divZero |= kk_step_rows(&local, lo, hi);
+			kk_barrier_wait(&pool->barrier, &w->epoch);
+			kk_rotate(&local, 0);
+		}
+	}
+
+	if(job.out) {
+		w->divZero |= kk_final_rows(&local, job.out, lo, hi);
+		kk_barrier_wait(&pool->barrier, &w->epoch);
+	}
+}
+
+/**
+ * @brief Worker thread: wait for jobs and run them.
+ *
+ * @param arg Worker.
+ *
+ * @return Nothing.
+ */
+static void *kk_pool_thread(void *arg) {
+	kk_worker_t *w = arg;
+	kk_pool_t *pool = w->pool;
+	unsigned long seen = 0;
+	kk_job_t job;
+
+	for(;;) {
+		pthread_mutex_lock(&pool->lock);
+		while(!pool->quit && (pool->generation == seen))
+			pthread_cond_wait(&pool->cond, &pool->lock);
+		if(pool->quit) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		seen = pool->generation;
+		job = pool->job;
+		pthread_mutex_unlock(&pool->lock);
+
+		if(w->id < job.active)
+			kk_pool_work(w, job);
+	}
+
+	return NULL;
+}
+
+kk_pool_t *kk_pool_create(int threads) {
+	int t, c, ncpu, skip;
+	cpu_set_t allowed, set;
+	kk_pool_t *pool;
+
+	if(threads < 1)
+		return NULL;
+
+	pool = calloc(1, sizeof(*pool));
+	if(!pool)
+		return NULL;
+	pool->workers = calloc(threads, sizeof(kk_worker_t));
+	if(!pool->workers) {
+		free(pool);
+		return NULL;
+	}
+
+	pool->threads = threads;
+	pool->pipelined = 1;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+
+	CPU_ZERO(&allowed);
+	if(sched_getaffinity(0, sizeof(allowed), &allowed))
+		CPU_SET(0, &allowed);
+	ncpu = CPU_COUNT(&allowed);
+
+	for(t = 0; t < threads; t++) {
+		pool->workers[t].pool = pool;
+		pool->workers[t].id = t;
+		if(!t)
+			continue;
+
+		if(pthread_create(&pool->workers[t].thread, NULL, kk_pool_thread, &pool->workers[t])) {
+			pool->threads = t;
+			kk_pool_destroy(pool);
+			return NULL;
+		}
+
+		/* Pin worker t to the (t % ncpu)-th allowed CPU */
+		CPU_ZERO(&set);
+		skip = t % ncpu;
+		for(c = 0; c < CPU_SETSIZE; c++) {
+			if(CPU_ISSET(c, &allowed) && (0 == skip--)) {
+				CPU_SET(c, &set);
+				break;
+			}
+		}
+		pthread_setaffinity_np(pool->workers[t].thread, sizeof(set), &set);
+	}
+
+	return pool;
+}
+
+void kk_pool_destroy(kk_pool_t *pool) {
+	int t;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = 1;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	for(t = 1; t < pool->threads; t++)
+		pthread_join(pool->workers[t].thread, NULL);
+
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->workers);
+	free(pool);
+}
+
+int kk_pool_threads(const kk_pool_t *pool) {
+	return pool->threads;
+}
+
+void kk_pool_set_pipelined(kk_pool_t *pool, int pipelined) {
+	pool->pipelined = pipelined;
+}
+
+/**
+ * @brief Wake up workers for a job and take part as worker 0 (returns once every worker reached its last barrier).
+ *
+ * @param pool Pool.
+ * @param job Job (job.active workers, at least 2).
+ */
+static void kk_pool_launch(kk_pool_t *pool, kk_job_t job) {
+	pool->barrier.total = pool->barrier.count = job.active;
+	job.epoch = pool->barrier.epoch;
+
+	/* Wake up workers */
+	pthread_mutex_lock(&pool->lock);
+	pool->job = job;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+
+	kk_pool_work(&pool->workers[0], job);
+}
+
+/**
+ * @brief Run a job (iterations, plus final iteration if out is not NULL) on the pool.
+ *
+ * @param pool Pool.
+ * @param ws Workspace (after kk_transfer()).
+ * @param out Inverse output (NULL for iterations only).
+ *
+ * @return 1 if any division by zero occurred, 0 otherwise.
+ */
+static int kk_pool_run(kk_pool_t *pool, kk_workspace_t *ws, double *out) {
+	int t, divZero = 0;
+	kk_job_t job;
+
+	/* Small matrices use fewer workers */
+	memset(&job, 0, sizeof(job));
+	job.ws = ws;
+	job.out = out;
+	job.pipelined = pool->pipelined;
+	job.active = ws->n / KK_POOL_MIN_ROWS;
+	if(job.active > pool->threads)
+		job.active = pool->threads;
+
+	if(job.active <= 1) {
+		kk_iterate(ws);
+		if(out)
+			kk_final(ws, out);
+		return ws->divZero;
+	}
+
+	/* Progress counters are published to workers along with the job */
+	for(t = 0; t < job.active; t++)
+		pool->workers[t].done = ws->k;
+
+	kk_pool_launch(pool, job);
+
+	/* Last barrier of the job guarantees every worker is done */
+	for(t = 0; t < job.active; t++)
+		divZero |= pool->workers[t].divZero;
+
+	/* Bring workspace to the state kk_iterate() would leave it */
+	while(ws->k < ws->n - 1)
+		kk_rotate(ws, 0);
+	ws->divZero |= divZero;
+
+	return ws->divZero;
+}
+
+int kk_pool_iterate(kk_pool_t *pool, kk_workspace_t *ws) {
+	return kk_pool_run(pool, ws, NULL);
+}
+
+int kk_pool_invert(kk_pool_t *pool, int n, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res) {
+	if(kk_workspace_reserve(ws, n))
+		return -1;
+
+	kk_transfer(ws, n, in);
+	kk_pool_run(pool, ws, out);
+
+	if(res) {
+		res->det = kk_getdetelem(ws, 0, 0);
+		res->divZero = ws->divZero;
+		res->path = KK_PATH_KK;
+	}
+
+	return 0;
+}
+
+void kk_pool_for(kk_pool_t *pool, int count, void (*fn)(void *arg, int index, int worker), void *arg) {
+	int t;
+	kk_job_t job;
+
+	memset(&job, 0, sizeof(job));
+	job.fn = fn;
+	job.arg = arg;
+	job.count = count;
+	job.active = (count < pool->threads)? count : pool->threads;
+
+	if(job.active <= 1) {
+		for(t = 0; t < count; t++)
+			fn(arg, t, 0);
+		return;
+	}
+
+	kk_pool_launch(pool, job);
+}
@@ -0,0 +1,117 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Thread Pool)                   * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_POOL_H
+#define KK_POOL_H
+
+#include "kk.h"
+
+/**
+ * @brief Minimum number of rows given to each worker (smaller matrices use fewer workers).
+ */
+#define KK_POOL_MIN_ROWS 16
+
+/**
+ * @brief Persistent pool of core-pinned workers running KK iterations on row bands.
+ */
+typedef struct kk_pool kk_pool_t;
+
+/**
+ * @brief Create a pool.
+ *
+ * Calling thread takes part as worker 0, so threads - 1 threads are spawned. Spawned workers are
+ * pinned round-robin to the CPUs this process may run on.
+ *
+ * @param threads Number of workers (at least 1).
+ *
+ * @return Pool, or NULL on failure.
+ */
+kk_pool_t *kk_pool_create(int threads);
+
+/**
+ * @brief Stop workers and release a pool.
+ *
+ * @param pool Pool.
+ */
+void kk_pool_destroy(kk_pool_t *pool);
+
+/**
+ * @brief Return number of workers of a pool.
+ *
+ * @param pool Pool.
+ *
+ * @return Number of workers.
+ */
+int kk_pool_threads(const kk_pool_t *pool);
+
+/**
+ * @brief Choose how workers of a pool synchronise between KK iterations.
+ *
+ * Pipelined pools (the default) let each row band start its next iteration as soon as the bands
+ * above and below are done with the current one, through per-band progress counters. Otherwise,
+ * every iteration ends on a barrier across all workers. Results are the same either way.
+ *
+ * @param pool Pool.
+ * @param pipelined 1 for pipelined iterations, 0 for a barrier per iteration.
+ */
+void kk_pool_set_pipelined(kk_pool_t *pool, int pipelined);
+
+/**
+ * @brief Run the remaining KK iterations in parallel (same result as kk_iterate()).
+ *
+ * @param pool Pool (one parallel operation at a time).
+ * @param ws Workspace (after kk_transfer()).
+ *
+ * @return 1 if any division by zero occurred, 0 otherwise.
+ */
+int kk_pool_iterate(kk_pool_t *pool, kk_workspace_t *ws);
+
+/**
+ * @brief Invert a matrix in parallel (same result as kk_invert()).
+ *
+ * @param pool Pool (one parallel operation at a time).
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param out n-by-n row-major output matrix (may alias in).
+ * @param ws Workspace (pooled workspaces are grown as needed).
+ * @param res Determinant and division by zero flag (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold an n-by-n inversion.
+ */
+int kk_pool_invert(kk_pool_t *pool, int n, const double *in, double *out, kk_workspace_t *ws, kk_result_t *res);
+
+/**
+ * @brief Run independent tasks on the pool (task t runs on worker t % threads, workers in parallel).
+ *
+ * @param pool Pool (one parallel operation at a time).
+ * @param count Number of tasks.
+ * @param fn Task function, given arg, task index and worker index (so that workers may keep scratch).
+ * @param arg Argument of task function.
+ */
+void kk_pool_for(kk_pool_t *pool, int count, void (*fn)(void *arg, int index, int worker), void *arg);
+
+#endif
@@ -0,0 +1,336 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Preconditioning)               * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <math.h>
+#include <string.h>
+
+#include "kk_lu.h"
+#include "kk_precond.h"
+
+/**
+ * @brief Scratch of a preconditioned inversion (after the KK matrices of the workspace).
+ */
+typedef struct {
+	/* Transformed matrix, then inverse being untransformed (n-by-n) */
+	double *mat;
+	/* One row */
+	double *row;
+	/* Butterfly factors of each level, left (row) side and right (column) side */
+	double *rs, *cs;
+	/* Row and column permutations */
+	int *pr, *pc;
+	/* Butterfly levels applied */
+	int levels;
+} kk_precond_scratch_t;
+
+/**
+ * @brief Return number of butterfly levels mixing every index with all others.
+ *
+ * @param n Size of matrix.
+ *
+ * @return ceil(log2(n)).
+ */
+static int kk_precond_levels(int n) {
+	int h, l = 0;
+
+	for(h = 1; h < n; h *= 2)
+		l++;
+
+	return l;
+}
+
+/**
+ * @brief Pseudo-random generator (SplitMix64), so that retries are reproducible everywhere.
+ *
+ * @param state Generator state.
+ *
+ * @return Next 64 random bits.
+ */
+static uint64_t kk_precond_rand(uint64_t *state) {
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+	return z ^ (z >> 31);
+}
+
+/**
+ * @brief Draw the transforms of a retry.
+ *
+ * Butterfly factors are exp(u / 10), u uniform in [-0.5, 0.5) (as in Parker's random butterfly
+ * transform), so that butterflies stay close to orthogonal.
+ *
+ * @param n Size of matrix.
+ * @param flags Transforms applied.
+ * @param seed Seed.
+ * @param sc Scratch receiving the transforms.
+ */
+static void kk_precond_draw(int n, int flags, uint64_t seed, kk_precond_scratch_t *sc) {
+	int i, k, t;
+	uint64_t state = seed;
+
+	for(i = 0; i < n; i++)
+		sc->pr[i] = sc->pc[i] = i;
+
+	if(flags & KK_PRECOND_PERMUTE) {
+		/* Fisher-Yates */
+		for(i = n - 1; i > 0; i--) {
+			k = (int) (kk_precond_rand(&state) % (uint64_t) (i + 1));
+			t = sc->pr[i];
+			sc->pr[i] = sc->pr[k];
+			sc->pr[k] = t;
+			k = (int) (kk_precond_rand(&state) % (uint64_t) (i + 1));
+			t = sc->pc[i];
+			sc->pc[i] = sc->pc[k];
+			sc->pc[k] = t;
+		}
+	}
+
+	sc->levels = (flags & KK_PRECOND_BUTTERFLY)? kk_precond_levels(n) : 0;
+	for(i = 0; i < sc->levels * n; i++) {
+		sc->rs[i] = exp(((kk_precond_rand(&state) >> 11) * 0x1p-53 - 0.5) / 10);
+		sc->cs[i] = exp(((kk_precond_rand(&state) >> 11) * 0x1p-53 - 0.5) / 10);
+	}
+}
+
+/**
+ * @brief Butterfly on a pair of elements.
+ *
+ * @param xp Element p.
+ * @param xq Element q.
+ * @param rp Factor of p.
+ * @param rq Factor of q.
+ * @param transposed 1 for the transposed butterfly.
+ */
+static inline void kk_precond_pair(double *xp, double *xq, double rp, double rq, int transposed) {
+	double a, b;
+
+	if(transposed) {
+		a = *xp;
+		b = *xq;
+		*xp = (a + b) * (rp * M_SQRT1_2);
+		*xq = (a - b) * (rq * M_SQRT1_2);
+	}
+	else {
+		a = rp * *xp;
+		b = rq * *xq;
+		*xp = (a + b) * M_SQRT1_2;
+		*xq = (a - b) * M_SQRT1_2;
+	}
+}
+
+/**
+ * @brief Apply one level of butterflies, to rows (left product) or to columns (right product).
+ *
+ * Level pairs index p with q = p + h in each block of 2h indexes. A butterfly maps (x_p, x_q) to
+ * (r_p x_p + r_q x_q, r_p x_p - r_q x_q) / sqrt(2), and its transpose to
+ * ((x_p + x_q) r_p, (x_p - x_q) r_q) / sqrt(2). Indexes with no pair are scaled by r_p.
+ *
+ * @param m n-by-n row-major matrix.
+ * @param n Size of matrix.
+ * @param h Half block size.
+ * @param r Factors (n).
+ * @param rows 1 to combine rows, 0 to combine columns.
+ * @param transposed 1 for transposed butterflies.
+ */
+static void kk_precond_level(double *m, int n, int h, const double *r, int rows, int transposed) {
+	int b, p, q, i, j;
+
+	for(b = 0; b < n; b += 2 * h) {
+		for(p = b; (p < b + h) && (p < n); p++) {
+			q = p + h;
+			if(q >= n) {
+				for(i = 0; i < n; i++)
+					m[rows? (p * n + i) : (i * n + p)] *= r[p];
+			}
+			else if(rows) {
+				for(j = 0; j < n; j++)
+					kk_precond_pair(&m[p * n + j], &m[q * n + j], r[p], r[q], transposed);
+			}
+			else {
+				for(i = 0; i < n; i++)
+					kk_precond_pair(&m[i * n + p], &m[i * n + q], r[p], r[q], transposed);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Return determinant of a product of butterfly levels.
+ *
+ * @param n Size of matrix.
+ * @param levels Number of levels.
+ * @param r Factors of all levels.
+ *
+ * @return Determinant (a pair contributes -r_p r_q, an unpaired index r_p).
+ */
+static double kk_precond_det(int n, int levels, const double *r) {
+	int l, h, b, p;
+	double det = 1;
+
+	for(l = 0, h = 1; l < levels; l++, h *= 2, r += n) {
+		for(b = 0; b < n; b += 2 * h) {
+			for(p = b; (p < b + h) && (p < n); p++)
+				det *= (p + h < n)? -r[p] * r[p + h] : r[p];
+		}
+	}
+
+	return det;
+}
+
+/**
+ * @brief Return sign of a permutation.
+ *
+ * @param n Size of permutation.
+ * @param p Permutation.
+ * @param seen n flags (scratch).
+ *
+ * @return 1 or -1.
+ */
+static double kk_precond_sign(int n, const int *p, double *seen) {
+	int i, k;
+	double sign = 1;
+
+	for(i = 0; i < n; i++)
+		seen[i] = 0;
+
+	/* Cycle of length c counts c - 1 transpositions */
+	for(i = 0; i < n; i++) {
+		if(seen[i])
+			continue;
+		for(k = p[i], seen[i] = 1; k != i; k = p[k]) {
+			seen[k] = 1;
+			sign = -sign;
+		}
+	}
+
+	return sign;
+}
+
+/**
+ * @brief Build M = S B T^T, with B[i][j] = A[pr[i]][pc[j]], S = S_L ... S_1 and T = T_L ... T_1.
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix (A).
+ * @param sc Scratch (M is written to sc->mat).
+ */
+static void kk_precond_apply(int n, const double *in, kk_precond_scratch_t *sc) {
+	int i, j, l;
+
+	for(i = 0; i < n; i++) {
+		for(j = 0; j < n; j++)
+			sc->mat[i * n + j] = in[sc->pr[i] * n + sc->pc[j]];
+	}
+
+	/* Left and right products commute, so levels of both sides are interleaved */
+	for(l = 0; l < sc->levels; l++) {
+		kk_precond_level(sc->mat, n, 1 << l, sc->rs + (size_t) l * n, 1, 0);
+		kk_precond_level(sc->mat, n, 1 << l, sc->cs + (size_t) l * n, 0, 0);
+	}
+}
+
+/**
+ * @brief Recover A^-1 from X = M^-1: B^-1 = T^T X S, then A^-1[pc[i]][pr[j]] = B^-1[i][j].
+ *
+ * @param n Size of matrix.
+ * @param out X on entry, A^-1 on exit (n-by-n row-major).
+ * @param sc Scratch.
+ */
+static void kk_precond_undo(int n, double *out, kk_precond_scratch_t *sc) {
+	int i, j, l;
+
+	/* T^T = T_1^T ... T_L^T on the left and S = S_L ... S_1 on the right, innermost levels first */
+	for(l = sc->levels - 1; l >= 0; l--) {
+		kk_precond_level(out, n, 1 << l, sc->cs + (size_t) l * n, 1, 1);
+		kk_precond_level(out, n, 1 << l, sc->rs + (size_t) l * n, 0, 1);
+	}
+
+	for(i = 0; i < n; i++) {
+		for(j = 0; j < n; j++)
+			sc->mat[sc->pc[i] * n + sc->pr[j]] = out[i * n + j];
+	}
+	memcpy(out, sc->mat, (size_t) n * n * sizeof(double));
+}
+
+size_t kk_precond_size(int n) {
+	/* Matrix, row and butterfly factors, then permutations */
+	return kk_workspace_size(n) + ((size_t) n * n + (size_t) n + 2 * (size_t) kk_precond_levels(n) * n) * sizeof(double) + 2 * (size_t) n * sizeof(int);
+}
+
+int kk_precond_invert(int n, const double *in, double *out, kk_workspace_t *ws, const kk_precond_t *opt, kk_precond_result_t *res) {
+	int t, broken;
+	double det;
+	kk_precond_scratch_t sc;
+
+	if(kk_workspace_grow(ws, kk_precond_size(n)) || kk_workspace_reserve(ws, n))
+		return -1;
+
+	sc.mat = (double *) ((char *) ws->mem + kk_workspace_size(n));
+	sc.row = sc.mat + (size_t) n * n;
+	sc.rs = sc.row + n;
+	sc.cs = sc.rs + (size_t) kk_precond_levels(n) * n;
+	sc.pr = (int *) (sc.cs + (size_t) kk_precond_levels(n) * n);
+	sc.pc = sc.pr + n;
+	sc.levels = 0;
+
+	kk_transfer(ws, n, in);
+	broken = kk_iterate_checked(ws, opt->tol);
+
+	for(t = 0; broken && (t < opt->tries); t++) {
+		kk_precond_draw(n, opt->flags, opt->seed + t, &sc);
+		kk_precond_apply(n, in, &sc);
+		kk_transfer(ws, n, sc.mat);
+		broken = kk_iterate_checked(ws, opt->tol);
+	}
+
+	if(res) {
+		res->tries = t;
+		res->seed = t? opt->seed + t - 1 : 0;
+	}
+
+	if(broken)
+		return kk_lu_invert(n, in, out, ws, res? &res->res : NULL);
+
+	kk_final(ws, out);
+	det = kk_getdetelem(ws, 0, 0);
+
+	if(t) {
+		/* det(M) = det(S) sign(Pr) det(A) sign(Pc) det(T) */
+		det /= kk_precond_det(n, sc.levels, sc.rs) * kk_precond_det(n, sc.levels, sc.cs);
+		det *= kk_precond_sign(n, sc.pr, sc.row) * kk_precond_sign(n, sc.pc, sc.row);
+		kk_precond_undo(n, out, &sc);
+	}
+
+	if(res) {
+		res->res.det = det;
+		res->res.divZero = ws->divZero;
+		res->res.path = KK_PATH_KK;
+	}
+
+	return 0;
+}
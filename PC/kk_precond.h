@@ -0,0 +1,106 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Preconditioning)               * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_PRECOND_H
+#define KK_PRECOND_H
+
+#include <stdint.h>
+
+#include "kk.h"
+
+/**
+ * @brief Random row and column permutations.
+ */
+#define KK_PRECOND_PERMUTE 1
+
+/**
+ * @brief Recursive random butterfly transforms on both sides, which mix every row (column) with all
+ * others, so that zero elements and zero minors go away.
+ */
+#define KK_PRECOND_BUTTERFLY 2
+
+/**
+ * @brief Preconditioned retry options.
+ */
+typedef struct {
+	/* Transforms applied on retries (KK_PRECOND_PERMUTE and/or KK_PRECOND_BUTTERFLY) */
+	int flags;
+	/* Maximum number of retries after plain KK breaks down */
+	int tries;
+	/* Seed of first retry (retry t uses seed + t - 1) */
+	uint64_t seed;
+	/* Relative cancellation tolerance (see kk_invert_safe()) */
+	double tol;
+} kk_precond_t;
+
+/**
+ * @brief Result of a preconditioned inversion.
+ */
+typedef struct {
+	/* Determinant, path and division by zero flag (as kk_invert_safe()) */
+	kk_result_t res;
+	/* Retries made (0 if plain KK went through) */
+	int tries;
+	/* Seed of last retry (meaningless if tries is 0) */
+	uint64_t seed;
+} kk_precond_result_t;
+
+/**
+ * @brief Return scratch memory needed by kk_precond_invert() (workspace included).
+ *
+ * @param n Size of matrix.
+ *
+ * @return Size in bytes.
+ */
+size_t kk_precond_size(int n);
+
+/**
+ * @brief Invert a matrix using KK Algorithm, retrying on randomly transformed copies if KK breaks down.
+ *
+ * Many invertible matrices have a zero (or nearly zero) cyclic minor. Such a matrix A is replaced by
+ * M = S Pr A Pc^T T^T, where Pr and Pc are random permutations (O(n^2)) and S and T products of
+ * log2(n) levels of random butterflies (O(n^2 log n)); KK then inverts M, and A^-1 is recovered from
+ * M^-1 = T^-T (Pr A Pc^T)^-1 S^-1 with the same transforms (no inversion needed). Retries use fresh
+ * transforms; once they are exhausted, kk_lu_invert() runs. Every attempt stops at the first breakdown
+ * (see kk_invert_safe()). Retries are reproducible: same seed, same transforms.
+ *
+ * Permutations alone are cheapest, but cannot help when the input has zero elements (they are minors
+ * too). Butterflies are nearly orthogonal, so M is about as well-conditioned as A. Unit triangular
+ * transforms are no option: they leave leading minors unchanged.
+ *
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param out n-by-n row-major output matrix (may alias in).
+ * @param ws Workspace (pooled workspaces are grown as needed, see kk_precond_size()).
+ * @param opt Options.
+ * @param res Result, with retries made and seed of last one (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold an n-by-n preconditioned inversion.
+ */
+int kk_precond_invert(int n, const double *in, double *out, kk_workspace_t *ws, const kk_precond_t *opt, kk_precond_result_t *res);
+
+#endif
@@ -0,0 +1,555 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Job Scheduler)                 * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+#include "kk_sched.h"
+
+/**
+ * @brief Failed steal rounds before an idle worker goes to sleep.
+ */
+#define KK_SCHED_ROUNDS 64
+
+/**
+ * @brief Initial capacity of task queues.
+ */
+#define KK_SCHED_QUEUE 64
+
+/**
+ * @brief Task: a whole job, or a band of rows of current step of a split job.
+ */
+typedef struct {
+	/* Job */
+	kk_sched_job_t *job;
+	/* First row (-1 for a whole job) */
+	int lo;
+	/* One past last row */
+	int hi;
+} kk_task_t;
+
+/**
+ * @brief Growable ring of tasks protected by a lock.
+ *
+ * Worker deques are used LIFO by their owner (tail) and FIFO by thieves (head); the injection
+ * queue of submitted jobs is FIFO.
+ */
+typedef struct {
+	pthread_mutex_t lock;
+	/* Ring buffer */
+	kk_task_t *task;
+	/* Capacity (power of two) */
+	int cap;
+	/* Index of first task */
+	unsigned head;
+	/* Index past last task */
+	unsigned tail;
+} kk_queue_t;
+
+/**
+ * @brief Per-worker state.
+ */
+typedef struct {
+	/* Owning scheduler */
+	kk_sched_t *sched;
+	/* Worker index */
+	int id;
+	/* Victim selection seed */
+	unsigned seed;
+	/* Own deque */
+	kk_queue_t deque;
+	/* Scratchpad for whole jobs */
+	kk_workspace_t ws;
+	pthread_t thread;
+} kk_sched_worker_t;
+
+struct kk_sched {
+	/* Number of workers */
+	int threads;
+	kk_sched_worker_t *workers;
+
+	/* Submitted jobs not yet started */
+	kk_queue_t inject;
+
+	/* Tasks queued anywhere (wakes sleeping workers) */
+	int queued;
+	/* Jobs submitted and not yet finished */
+	int outstanding;
+
+	/* Sleeping workers and waiting callers */
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t idle;
+	int sleepers;
+	int quit;
+};
+
+/**
+ * @brief Initialise a queue.
+ *
+ * @param q Queue.
+ *
+ * @return 0 on success, -1 on failure.
+ */
+static int kk_queue_init(kk_queue_t *q) {
+	q->task = malloc(KK_SCHED_QUEUE * sizeof(kk_task_t));
+	if(!q->task)
+		return -1;
+
+	q->cap = KK_SCHED_QUEUE;
+	q->head = q->tail = 0;
+	pthread_mutex_init(&q->lock, NULL);
+
+	return 0;
+}
+
+/**
+ * @brief Release a queue.
+ *
+ * @param q Queue.
+ */
+static void kk_queue_free(kk_queue_t *q) {
+	pthread_mutex_destroy(&q->lock);
+	free(q->task);
+}
+
+/**
+ * @brief Append tasks at tail of a queue.
+ *
+ * @param q Queue.
+ * @param task Tasks.
+ * @param count Number of tasks.
+ *
+ * @return 0 on success, -1 if queue could not grow.
+ */
+static int kk_queue_push(kk_queue_t *q, const kk_task_t *task, int count) {
+	int i, cap;
+	kk_task_t *grown;
+
+	pthread_mutex_lock(&q->lock);
+
+	if((int) (q->tail - q->head) + count > q->cap) {
+		/* Grow and unwrap ring */
+		for(cap = q->cap; (int) (q->tail - q->head) + count > cap; cap *= 2);
+		grown = malloc(cap * sizeof(kk_task_t));
+		if(!grown) {
+			pthread_mutex_unlock(&q->lock);
+			return -1;
+		}
+		for(i = 0; i < (int) (q->tail - q->head); i++)
+			grown[i] = q->task[(q->head + i) & (q->cap - 1)];
+		free(q->task);
+		q->task = grown;
+		__atomic_store_n(&q->tail, q->tail - q->head, __ATOMIC_RELAXED);
+		__atomic_store_n(&q->head, 0, __ATOMIC_RELAXED);
+		q->cap = cap;
+	}
+
+	for(i = 0; i < count; i++)
+		q->task[(q->tail + i) & (q->cap - 1)] = task[i];
+	__atomic_store_n(&q->tail, q->tail + count, __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock(&q->lock);
+
+	return 0;
+}
+
+/**
+ * @brief Take a task from a queue.
+ *
+ * @param q Queue.
+ * @param task Task taken.
+ * @param tail 1 to take newest task (owner), 0 to take oldest one (thieves, injection queue).
+ *
+ * @return 1 if a task was taken, 0 if queue is empty.
+ */
+static int kk_queue_pop(kk_queue_t *q, kk_task_t *task, int tail) {
+	int found = 0;
+
+	/* Cheap check before locking (a task missed here is found by a later round) */
+	if(__atomic_load_n(&q->head, __ATOMIC_RELAXED) == __atomic_load_n(&q->tail, __ATOMIC_RELAXED))
+		return 0;
+
+	pthread_mutex_lock(&q->lock);
+	if(q->head != q->tail) {
+		if(tail) {
+			*task = q->task[(q->tail - 1) & (q->cap - 1)];
+			__atomic_store_n(&q->tail, q->tail - 1, __ATOMIC_RELAXED);
+		}
+		else {
+			*task = q->task[q->head & (q->cap - 1)];
+			__atomic_store_n(&q->head, q->head + 1, __ATOMIC_RELAXED);
+		}
+		found = 1;
+	}
+	pthread_mutex_unlock(&q->lock);
+
+	return found;
+}
+
+/**
+ * @brief Make tasks available to workers.
+ *
+ * @param sched Scheduler.
+ * @param q Queue receiving the tasks.
+ * @param task Tasks.
+ * @param count Number of tasks.
+ *
+ * @return 0 on success, -1 if queue could not grow.
+ */
+static int kk_sched_publish(kk_sched_t *sched, kk_queue_t *q, const kk_task_t *task, int count) {
+	if(kk_queue_push(q, task, count))
+		return -1;
+
+	__atomic_add_fetch(&sched->queued, count, __ATOMIC_SEQ_CST);
+
+	/* Sleepers register before re-checking queued, so one of both sides always sees the other */
+	if(__atomic_load_n(&sched->sleepers, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&sched->lock);
+		pthread_cond_broadcast(&sched->work);
+		pthread_mutex_unlock(&sched->lock);
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Find a task: own deque first, then submitted jobs, then other workers' deques.
+ *
+ * @param w Worker.
+ * @param task Task found.
+ *
+ * @return 1 if a task was found, 0 otherwise.
+ */
+static int kk_sched_find(kk_sched_worker_t *w, kk_task_t *task) {
+	kk_sched_t *sched = w->sched;
+	int t, victim;
+
+	if(kk_queue_pop(&w->deque, task, 1) || kk_queue_pop(&sched->inject, task, 0))
+		return 1;
+
+	/* Steal oldest task of a random victim, trying every worker once */
+	w->seed = (w->seed * 1103515245) + 12345;
+	victim = (w->seed >> 16) % sched->threads;
+	for(t = 0; t < sched->threads; t++) {
+		if((victim != w->id) && kk_queue_pop(&sched->workers[victim].deque, task, 0))
+			return 1;
+		victim = (victim + 1) % sched->threads;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Mark a job as finished (its result must be set).
+ *
+ * @param sched Scheduler.
+ * @param job Job.
+ */
+static void kk_sched_finish(kk_sched_t *sched, kk_sched_job_t *job) {
+	if(job->done)
+		job->done(job);
+	__atomic_store_n(&job->finished, 1, __ATOMIC_RELEASE);
+
+	if(1 == __atomic_fetch_sub(&sched->outstanding, 1, __ATOMIC_ACQ_REL)) {
+		pthread_mutex_lock(&sched->lock);
+		pthread_cond_broadcast(&sched->idle);
+		pthread_mutex_unlock(&sched->lock);
+	}
+}
+
+/**
+ * @brief Mark a split job as finished, taking its result from its own workspace.
+ *
+ * @param sched Scheduler.
+ * @param job Job (after final iteration).
+ */
+static void kk_sched_finish_split(kk_sched_t *sched, kk_sched_job_t *job) {
+	job->res.det = kk_getdetelem(&job->ws, 0, 0);
+	job->res.divZero = job->ws.divZero;
+	job->res.path = KK_PATH_KK;
+
+	kk_sched_finish(sched, job);
+}
+
+/**
+ * @brief Queue band tasks of the current step of a split job on a worker's deque.
+ *
+ * @param w Worker.
+ * @param job Job.
+ */
+static void kk_sched_split(kk_sched_worker_t *w, kk_sched_job_t *job) {
+	int b, n = job->n, bands = n / KK_SCHED_BAND_ROWS;
+	kk_task_t task[bands];
+
+	for(b = 0; b < bands; b++) {
+		task[b].job = job;
+		task[b].lo = (n * b) / bands;
+		task[b].hi = (n * (b + 1)) / bands;
+	}
+
+	job->pending = bands;
+	if(!kk_sched_publish(w->sched, &w->deque, task, bands))
+		return;
+
+	/* Deque could not grow: finish job on this worker */
+	kk_iterate(&job->ws);
+	kk_final(&job->ws, job->out);
+	job->ws.divZero |= job->divZero;
+	kk_sched_finish_split(w->sched, job);
+}
+
+/**
+ * @brief Run a task.
+ *
+ * @param w Worker.
+ * @param task Task.
+ */
+static void kk_sched_run(kk_sched_worker_t *w, kk_task_t task) {
+	kk_sched_job_t *job = task.job;
+	kk_workspace_t *ws = &job->ws;
+	int n = job->n;
+
+	if(task.lo < 0) {
+		/* Small job runs as a whole on worker's scratchpad (small sizes leave it untouched) */
+		if(n < KK_SCHED_SPLIT_ROWS) {
+			if(kk_invert(n, job->in, job->out, &w->ws, &job->res)) {
+				/* Scratchpad could not grow: out is left untouched */
+				job->res.det = 0.0;
+				job->res.divZero = 1;
+				job->res.path = KK_PATH_KK;
+			}
+			kk_sched_finish(w->sched, job);
+			return;
+		}
+
+		/* Large job: transfer and split first iteration */
+		kk_transfer(ws, n, job->in);
+		kk_sched_split(w, job);
+		return;
+	}
+
+	if(ws->k < n - 1)
+		__atomic_or_fetch(&job->divZero, kk_step_rows(ws, task.lo, task.hi), __ATOMIC_RELAXED);
+	else
+		__atomic_or_fetch(&job->divZero, kk_final_rows(ws, job->out, task.lo, task.hi), __ATOMIC_RELAXED);
+
+	/* Last band of a step moves job forward */
+	if(__atomic_sub_fetch(&job->pending, 1, __ATOMIC_ACQ_REL))
+		return;
+
+	if(ws->k < n - 1) {
+		kk_rotate(ws, 0);
+		kk_sched_split(w, job);
+	}
+	else {
+		ws->divZero |= job->divZero;
+		kk_sched_finish_split(w->sched, job);
+	}
+}
+
+/**
+ * @brief Worker thread: run tasks, stealing when out of work, sleeping when there is none.
+ *
+ * @param arg Worker.
+ *
+ * @return Nothing.
+ */
+static void *kk_sched_thread(void *arg) {
+	kk_sched_worker_t *w = arg;
+	kk_sched_t *sched = w->sched;
+	int rounds = 0;
+	kk_task_t task;
+
+	for(;;) {
+		if(kk_sched_find(w, &task)) {
+			__atomic_sub_fetch(&sched->queued, 1, __ATOMIC_SEQ_CST);
+			kk_sched_run(w, task);
+			rounds = 0;
+			continue;
+		}
+
+		if(++rounds < KK_SCHED_ROUNDS) {
+			sched_yield();
+			continue;
+		}
+
+		/* Nothing to steal for a while: sleep until something is published */
+		pthread_mutex_lock(&sched->lock);
+		__atomic_add_fetch(&sched->sleepers, 1, __ATOMIC_SEQ_CST);
+		while(!sched->quit && !__atomic_load_n(&sched->queued, __ATOMIC_SEQ_CST))
+			pthread_cond_wait(&sched->work, &sched->lock);
+		__atomic_sub_fetch(&sched->sleepers, 1, __ATOMIC_SEQ_CST);
+		if(sched->quit) {
+			pthread_mutex_unlock(&sched->lock);
+			break;
+		}
+		pthread_mutex_unlock(&sched->lock);
+		rounds = 0;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Release a scheduler whose workers are not running.
+ *
+ * @param sched Scheduler.
+ */
+static void kk_sched_free(kk_sched_t *sched) {
+	pthread_cond_destroy(&sched->idle);
+	pthread_cond_destroy(&sched->work);
+	pthread_mutex_destroy(&sched->lock);
+	kk_queue_free(&sched->inject);
+	free(sched->workers);
+	free(sched);
+}
+
+/**
+ * @brief Stop workers and release a scheduler.
+ *
+ * @param sched Scheduler.
+ * @param running Number of worker threads started.
+ */
+static void kk_sched_stop(kk_sched_t *sched, int running) {
+	int t;
+
+	pthread_mutex_lock(&sched->lock);
+	sched->quit = 1;
+	pthread_cond_broadcast(&sched->work);
+	pthread_mutex_unlock(&sched->lock);
+
+	for(t = 0; t < sched->threads; t++) {
+		if(t < running)
+			pthread_join(sched->workers[t].thread, NULL);
+		kk_queue_free(&sched->workers[t].deque);
+		kk_workspace_free(&sched->workers[t].ws);
+	}
+
+	kk_sched_free(sched);
+}
+
+kk_sched_t *kk_sched_create(int threads) {
+	int t;
+	kk_sched_t *sched;
+
+	if(threads < 1)
+		return NULL;
+
+	sched = calloc(1, sizeof(*sched));
+	if(!sched)
+		return NULL;
+	sched->workers = calloc(threads, sizeof(kk_sched_worker_t));
+	if(!sched->workers || kk_queue_init(&sched->inject)) {
+		free(sched->workers);
+		free(sched);
+		return NULL;
+	}
+
+	pthread_mutex_init(&sched->lock, NULL);
+	pthread_cond_init(&sched->work, NULL);
+	pthread_cond_init(&sched->idle, NULL);
+
+	/* Every deque must exist before any worker starts stealing */
+	for(t = 0; t < threads; t++) {
+		sched->workers[t].sched = sched;
+		sched->workers[t].id = t;
+		sched->workers[t].seed = t + 1;
+		kk_workspace_init(&sched->workers[t].ws, NULL, 0);
+		if(kk_queue_init(&sched->workers[t].deque)) {
+			while(t--)
+				kk_queue_free(&sched->workers[t].deque);
+			kk_sched_free(sched);
+			return NULL;
+		}
+	}
+	sched->threads = threads;
+
+	for(t = 0; t < threads; t++) {
+		if(pthread_create(&sched->workers[t].thread, NULL, kk_sched_thread, &sched->workers[t])) {
+			kk_sched_stop(sched, t);
+			return NULL;
+		}
+	}
+
+	return sched;
+}
+
+void kk_sched_destroy(kk_sched_t *sched) {
+	kk_sched_wait(sched);
+	kk_sched_stop(sched, sched->threads);
+}
+
+void kk_sched_job_init(kk_sched_job_t *job) {
+	job->done = NULL;
+	job->arg = NULL;
+	job->finished = 0;
+	kk_workspace_init(&job->ws, NULL, 0);
+}
+
+void kk_sched_job_free(kk_sched_job_t *job) {
+	kk_workspace_free(&job->ws);
+}
+
+int kk_sched_submit(kk_sched_t *sched, kk_sched_job_t *job, int n, const double *in, double *out) {
+	kk_task_t task;
+
+	/* Split jobs get their own scratchpad, grown by the submitting thread */
+	if((n >= KK_SCHED_SPLIT_ROWS) && kk_workspace_reserve(&job->ws, n))
+		return -1;
+
+	job->n = n;
+	job->in = in;
+	job->out = out;
+	job->pending = 0;
+	job->divZero = 0;
+	job->finished = 0;
+
+	task.job = job;
+	task.lo = -1;
+	task.hi = -1;
+
+	__atomic_add_fetch(&sched->outstanding, 1, __ATOMIC_SEQ_CST);
+	if(kk_sched_publish(sched, &sched->inject, &task, 1)) {
+		__atomic_sub_fetch(&sched->outstanding, 1, __ATOMIC_SEQ_CST);
+		return -1;
+	}
+
+	return 0;
+}
+
+int kk_sched_finished(const kk_sched_job_t *job) {
+	return __atomic_load_n(&job->finished, __ATOMIC_ACQUIRE);
+}
+
+void kk_sched_wait(kk_sched_t *sched) {
+	pthread_mutex_lock(&sched->lock);
+	while(__atomic_load_n(&sched->outstanding, __ATOMIC_ACQUIRE))
+		pthread_cond_wait(&sched->idle, &sched->lock);
+	pthread_mutex_unlock(&sched->lock);
+}
@@ -0,0 +1,138 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Job Scheduler)                 * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_SCHED_H
+#define KK_SCHED_H
+
+#include "kk.h"
+
+/**
+ * @brief Rows per band task when a large matrix is split.
+ */
+#define KK_SCHED_BAND_ROWS 32
+
+/**
+ * @brief Matrices with at least this many rows are split into band tasks (smaller ones run as a whole).
+ */
+#define KK_SCHED_SPLIT_ROWS 128
+
+/**
+ * @brief Work-stealing runtime for streams of inversion jobs of mixed sizes.
+ */
+typedef struct kk_sched kk_sched_t;
+
+/**
+ * @brief Inversion job.
+ *
+ * Jobs are owned by the caller and must stay alive (and untouched) from kk_sched_submit() until
+ * they are finished. A job may be submitted again once finished, reusing its scratch memory.
+ */
+typedef struct kk_sched_job {
+	/* Size of matrix */
+	int n;
+	/* n-by-n row-major input matrix */
+	const double *in;
+	/* n-by-n row-major output matrix (may alias in) */
+	double *out;
+	/* Determinant and division by zero flag (valid once finished; divZero with det 0 if scratchpad could not grow) */
+	kk_result_t res;
+
+	/* Called by the worker that finishes the job (may be NULL, set before submitting) */
+	void (*done)(struct kk_sched_job *job);
+	/* Free for caller's use */
+	void *arg;
+
+	/* Scratchpad of split jobs (private) */
+	kk_workspace_t ws;
+	/* Band tasks of current step still to finish (private) */
+	int pending;
+	/* Division by zero flag of bands (private) */
+	int divZero;
+	/* 1 once finished (private, see kk_sched_finished()) */
+	int finished;
+} kk_sched_job_t;
+
+/**
+ * @brief Create a scheduler.
+ *
+ * @param threads Number of worker threads (at least 1).
+ *
+ * @return Scheduler, or NULL on failure.
+ */
+kk_sched_t *kk_sched_create(int threads);
+
+/**
+ * @brief Wait for submitted jobs, stop workers and release a scheduler.
+ *
+ * @param sched Scheduler.
+ */
+void kk_sched_destroy(kk_sched_t *sched);
+
+/**
+ * @brief Initialise a job.
+ *
+ * @param job Job.
+ */
+void kk_sched_job_init(kk_sched_job_t *job);
+
+/**
+ * @brief Release scratch memory of a (finished) job.
+ *
+ * @param job Job.
+ */
+void kk_sched_job_free(kk_sched_job_t *job);
+
+/**
+ * @brief Submit an inversion job (thread-safe).
+ *
+ * @param sched Scheduler.
+ * @param job Job (after kk_sched_job_init()).
+ * @param n Size of matrix.
+ * @param in n-by-n row-major input matrix.
+ * @param out n-by-n row-major output matrix (may alias in).
+ *
+ * @return 0 on success, -1 if scratch memory could not be allocated.
+ */
+int kk_sched_submit(kk_sched_t *sched, kk_sched_job_t *job, int n, const double *in, double *out);
+
+/**
+ * @brief Check whether a job is finished.
+ *
+ * @param job Job.
+ *
+ * @return 1 if finished, 0 otherwise.
+ */
+int kk_sched_finished(const kk_sched_job_t *job);
+
+/**
+ * @brief Wait until every submitted job is finished.
+ *
+ * @param sched Scheduler.
+ */
+void kk_sched_wait(kk_sched_t *sched);
+
+#endif
@@ -0,0 +1,259 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (SIMD Kernels)                  * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include "kk_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KK_SIMD_X86
+#endif
+
+/**
+ * @brief Scalar iteration row kernel.
+ */
+static int kk_iterate_row_scalar(double *restrict next, const double *restrict c0, const double *restrict c1, const double *restrict p1, int n, int w) {
+	int j;
+	/* Division by zero flag, kept as double so that the loop may still be auto-vectorized */
+	double divZero = 0;
+
+	for(j = 0; j < n; j++) {
+		divZero = (0 == p1[j + w])? 1.0 : divZero;
+		next[j] = (c0[j] * c1[j + w] - (c1[j] * c0[j + w])) / p1[j + w];
+	}
+
+	return (0 != divZero);
+}
+
+/**
+ * @brief Scalar final iteration row kernel.
+ */
+static int kk_final_row_scalar(double *restrict out, const double *restrict pcol, int s, const double *restrict curr, int n) {
+	int j, divZero = 0;
+
+	for(j = 0; j < n; j++) {
+		divZero |= (0 == curr[j]);
+		out[j] = pcol[(size_t) j * s] / curr[j];
+	}
+
+	return divZero;
+}
+
+#ifdef KK_SIMD_X86
+/**
+ * @brief SSE2 iteration row kernel.
+ */
+static int kk_iterate_row_sse2(double *restrict next, const double *restrict c0, const double *restrict c1, const double *restrict p1, int n, int w) {
+	int j;
+	__m128d a, b, c, d, p, zero = _mm_setzero_pd(), divZero = _mm_setzero_pd();
+
+	for(j = 0; j + 2 <= n; j += 2) {
+		a = _mm_loadu_pd(&c0[j]);
+		b = _mm_loadu_pd(&c0[j + w]);
+		c = _mm_loadu_pd(&c1[j]);
+		d = _mm_loadu_pd(&c1[j + w]);
+		p = _mm_loadu_pd(&p1[j + w]);
+		divZero = _mm_or_pd(divZero, _mm_cmpeq_pd(p, zero));
+		_mm_storeu_pd(&next[j], _mm_div_pd(_mm_sub_pd(_mm_mul_pd(a, d), _mm_mul_pd(c, b)), p));
+	}
+
+	return _mm_movemask_pd(divZero) | kk_iterate_row_scalar(&next[j], &c0[j], &c1[j], &p1[j], n - j, w);
+}
+
+/**
+ * @brief SSE2 final iteration row kernel.
+ */
+static int kk_final_row_sse2(double *restrict out, const double *restrict pcol, int s, const double *restrict curr, int n) {
+	int j;
+	__m128d p, c, zero = _mm_setzero_pd(), divZero = _mm_setzero_pd();
+
+	for(j = 0; j + 2 <= n; j += 2) {
+		p = _mm_set_pd(pcol[(size_t) (j + 1) * s], pcol[(size_t) j * s]);
+		c = _mm_loadu_pd(&curr[j]);
+		divZero = _mm_or_pd(divZero, _mm_cmpeq_pd(c, zero));
+		_mm_storeu_pd(&out[j], _mm_div_pd(p, c));
+	}
+
+	return _mm_movemask_pd(divZero) | kk_final_row_scalar(&out[j], &pcol[(size_t) j * s], s, &curr[j], n - j);
+}
+
+/**
+ * @brief AVX2 iteration row kernel.
+ */
+__attribute__((target("avx2")))
+static int kk_iterate_row_avx2(double *restrict next, const double *restrict c0, const double *restrict c1, const double *restrict p1, int n, int w) {
+	int j;
+	__m256d a, b, c, d, p, zero = _mm256_setzero_pd(), divZero = _mm256_setzero_pd();
+
+	for(j = 0; j + 4 <= n; j += 4) {
+		a = _mm256_loadu_pd(&c0[j]);
+		b = _mm256_loadu_pd(&c0[j + w]);
+		c = _mm256_loadu_pd(&c1[j]);
+		d = _mm256_loadu_pd(&c1[j + w]);
+		p = _mm256_loadu_pd(&p1[j + w]);
+		divZero = _mm256_or_pd(divZero, _mm256_cmp_pd(p, zero, _CMP_EQ_OQ));
+		_mm256_storeu_pd(&next[j], _mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(a, d), _mm256_mul_pd(c, b)), p));
+	}
+
+	return _mm256_movemask_pd(divZero) | kk_iterate_row_scalar(&next[j], &c0[j], &c1[j], &p1[j], n - j, w);
+}
+
+/**
+ * @brief AVX2 final iteration row kernel (column of previous matrix is gathered).
+ */
+__attribute__((target("avx2")))
+static int kk_final_row_avx2(double *restrict out, const double *restrict pcol, int s, const double *restrict curr, int n) {
+	int j;
+	__m256i idx = _mm256_set_epi64x(3 * (long long) s, 2 * (long long) s, s, 0);
+	__m256i step = _mm256_set1_epi64x(4 * (long long) s);
+	__m256d p, c, zero = _mm256_setzero_pd(), divZero = _mm256_setzero_pd();
+
+	for(j = 0; j + 4 <= n; j += 4) {
+		p = _mm256_i64gather_pd(pcol, idx, 8);
+		c = _mm256_loadu_pd(&curr[j]);
+		divZero = _mm256_or_pd(divZero, _mm256_cmp_pd(c, zero, _CMP_EQ_OQ));
+		_mm256_storeu_pd(&out[j], _mm256_div_pd(p, c));
+		idx = _mm256_add_epi64(idx, step);
+	}
+
+	return _mm256_movemask_pd(divZero) | kk_final_row_scalar(&out[j], &pcol[(size_t) j * s], s, &curr[j], n - j);
+}
+
+/**
+ * @brief AVX-512 iteration row kernel (tail handled with masked loads).
+ */
+__attribute__((target("avx512f")))
+static int kk_iterate_row_avx512(double *restrict next, const double *restrict c0, const double *restrict c1, const double *restrict p1, int n, int w) {
+	int j;
+	__mmask8 m = 0xff, divZero = 0;
+	__m512d a, b, c, d, p, zero = _mm512_setzero_pd(), one = _mm512_set1_pd(1.0);
+
+	for(j = 0; j < n; j += 8) {
+		if(j + 8 > n)
+			m = (__mmask8) ((1u << (n - j)) - 1);
+
+		a = _mm512_maskz_loadu_pd(m, &c0[j]);
+		b = _mm512_maskz_loadu_pd(m, &c0[j + w]);
+		c = _mm512_maskz_loadu_pd(m, &c1[j]);
+		d = _mm512_maskz_loadu_pd(m, &c1[j + w]);
+		/* Inactive lanes divide by one */
+		p = _mm512_mask_loadu_pd(one, m, &p1[j + w]);
+		divZero |= _mm512_cmp_pd_mask(p, zero, _CMP_EQ_OQ);
+		_mm512_mask_storeu_pd(&next[j], m, _mm512_div_pd(_mm512_sub_pd(_mm512_mul_pd(a, d), _mm512_mul_pd(c, b)), p));
+	}
+
+	return (0 != divZero);
+}
+
+/**
+ * @brief AVX-512 final iteration row kernel (column of previous matrix is gathered).
+ */
+__attribute__((target("avx512f")))
+static int kk_final_row_avx512(double *restrict out, const double *restrict pcol, int s, const double *restrict curr, int n) {
+	int j;
+	__mmask8 m = 0xff, divZero = 0;
+	__m512i idx = _mm512_set_epi64(7 * (long long) s, 6 * (long long) s, 5 * (long long) s, 4 * (long long) s, 3 * (long long) s, 2 * (long long) s, s, 0);
+	__m512i step = _mm512_set1_epi64(8 * (long long) s);
+	__m512d p, c, zero = _mm512_setzero_pd(), one = _mm512_set1_pd(1.0);
+
+	for(j = 0; j < n; j += 8) {
+		if(j + 8 > n)
+			m = (__mmask8) ((1u << (n - j)) - 1);
+
+		p = _mm512_mask_i64gather_pd(zero, m, idx, pcol, 8);
+		/* Inactive lanes divide by one */
+		c = _mm512_mask_loadu_pd(one, m, &curr[j]);
+		divZero |= _mm512_cmp_pd_mask(c, zero, _CMP_EQ_OQ);
+		_mm512_mask_storeu_pd(&out[j], m, _mm512_div_pd(p, c));
+		idx = _mm512_add_epi64(idx, step);
+	}
+
+	return (0 != divZero);
+}
+#endif
+
+kk_kernels_t kk_kernels = {kk_iterate_row_scalar, kk_final_row_scalar};
+
+/**
+ * @brief SIMD level in use.
+ */
+static kk_simd_t kk_simd = KK_SIMD_SCALAR;
+
+kk_simd_t kk_simd_detect(void) {
+#ifdef KK_SIMD_X86
+	__builtin_cpu_init();
+
+	if(__builtin_cpu_supports("avx512f"))
+		return KK_SIMD_AVX512;
+	if(__builtin_cpu_supports("avx2"))
+		return KK_SIMD_AVX2;
+	return KK_SIMD_SSE2;
+#else
+	return KK_SIMD_SCALAR;
+#endif
+}
+
+kk_simd_t kk_simd_get(void) {
+	return kk_simd;
+}
+
+int kk_simd_set(kk_simd_t level) {
+	if(level > kk_simd_detect())
+		return -1;
+
+	switch(level) {
+#ifdef KK_SIMD_X86
+		case KK_SIMD_AVX512:
+			kk_kernels.iterate_row = kk_iterate_row_avx512;
+			kk_kernels.final_row = kk_final_row_avx512;
+			break;
+		case KK_SIMD_AVX2:
+			kk_kernels.iterate_row = kk_iterate_row_avx2;
+			kk_kernels.final_row = kk_final_row_avx2;
+			break;
+		case KK_SIMD_SSE2:
+			kk_kernels.iterate_row = kk_iterate_row_sse2;
+			kk_kernels.final_row = kk_final_row_sse2;
+			break;
+#endif
+		default:
+			kk_kernels.iterate_row = kk_iterate_row_scalar;
+			kk_kernels.final_row = kk_final_row_scalar;
+			break;
+	}
+
+	kk_simd = level;
+
+	return 0;
+}
+
+/**
+ * @brief Select best kernels supported by this CPU at program start.
+ */
+__attribute__((constructor))
+static void kk_simd_init(void) {
+	kk_simd_set(kk_simd_detect());
+}
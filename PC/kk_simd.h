@@ -0,0 +1,72 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (SIMD Kernels)                  * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_SIMD_H
+#define KK_SIMD_H
+
+#include "kk.h"
+
+/**
+ * @brief Row kernels used by the KK engine, selected at runtime according to CPU support.
+ */
+typedef struct {
+	/**
+	 * @brief Calculate one row of a KK iteration.
+	 *
+	 * Element j of next row is (c0[j] * c1[j + w] - c1[j] * c0[j + w]) / p1[j + w].
+	 *
+	 * @param next Row i of next matrix (n elements).
+	 * @param c0 Row i of current matrix (n + w elements, halo included).
+	 * @param c1 Row i + 1 of current matrix (n + w elements, halo included).
+	 * @param p1 Row i + 1 of previous matrix (n + w elements, halo included).
+	 * @param n Number of elements in row.
+	 * @param w Distance between two consecutive columns (1, or number of interleaved matrices).
+	 *
+	 * @return Non-zero if any divisor was zero.
+	 */
+	int (*iterate_row)(double *next, const double *c0, const double *c1, const double *p1, int n, int w);
+
+	/**
+	 * @brief Calculate one row of the final iteration (inverse).
+	 *
+	 * @param out Row i of inverse (n elements).
+	 * @param pcol Element (1, i + 1) of previous matrix, next elements of this column are s apart.
+	 * @param s Row stride of previous matrix.
+	 * @param curr Row i of current matrix (n elements).
+	 * @param n Size of matrix.
+	 *
+	 * @return Non-zero if any divisor was zero.
+	 */
+	int (*final_row)(double *out, const double *pcol, int s, const double *curr, int n);
+} kk_kernels_t;
+
+/**
+ * @brief Kernels in use.
+ */
+extern kk_kernels_t kk_kernels;
+
+#endif
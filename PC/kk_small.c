@@ -0,0 +1,145 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Small Kernels)                 * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <string.h>
+
+#include "kk_small.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KK_SMALL_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define KK_SMALL_CLONES
+#endif
+
+/**
+ * @brief Row kernel, inlined into every specialized kernel so that n becomes a compile-time constant.
+ *
+ * @param next Row i of next matrix.
+ * @param c0 Row i of current matrix.
+ * @param c1 Row i + 1 of current matrix.
+ * @param p1 Row i + 1 of previous matrix.
+ * @param n Size of matrix.
+ * @param divZero Division by zero flag so far.
+ *
+ * @return Updated division by zero flag.
+ */
+static inline __attribute__((always_inline)) double kk_small_row(double *restrict next, const double *restrict c0, const double *restrict c1, const double *restrict p1, int n, double divZero) {
+	int j;
+
+	for(j = 0; j < n; j++) {
+		divZero = (0 == p1[j + 1])? 1.0 : divZero;
+		next[j] = (c0[j] * c1[j + 1] - (c1[j] * c0[j + 1])) / p1[j + 1];
+	}
+	next[n] = next[0];
+
+	return divZero;
+}
+
+/**
+ * @brief One KK iteration of an NN-by-NN matrix on stack registers m[P] (previous), m[C] (current)
+ * and m[X] (next), rows fully unrolled.
+ *
+ * Register indexes are constants, so the compiler resolves every address at compile time.
+ */
+#define KK_SMALL_STEP(NN, P, C, X) \
+	_Pragma("GCC unroll 8") \
+	for(i = 0; i < NN; i++) \
+		divZero = kk_small_row(m[X][i], m[C][i], m[C][i + 1], m[P][i + 1], NN, divZero); \
+	memcpy(m[X][NN], m[X][0], sizeof(m[X][0]));
+
+/**
+ * @brief Generate the specialized kernel for a compile-time matrix size.
+ *
+ * Registers are used as the hardware does: input on m[1], ones on m[0], and iteration k reads
+ * m[k % 3] and m[(k + 1) % 3] and writes m[(k + 2) % 3]. Iterations are unrolled by three so that
+ * these indexes stay constant, and the remaining ones are resolved at compile time. Every other loop
+ * is fully unrolled, so each kernel is straight-line code. One clone is built per instruction set.
+ */
+#define KK_SMALL_KERNEL(NN) \
+	KK_SMALL_CLONES static void kk_small_##NN(const double *in, double *out, kk_result_t *res) { \
+		int i, j, k; \
+		/* Division by zero flag, kept as double so that loops may still be vectorized */ \
+		double divZero = 0; \
+		/* Register matrices, with halo row and column */ \
+		double m[3][NN + 1][NN + 1]; \
+		\
+		_Pragma("GCC unroll 8") \
+		for(i = 0; i < NN; i++) { \
+			_Pragma("GCC unroll 8") \
+			for(j = 0; j < NN; j++) \
+				m[1][i][j] = in[i * NN + j]; \
+			m[1][i][NN] = m[1][i][0]; \
+		} \
+		_Pragma("GCC unroll 8") \
+		for(j = 0; j <= NN; j++) \
+			m[1][NN][j] = m[1][0][j]; \
+		_Pragma("GCC unroll 8") \
+		for(i = 1; i <= NN; i++) \
+			_Pragma("GCC unroll 8") \
+			for(j = 1; j <= NN; j++) \
+				m[0][i][j] = 1.0; \
+		\
+		for(k = 0; k + 3 <= NN - 1; k += 3) { \
+			KK_SMALL_STEP(NN, 0, 1, 2) \
+			KK_SMALL_STEP(NN, 1, 2, 0) \
+			KK_SMALL_STEP(NN, 2, 0, 1) \
+		} \
+		if((NN - 1) % 3 > 0) { \
+			KK_SMALL_STEP(NN, 0, 1, 2) \
+		} \
+		if((NN - 1) % 3 > 1) { \
+			KK_SMALL_STEP(NN, 1, 2, 0) \
+		} \
+		\
+		/* After NN - 1 iterations, current matrix is m[NN % 3] and previous one is m[(NN - 1) % 3] */ \
+		if(res) \
+			res->det = m[NN % 3][0][0]; \
+		_Pragma("GCC unroll 8") \
+		for(i = 0; i < NN; i++) { \
+			_Pragma("GCC unroll 8") \
+			for(j = 0; j < NN; j++) { \
+				divZero = (0 == m[NN % 3][i][j])? 1.0 : divZero; \
+				out[i * NN + j] = m[(NN - 1) % 3][j + 1][i + 1] / m[NN % 3][i][j]; \
+			} \
+		} \
+		if(res) { \
+			res->divZero = (0 != divZero); \
+			res->path = KK_PATH_KK; \
+		} \
+	}
+
+KK_SMALL_KERNEL(1)
+KK_SMALL_KERNEL(2)
+KK_SMALL_KERNEL(3)
+KK_SMALL_KERNEL(4)
+KK_SMALL_KERNEL(5)
+KK_SMALL_KERNEL(6)
+KK_SMALL_KERNEL(7)
+
+const kk_small_t kk_small[KK_SMALL_MAX + 1] = {
+	NULL, kk_small_1, kk_small_2, kk_small_3, kk_small_4, kk_small_5, kk_small_6, kk_small_7
+};
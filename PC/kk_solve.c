@@ -0,0 +1,152 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Linear Systems)                * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <string.h>
+
+#include "kk_small.h"
+#include "kk_solve.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+/* Tile products get one clone per instruction set, as the generic engine */
+#define KK_SOLVE_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define KK_SOLVE_CLONES
+#endif
+
+/**
+ * @brief Calculate a tile of the inverse from the last two KK matrices.
+ *
+ * Element (i, j) of inverse is prev[j + 1][i + 1] / curr[i][j].
+ *
+ * @param tile Tile, rows KK_SOLVE_BLOCK_COLS elements apart.
+ * @param prev Previous matrix.
+ * @param curr Current matrix.
+ * @param s Row stride of both matrices.
+ * @param i0 First row of tile.
+ * @param j0 First column of tile.
+ * @param ib Rows of tile.
+ * @param jb Columns of tile.
+ *
+ * @return Non-zero if any divisor was zero.
+ */
+static int kk_solve_tile(double *restrict tile, const double *restrict prev, const double *restrict curr, int s, int i0, int j0, int ib, int jb) {
+	int i, j, divZero = 0;
+	const double *c;
+
+	for(i = 0; i < ib; i++) {
+		c = &curr[(i0 + i) * s + j0];
+		for(j = 0; j < jb; j++) {
+			divZero |= (0 == c[j]);
+			tile[i * KK_SOLVE_BLOCK_COLS + j] = prev[(j0 + j + 1) * s + i0 + i + 1] / c[j];
+		}
+	}
+
+	return divZero;
+}
+
+/**
+ * @brief Accumulate the product of a tile of the inverse by rows of B (X += T B).
+ *
+ * @param x First row of X to update, rows nrhs elements apart.
+ * @param tile Tile.
+ * @param ts Row stride of tile.
+ * @param b First row of B to multiply, rows nrhs elements apart.
+ * @param nrhs Row stride of B and X.
+ * @param ib Rows of tile.
+ * @param jb Columns of tile.
+ * @param rb Columns of B and X updated.
+ */
+KK_SOLVE_CLONES static void kk_solve_gemm(double *restrict x, const double *restrict tile, int ts, const double *restrict b, int nrhs, int ib, int jb, int rb) {
+	int i, j, r;
+	double t, *xr;
+	const double *br;
+
+	/* Products are added to each element in increasing j, as a plain row-by-column product would */
+	for(i = 0; i < ib; i++) {
+		xr = &x[(size_t) i * nrhs];
+		for(j = 0; j < jb; j++) {
+			t = tile[i * ts + j];
+			br = &b[(size_t) j * nrhs];
+			for(r = 0; r < rb; r++)
+				xr[r] += t * br[r];
+		}
+	}
+}
+
+size_t kk_solve_size(int n) {
+	return kk_workspace_size(n) + KK_SOLVE_BLOCK_ROWS * KK_SOLVE_BLOCK_COLS * sizeof(double);
+}
+
+int kk_solve(int n, int nrhs, const double *a, const double *b, double *x, kk_workspace_t *ws, kk_result_t *res) {
+	int i0, j0, r0, ib, jb, rb, s, divZero = 0;
+	double *tile, inv[KK_SMALL_MAX * KK_SMALL_MAX];
+	const double *prev, *curr;
+
+	/* Tiny inverses fit in one tile anyway, and specialized kernels calculate them whole */
+	if((n > 0) && (n <= KK_SMALL_MAX)) {
+		kk_small[n](a, inv, res);
+		memset(x, 0, (size_t) n * nrhs * sizeof(double));
+		for(r0 = 0; r0 < nrhs; r0 += KK_SOLVE_BLOCK_RHS) {
+			rb = (nrhs - r0 < KK_SOLVE_BLOCK_RHS)? nrhs - r0 : KK_SOLVE_BLOCK_RHS;
+			kk_solve_gemm(x + r0, inv, n, b + r0, nrhs, n, n, rb);
+		}
+		return 0;
+	}
+
+	if(kk_workspace_grow(ws, kk_solve_size(n)) || kk_workspace_reserve(ws, n))
+		return -1;
+
+	kk_transfer(ws, n, a);
+	kk_iterate(ws);
+
+	/* Final iteration, one tile of inverse at a time */
+	s = ws->stride;
+	prev = ws->matrix_K[ws->prev];
+	curr = ws->matrix_K[ws->curr];
+	tile = (double *) ((char *) ws->mem + kk_workspace_size(n));
+	memset(x, 0, (size_t) n * nrhs * sizeof(double));
+	for(i0 = 0; i0 < n; i0 += KK_SOLVE_BLOCK_ROWS) {
+		ib = (n - i0 < KK_SOLVE_BLOCK_ROWS)? n - i0 : KK_SOLVE_BLOCK_ROWS;
+		for(j0 = 0; j0 < n; j0 += KK_SOLVE_BLOCK_COLS) {
+			jb = (n - j0 < KK_SOLVE_BLOCK_COLS)? n - j0 : KK_SOLVE_BLOCK_COLS;
+			divZero |= kk_solve_tile(tile, prev, curr, s, i0, j0, ib, jb);
+			for(r0 = 0; r0 < nrhs; r0 += KK_SOLVE_BLOCK_RHS) {
+				rb = (nrhs - r0 < KK_SOLVE_BLOCK_RHS)? nrhs - r0 : KK_SOLVE_BLOCK_RHS;
+				kk_solve_gemm(&x[(size_t) i0 * nrhs + r0], tile, KK_SOLVE_BLOCK_COLS, &b[(size_t) j0 * nrhs + r0], nrhs, ib, jb, rb);
+			}
+		}
+	}
+	ws->divZero |= divZero;
+
+	if(res) {
+		res->det = kk_getdetelem(ws, 0, 0);
+		res->divZero = ws->divZero;
+		res->path = KK_PATH_KK;
+	}
+
+	return 0;
+}
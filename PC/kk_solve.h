@@ -0,0 +1,77 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Linear Systems)                * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_SOLVE_H
+#define KK_SOLVE_H
+
+#include "kk.h"
+
+/**
+ * @brief Rows of inverse calculated at once (tile height).
+ */
+#define KK_SOLVE_BLOCK_ROWS 32
+
+/**
+ * @brief Columns of inverse calculated at once (tile width, rows of right-hand sides per pass).
+ */
+#define KK_SOLVE_BLOCK_COLS 64
+
+/**
+ * @brief Right-hand sides updated at once (a KK_SOLVE_BLOCK_COLS-row slice of them stays in cache).
+ */
+#define KK_SOLVE_BLOCK_RHS 256
+
+/**
+ * @brief Return scratch memory needed to solve an n-by-n system.
+ *
+ * @param n Size of matrix.
+ *
+ * @return Size in bytes (KK scratchpad plus one inverse tile).
+ */
+size_t kk_solve_size(int n);
+
+/**
+ * @brief Solve A X = B using KK Algorithm, without forming the inverse of A.
+ *
+ * KK iterations run as in kk_invert(); the final iteration is fused with the product by B instead: a
+ * KK_SOLVE_BLOCK_ROWS-by-KK_SOLVE_BLOCK_COLS tile of the inverse is calculated in cache, then multiplied
+ * by KK_SOLVE_BLOCK_RHS columns of the matching rows of B at a time, and dropped. Each element of X is
+ * summed in the same order as multiplying the output of kk_invert() by B, so results are bit-identical.
+ *
+ * @param n Size of matrix.
+ * @param nrhs Number of right-hand sides (columns of B and X).
+ * @param a n-by-n row-major matrix.
+ * @param b n-by-nrhs row-major right-hand sides.
+ * @param x n-by-nrhs row-major solution (must not alias b).
+ * @param ws Workspace (pooled workspaces are grown as needed, to kk_solve_size()).
+ * @param res Determinant and division by zero flag (may be NULL).
+ *
+ * @return 0 on success, -1 if workspace could not hold an n-by-n system.
+ */
+int kk_solve(int n, int nrhs, const double *a, const double *b, double *x, kk_workspace_t *ws, kk_result_t *res);
+
+#endif
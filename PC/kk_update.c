@@ -0,0 +1,271 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Incremental Updates)           * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "kk_update.h"
+
+/**
+ * @brief Measure residual of current inverse (err) on the probe vector.
+ *
+ * @param up Incremental inverse.
+ * @param x A^-1 w.
+ * @param w Probe vector.
+ */
+static void kk_update_residual(kk_update_t *up, const double *x, const double *w) {
+	int i, j, n = up->n;
+	double y, err = 0;
+	const double *a;
+
+	for(i = 0; i < n; i++) {
+		a = &up->a[(size_t) i * n];
+		y = 0;
+		for(j = 0; j < n; j++)
+			y += a[j] * x[j];
+		err += fabs(y - w[i]);
+	}
+
+	/* NaN (from a singular update) counts as above any tolerance */
+	up->err = (err == err)? err / n : INFINITY;
+}
+
+/**
+ * @brief Invert current matrix from scratch.
+ *
+ * @param up Incremental inverse.
+ */
+static void kk_update_refresh(kk_update_t *up) {
+	int i, j, n = up->n;
+	double *w = up->scratch, *x = w + n;
+	const double *inv;
+	kk_result_t res;
+
+	kk_invert_safe(n, up->a, up->inv, &up->ws, KK_UPDATE_SAFE_TOL, &res);
+	up->det = res.det;
+	up->divZero = res.divZero;
+	up->updates = 0;
+	up->refreshes++;
+
+	for(i = 0; i < n; i++) {
+		inv = &up->inv[(size_t) i * n];
+		x[i] = 0;
+		for(j = 0; j < n; j++)
+			x[i] += inv[j] * w[j];
+	}
+	kk_update_residual(up, x, w);
+	up->err0 = up->err;
+}
+
+/**
+ * @brief Factorize a k-by-k matrix in place (P C = L U) and apply the elimination to the rows of Z.
+ *
+ * @param c k-by-k matrix (replaced by U, above its diagonal).
+ * @param z k-by-n matrix (rows swapped and eliminated, then solved by back substitution: C W = Z).
+ * @param k Size of C.
+ * @param n Number of columns of Z.
+ * @param det Determinant of C.
+ *
+ * @return 0 on success, -1 if C is singular.
+ */
+static int kk_update_solve(double *c, double *z, int k, int n, double *det) {
+	int i, j, r, p;
+	double t, f;
+
+	*det = 1.0;
+	for(r = 0; r < k; r++) {
+		/* Partial pivoting */
+		for(p = r, i = r + 1; i < k; i++)
+			p = (fabs(c[i * k + r]) > fabs(c[p * k + r]))? i : p;
+		if(0 == c[p * k + r])
+			return -1;
+		if(p != r) {
+			for(j = 0; j < k; j++) {
+				t = c[r * k + j];
+				c[r * k + j] = c[p * k + j];
+				c[p * k + j] = t;
+			}
+			for(j = 0; j < n; j++) {
+				t = z[(size_t) r * n + j];
+				z[(size_t) r * n + j] = z[(size_t) p * n + j];
+				z[(size_t) p * n + j] = t;
+			}
+			*det = -*det;
+		}
+		*det *= c[r * k + r];
+
+		for(i = r + 1; i < k; i++) {
+			f = c[i * k + r] / c[r * k + r];
+			for(j = r; j < k; j++)
+				c[i * k + j] -= f * c[r * k + j];
+			for(j = 0; j < n; j++)
+				z[(size_t) i * n + j] -= f * z[(size_t) r * n + j];
+		}
+	}
+
+	for(r = k - 1; r >= 0; r--) {
+		for(i = r + 1; i < k; i++) {
+			f = c[r * k + i];
+			for(j = 0; j < n; j++)
+				z[(size_t) r * n + j] -= f * z[(size_t) i * n + j];
+		}
+		f = 1.0 / c[r * k + r];
+		for(j = 0; j < n; j++)
+			z[(size_t) r * n + j] *= f;
+	}
+
+	return 0;
+}
+
+void kk_update_init(kk_update_t *up) {
+	memset(up, 0, sizeof(*up));
+	kk_workspace_init(&up->ws, NULL, 0);
+}
+
+void kk_update_free(kk_update_t *up) {
+	free(up->a);
+	kk_workspace_free(&up->ws);
+	kk_update_init(up);
+}
+
+int kk_update_seed(kk_update_t *up, int n, int kmax, const double *a, double tol) {
+	int i;
+	size_t size;
+	void *mem;
+
+	/* Matrix, inverse, probe w, x = A^-1 w, Y = A^-1 U (n-by-kmax), Z = V^T A^-1 (kmax-by-n), C */
+	size = 2 * (size_t) n * n + 2 * (size_t) n + 2 * (size_t) n * kmax + (size_t) kmax * kmax;
+	if(size > up->size) {
+		if(posix_memalign(&mem, KK_ALIGN, size * sizeof(double)))
+			return -1;
+		free(up->a);
+		up->a = mem;
+		up->size = size;
+	}
+
+	up->n = n;
+	up->kmax = kmax;
+	up->tol = tol;
+	up->inv = up->a + (size_t) n * n;
+	up->scratch = up->inv + (size_t) n * n;
+	up->refreshes = 0;
+	memcpy(up->a, a, (size_t) n * n * sizeof(double));
+
+	/* Probe vector: a fixed pattern of signs */
+	for(i = 0; i < n; i++)
+		up->scratch[i] = (((unsigned int) i * 2654435761u) & 0x10000)? -1.0 : 1.0;
+
+	if(kk_workspace_reserve(&up->ws, n))
+		return -1;
+	kk_update_refresh(up);
+
+	return 0;
+}
+
+int kk_update_rank(kk_update_t *up, int k, const double *u, const double *v) {
+	int i, j, r, c, n = up->n;
+	double t, detC, *row, *w, *x, *y, *z, *cm;
+	const double *yr;
+
+	if((k < 1) || (k > up->kmax))
+		return -1;
+
+	w = up->scratch;
+	x = w + n;
+	y = x + n;
+	z = y + (size_t) n * k;
+	cm = z + (size_t) n * k;
+
+	/* One pass over inverse: Y = A^-1 U and Z = V^T A^-1 */
+	memset(z, 0, (size_t) n * k * sizeof(double));
+	for(i = 0; i < n; i++) {
+		row = &up->inv[(size_t) i * n];
+		for(r = 0; r < k; r++)
+			y[i * k + r] = 0;
+		for(j = 0; j < n; j++)
+			for(r = 0; r < k; r++)
+				y[i * k + r] += row[j] * u[j * k + r];
+
+		for(r = 0; r < k; r++) {
+			t = v[i * k + r];
+			for(j = 0; j < n; j++)
+				z[(size_t) r * n + j] += t * row[j];
+		}
+	}
+
+	/* C = I + V^T Y */
+	for(r = 0; r < k; r++) {
+		for(c = 0; c < k; c++) {
+			t = (r == c)? 1.0 : 0.0;
+			for(i = 0; i < n; i++)
+				t += v[i * k + r] * y[i * k + c];
+			cm[r * k + c] = t;
+		}
+	}
+
+	/* Matrix is updated exactly, whatever happens to inverse */
+	for(i = 0; i < n; i++) {
+		row = &up->a[(size_t) i * n];
+		for(r = 0; r < k; r++) {
+			t = u[i * k + r];
+			for(j = 0; j < n; j++)
+				row[j] += t * v[j * k + r];
+		}
+	}
+
+	/* Z becomes C^-1 V^T A^-1; a singular C means the update made A singular (or nearly so) */
+	if(kk_update_solve(cm, z, k, n, &detC)) {
+		kk_update_refresh(up);
+		return 1;
+	}
+
+	/* Second pass over inverse: A^-1 -= Y Z, and x = A^-1 w for the residual */
+	for(i = 0; i < n; i++) {
+		row = &up->inv[(size_t) i * n];
+		yr = &y[i * k];
+		for(r = 0; r < k; r++) {
+			t = yr[r];
+			for(j = 0; j < n; j++)
+				row[j] -= t * z[(size_t) r * n + j];
+		}
+		x[i] = 0;
+		for(j = 0; j < n; j++)
+			x[i] += row[j] * w[j];
+	}
+
+	up->det *= detC;
+	up->updates++;
+	kk_update_residual(up, x, w);
+
+	if(!(up->err <= up->tol) && !(up->err <= 2 * up->err0)) {
+		kk_update_refresh(up);
+		return 1;
+	}
+
+	return 0;
+}
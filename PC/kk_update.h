@@ -0,0 +1,128 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Incremental Updates)           * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_UPDATE_H
+#define KK_UPDATE_H
+
+#include "kk.h"
+
+/**
+ * @brief Cancellation tolerance of full inversions (see kk_invert_safe()): updated matrices need not
+ * stay strongly non-singular.
+ */
+#define KK_UPDATE_SAFE_TOL 1e-9
+
+/**
+ * @brief Inverse of a matrix kept up to date across low-rank changes.
+ *
+ * Seeded by a full inversion, then every rank-k change A += U V^T updates the inverse in O(k n^2) with
+ * the Woodbury identity instead of O(n^3). Rounding errors of updates pile up, so each update also
+ * measures the residual of the new inverse on a fixed probe vector, and a full inversion of the
+ * (exactly updated) matrix runs again whenever the residual exceeds the tolerance.
+ */
+typedef struct {
+	/* Size of matrix */
+	int n;
+	/* Maximum rank of a single update */
+	int kmax;
+	/* Residual above which inverse is recalculated from scratch */
+	double tol;
+
+	/* Current n-by-n matrix */
+	double *a;
+	/* Current n-by-n inverse */
+	double *inv;
+	/* Scratch memory for updates and residuals */
+	double *scratch;
+	/* Size of allocated memory, in doubles */
+	size_t size;
+	/* Workspace for full inversions */
+	kk_workspace_t ws;
+
+	/* Determinant of current matrix */
+	double det;
+	/* 1 if current matrix is singular (last full inversion divided by zero, or an update made it so) */
+	int divZero;
+	/* Residual of current inverse: mean of |A A^-1 w - w| over a fixed vector w of signs */
+	double err;
+	/* Residual right after last full inversion */
+	double err0;
+	/* Updates applied since last full inversion */
+	int updates;
+	/* Full inversions run so far (first one included) */
+	int refreshes;
+} kk_update_t;
+
+/**
+ * @brief Initialise an empty incremental inverse.
+ *
+ * @param up Incremental inverse.
+ */
+void kk_update_init(kk_update_t *up);
+
+/**
+ * @brief Release memory of an incremental inverse.
+ *
+ * @param up Incremental inverse.
+ */
+void kk_update_free(kk_update_t *up);
+
+/**
+ * @brief Load a matrix and invert it from scratch (KK, falling back to LU if KK breaks down).
+ *
+ * Memory only grows, so seeding again with the same sizes does not touch the heap.
+ *
+ * @param up Incremental inverse.
+ * @param n Size of matrix.
+ * @param kmax Maximum rank of a single update.
+ * @param a n-by-n row-major matrix.
+ * @param tol Residual above which inverse is recalculated from scratch (as calculate_error(), a
+ *            few orders of magnitude above machine epsilon times condition number).
+ *
+ * @return 0 on success, -1 if memory could not be allocated.
+ */
+int kk_update_seed(kk_update_t *up, int n, int kmax, const double *a, double tol);
+
+/**
+ * @brief Apply a rank-k change A += U V^T to matrix and inverse.
+ *
+ * A^-1 becomes A^-1 - A^-1 U C^-1 V^T A^-1, with C = I + V^T A^-1 U (k-by-k, solved by Gaussian
+ * elimination with partial pivoting), and det(A) is multiplied by det(C). Inverse is recalculated from
+ * scratch if C is singular, or if the residual exceeds both the tolerance and twice the residual of
+ * the last full inversion (an inverse that a full inversion cannot bring below the tolerance is not
+ * recalculated at every update).
+ *
+ * @param up Incremental inverse (seeded).
+ * @param k Rank of change (1 to kmax).
+ * @param u n-by-k row-major matrix.
+ * @param v n-by-k row-major matrix.
+ *
+ * @return 1 if inverse was recalculated from scratch, 0 if it was updated, -1 if k is out of range.
+ */
+int kk_update_rank(kk_update_t *up, int k, const double *u, const double *v);
+
+#endif
@@ -0,0 +1,419 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Freivalds Verification)        * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#include <math.h>
+#include <string.h>
+
+#include "kk_verify.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define KK_VERIFY_X86
+/* Products get one clone per instruction set, as the generic engine */
+#define KK_VERIFY_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define KK_VERIFY_CLONES
+#endif
+
+/**
+ * @brief Rows of product tile calculated by a kernel call.
+ */
+#define KK_VERIFY_TILE_ROWS 8
+
+/**
+ * @brief Columns of product tile calculated by a kernel call (two AVX-512 vectors, the tile being 16 of
+ * the 32 registers).
+ */
+#define KK_VERIFY_TILE_COLS 16
+
+/**
+ * @brief Product kernel: accumulate a tile of product from packed blocks (C += A B, in increasing inner
+ * index, so that all kernels are bit-identical).
+ *
+ * @param kb Inner dimension.
+ * @param ap KK_VERIFY_TILE_ROWS rows of packed A, interleaved (column k at k * KK_VERIFY_TILE_ROWS).
+ * @param bp KK_VERIFY_TILE_COLS columns of packed B, interleaved (row k at k * KK_VERIFY_TILE_COLS).
+ * @param c Tile of product.
+ * @param cs Row stride of product.
+ */
+typedef void (*kk_verify_kernel_t)(int kb, const double *restrict ap, const double *restrict bp, double *restrict c, int cs);
+
+/**
+ * @brief Elements of scratch memory of each worker of kk_verify_full().
+ */
+#define KK_VERIFY_WORKER_SIZE (KK_VERIFY_BLOCK_ROWS * KK_VERIFY_BLOCK_DEPTH + KK_VERIFY_BLOCK_DEPTH * KK_VERIFY_BLOCK_COLS + KK_VERIFY_BLOCK_ROWS * KK_VERIFY_BLOCK_COLS)
+
+/**
+ * @brief Shared state of kk_verify_full() tasks.
+ */
+typedef struct {
+	/* Size of matrices */
+	int n;
+	/* Product kernel */
+	kk_verify_kernel_t kernel;
+	/* Inverse and matrix */
+	const double *inv, *a;
+	/* Error sum of each task */
+	double *sums;
+	/* Scratch memory of worker 0 (KK_VERIFY_WORKER_SIZE elements per worker) */
+	double *scratch;
+} kk_verify_full_t;
+
+/**
+ * @brief Pseudo-random generator (SplitMix64), so that verifications are reproducible everywhere.
+ *
+ * @param state Generator state.
+ *
+ * @return Next 64 random bits.
+ */
+static uint64_t kk_verify_rand(uint64_t *state) {
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+	return z ^ (z >> 31);
+}
+
+/**
+ * @brief Multiply a matrix by all vectors of a round set.
+ *
+ * Vectors are interleaved (element j of vector r is at j * rounds + r), so that the inner loop runs
+ * over contiguous rounds and each element of m is loaded once.
+ *
+ * @param n Size of matrix.
+ * @param m n-by-n row-major matrix.
+ * @param rounds Number of vectors.
+ * @param v Interleaved input vectors.
+ * @param y Interleaved output vectors.
+ */
+KK_VERIFY_CLONES
+static void kk_verify_multiply(int n, const double *restrict m, int rounds, const double *restrict v, double *restrict y) {
+	int i, j, r;
+	const double *row, *vj;
+	double *yi, mij;
+
+	for(i = 0; i < n; i++) {
+		row = m + (size_t) i * n;
+		yi = y + (size_t) i * rounds;
+
+		for(r = 0; r < rounds; r++)
+			yi[r] = 0;
+
+		for(j = 0; j < n; j++) {
+			mij = row[j];
+			vj = v + (size_t) j * rounds;
+			for(r = 0; r < rounds; r++)
+				yi[r] += mij * vj[r];
+		}
+	}
+}
+
+/**
+ * @brief Return largest element of |m * v - w| over all vectors of a round set.
+ *
+ * @param n Size of matrix.
+ * @param m n-by-n row-major matrix.
+ * @param rounds Number of vectors.
+ * @param v Interleaved input vectors.
+ * @param w Interleaved expected products.
+ *
+ * @return Largest absolute difference (NaN if any product is NaN).
+ */
+KK_VERIFY_CLONES
+static double kk_verify_residual(int n, const double *restrict m, int rounds, const double *restrict v, const double *restrict w) {
+	int i, j, r;
+	const double *row, *vj, *wi;
+	double yi[KK_VERIFY_MAX_ROUNDS], mij, d, max = 0;
+
+	for(i = 0; i < n; i++) {
+		row = m + (size_t) i * n;
+		wi = w + (size_t) i * rounds;
+
+		for(r = 0; r < rounds; r++)
+			yi[r] = 0;
+
+		for(j = 0; j < n; j++) {
+			mij = row[j];
+			vj = v + (size_t) j * rounds;
+			for(r = 0; r < rounds; r++)
+				yi[r] += mij * vj[r];
+		}
+
+		/* Written so that NaN residuals are never below max */
+		for(r = 0; r < rounds; r++) {
+			d = fabs(yi[r] - wi[r]);
+			if(!(d <= max))
+				max = d;
+		}
+	}
+
+	return max;
+}
+
+/**
+ * @brief Scalar product kernel.
+ */
+static void kk_verify_kernel_scalar(int kb, const double *restrict ap, const double *restrict bp, double *restrict c, int cs) {
+	int k, r, q;
+
+	for(k = 0; k < kb; k++)
+		for(r = 0; r < KK_VERIFY_TILE_ROWS; r++)
+			for(q = 0; q < KK_VERIFY_TILE_COLS; q++)
+				c[r * cs + q] += ap[k * KK_VERIFY_TILE_ROWS + r] * bp[k * KK_VERIFY_TILE_COLS + q];
+}
+
+#ifdef KK_VERIFY_X86
+/**
+ * @brief AVX2 product kernel (four 4-by-8 quarters, so that each one fits in 8 of the 16 registers).
+ */
+__attribute__((target("avx2")))
+static void kk_verify_kernel_avx2(int kb, const double *restrict ap, const double *restrict bp, double *restrict c, int cs) {
+	int k, r, h, q;
+	__m256d acc[4][2], b0, b1, x;
+
+	for(h = 0; h < KK_VERIFY_TILE_ROWS; h += 4) {
+		for(q = 0; q < KK_VERIFY_TILE_COLS; q += 8) {
+			for(r = 0; r < 4; r++) {
+				acc[r][0] = _mm256_loadu_pd(&c[(h + r) * cs + q]);
+				acc[r][1] = _mm256_loadu_pd(&c[(h + r) * cs + q + 4]);
+			}
+
+			for(k = 0; k < kb; k++) {
+				b0 = _mm256_load_pd(&bp[k * KK_VERIFY_TILE_COLS + q]);
+				b1 = _mm256_load_pd(&bp[k * KK_VERIFY_TILE_COLS + q + 4]);
+				for(r = 0; r < 4; r++) {
+					x = _mm256_broadcast_sd(&ap[k * KK_VERIFY_TILE_ROWS + h + r]);
+					acc[r][0] = _mm256_add_pd(acc[r][0], _mm256_mul_pd(x, b0));
+					acc[r][1] = _mm256_add_pd(acc[r][1], _mm256_mul_pd(x, b1));
+				}
+			}
+
+			for(r = 0; r < 4; r++) {
+				_mm256_storeu_pd(&c[(h + r) * cs + q], acc[r][0]);
+				_mm256_storeu_pd(&c[(h + r) * cs + q + 4], acc[r][1]);
+			}
+		}
+	}
+}
+
+/**
+ * @brief AVX-512 product kernel (whole tile in registers).
+ */
+__attribute__((target("avx512f")))
+static void kk_verify_kernel_avx512(int kb, const double *restrict ap, const double *restrict bp, double *restrict c, int cs) {
+	int k, r;
+	__m512d acc[KK_VERIFY_TILE_ROWS][2], b0, b1, x;
+
+	for(r = 0; r < KK_VERIFY_TILE_ROWS; r++) {
+		acc[r][0] = _mm512_loadu_pd(&c[r * cs]);
+		acc[r][1] = _mm512_loadu_pd(&c[r * cs + 8]);
+	}
+
+	for(k = 0; k < kb; k++) {
+		b0 = _mm512_load_pd(&bp[k * KK_VERIFY_TILE_COLS]);
+		b1 = _mm512_load_pd(&bp[k * KK_VERIFY_TILE_COLS + 8]);
+		for(r = 0; r < KK_VERIFY_TILE_ROWS; r++) {
+			x = _mm512_set1_pd(ap[k * KK_VERIFY_TILE_ROWS + r]);
+			acc[r][0] = _mm512_add_pd(acc[r][0], _mm512_mul_pd(x, b0));
+			acc[r][1] = _mm512_add_pd(acc[r][1], _mm512_mul_pd(x, b1));
+		}
+	}
+
+	for(r = 0; r < KK_VERIFY_TILE_ROWS; r++) {
+		_mm512_storeu_pd(&c[r * cs], acc[r][0]);
+		_mm512_storeu_pd(&c[r * cs + 8], acc[r][1]);
+	}
+}
+#endif
+
+/**
+ * @brief Pack a block of a matrix into interleaved strips, padded with zeros.
+ *
+ * Strip s holds rows (or columns, if transposed) s * w to s * w + w - 1 of the block, element k of each
+ * of them in a row: column-of-A strips for rows of the product, row-of-B strips for its columns.
+ *
+ * @param dst Packed block.
+ * @param m n-by-n row-major matrix.
+ * @param n Size of matrix.
+ * @param i0 First row of block.
+ * @param j0 First column of block.
+ * @param ib Rows of block.
+ * @param jb Columns of block.
+ * @param w Strip width.
+ * @param byrow Non-zero for strips of rows (A), zero for strips of columns (B).
+ */
+static void kk_verify_pack(double *restrict dst, const double *restrict m, int n, int i0, int j0, int ib, int jb, int w, int byrow) {
+	int s, k, l, strips, depth, width;
+	const double *src;
+
+	strips = byrow? ib : jb;
+	depth = byrow? jb : ib;
+	for(s = 0; s < strips; s += w) {
+		width = (strips - s < w)? strips - s : w;
+		for(k = 0; k < depth; k++) {
+			for(l = 0; l < width; l++) {
+				src = byrow? &m[(size_t) (i0 + s + l) * n + j0 + k] : &m[(size_t) (i0 + k) * n + j0 + s + l];
+				dst[l] = *src;
+			}
+			for(; l < w; l++)
+				dst[l] = 0;
+			dst += w;
+		}
+	}
+}
+
+/**
+ * @brief Pool task: error sum of KK_VERIFY_BLOCK_ROWS rows of the identity product.
+ *
+ * @param arg Shared state.
+ * @param index Task index (block of rows).
+ * @param worker Worker index.
+ */
+static void kk_verify_full_run(void *arg, int index, int worker) {
+	kk_verify_full_t *full = arg;
+	int n = full->n, i0, j0, k0, ib, jb, kb, ip, jp, i, j;
+	double *ap, *bp, *c, sum = 0;
+
+	ap = full->scratch + (size_t) worker * KK_VERIFY_WORKER_SIZE;
+	bp = ap + KK_VERIFY_BLOCK_ROWS * KK_VERIFY_BLOCK_DEPTH;
+	c = bp + KK_VERIFY_BLOCK_DEPTH * KK_VERIFY_BLOCK_COLS;
+
+	i0 = index * KK_VERIFY_BLOCK_ROWS;
+	ib = (n - i0 < KK_VERIFY_BLOCK_ROWS)? n - i0 : KK_VERIFY_BLOCK_ROWS;
+	ip = (ib + KK_VERIFY_TILE_ROWS - 1) / KK_VERIFY_TILE_ROWS * KK_VERIFY_TILE_ROWS;
+
+	for(j0 = 0; j0 < n; j0 += KK_VERIFY_BLOCK_COLS) {
+		jb = (n - j0 < KK_VERIFY_BLOCK_COLS)? n - j0 : KK_VERIFY_BLOCK_COLS;
+		jp = (jb + KK_VERIFY_TILE_COLS - 1) / KK_VERIFY_TILE_COLS * KK_VERIFY_TILE_COLS;
+
+		/* Product block, whole inner dimension */
+		for(i = 0; i < ip; i++)
+			memset(&c[i * KK_VERIFY_BLOCK_COLS], 0, jp * sizeof(double));
+		for(k0 = 0; k0 < n; k0 += KK_VERIFY_BLOCK_DEPTH) {
+			kb = (n - k0 < KK_VERIFY_BLOCK_DEPTH)? n - k0 : KK_VERIFY_BLOCK_DEPTH;
+			kk_verify_pack(ap, full->inv, n, i0, k0, ib, kb, KK_VERIFY_TILE_ROWS, 1);
+			kk_verify_pack(bp, full->a, n, k0, j0, kb, jb, KK_VERIFY_TILE_COLS, 0);
+
+			/* A strip of B (kb by KK_VERIFY_TILE_COLS) stays in L1 cache across all rows */
+			for(j = 0; j < jp; j += KK_VERIFY_TILE_COLS)
+				for(i = 0; i < ip; i += KK_VERIFY_TILE_ROWS)
+					full->kernel(kb, &ap[i * kb], &bp[j * kb], &c[i * KK_VERIFY_BLOCK_COLS + j], KK_VERIFY_BLOCK_COLS);
+		}
+
+		/* Error of complete block, which is then dropped */
+		for(i = 0; i < ib; i++)
+			for(j = 0; j < jb; j++)
+				sum += fabs(((i0 + i == j0 + j)? 1 : 0) - c[i * KK_VERIFY_BLOCK_COLS + j]);
+	}
+
+	full->sums[index] = sum;
+}
+
+int kk_verify_rounds(double bound) {
+	int rounds;
+
+	if(!(bound < 1))
+		return 1;
+	if(!(bound > 0))
+		return KK_VERIFY_MAX_ROUNDS;
+
+	rounds = (int) ceil(-log2(bound));
+
+	return (rounds < 1)? 1 : (rounds > KK_VERIFY_MAX_ROUNDS)? KK_VERIFY_MAX_ROUNDS : rounds;
+}
+
+int kk_verify(int n, const double *a, const double *inv, int rounds, uint64_t seed, double tol, kk_workspace_t *ws, double *err) {
+	size_t k, len = (size_t) n * rounds;
+	uint64_t bits = 0, state = seed;
+	double *s, *t, max;
+
+	if(rounds < 1 || rounds > KK_VERIFY_MAX_ROUNDS)
+		return -1;
+	if(kk_workspace_grow(ws, 2 * len * sizeof(double)))
+		return -1;
+	s = ws->mem;
+	t = s + len;
+
+	/* Random signs, 64 per draw */
+	for(k = 0; k < len; k++) {
+		if(!(k % 64))
+			bits = kk_verify_rand(&state);
+		s[k] = (bits & 1)? -1.0 : 1.0;
+		bits >>= 1;
+	}
+
+	/* inv * r, then a * (inv * r) compared with r on the fly */
+	kk_verify_multiply(n, inv, rounds, s, t);
+	max = kk_verify_residual(n, a, rounds, t, s);
+
+	if(err)
+		*err = max;
+
+	return (max <= tol)? 0 : 1;
+}
+
+size_t kk_verify_full_size(int n, int threads) {
+	size_t tasks = (n + KK_VERIFY_BLOCK_ROWS - 1) / KK_VERIFY_BLOCK_ROWS;
+
+	/* Sums are rounded up to a cache line, so that worker scratch stays aligned */
+	return (tasks + 7) / 8 * 8 * sizeof(double) + (size_t) threads * KK_VERIFY_WORKER_SIZE * sizeof(double);
+}
+
+int kk_verify_full(kk_pool_t *pool, int n, const double *inv, const double *a, kk_workspace_t *ws, double *err) {
+	int t, tasks = (n + KK_VERIFY_BLOCK_ROWS - 1) / KK_VERIFY_BLOCK_ROWS, threads = pool? kk_pool_threads(pool) : 1;
+	double sum = 0;
+	kk_verify_full_t full;
+
+	if(kk_workspace_grow(ws, kk_verify_full_size(n, threads)))
+		return -1;
+
+	full.n = n;
+	full.kernel = kk_verify_kernel_scalar;
+#ifdef KK_VERIFY_X86
+	if(KK_SIMD_AVX512 == kk_simd_get())
+		full.kernel = kk_verify_kernel_avx512;
+	else if(KK_SIMD_AVX2 == kk_simd_get())
+		full.kernel = kk_verify_kernel_avx2;
+#endif
+	full.inv = inv;
+	full.a = a;
+	full.sums = ws->mem;
+	full.scratch = full.sums + (tasks + 7) / 8 * 8;
+
+	if(pool)
+		kk_pool_for(pool, tasks, kk_verify_full_run, &full);
+	else
+		for(t = 0; t < tasks; t++)
+			kk_verify_full_run(&full, t, 0);
+
+	for(t = 0; t < tasks; t++)
+		sum += full.sums[t];
+	*err = sum / ((double) n * n);
+
+	return 0;
+}
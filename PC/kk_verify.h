@@ -0,0 +1,122 @@
+/* ********************************************************************************************* */
+/* * KK-Algorithm for Strongly Non-Singular Matrices Inversion (Freivalds Verification)        * */
+/* * Authors: André Bannwart Perina, Luciano Falqueto                                          * */
+/* * Based on algorithm developed by Rajani M. Kant and Takayuki Kimura                        * */
+/* * Available at: http://dl.acm.org/citation.cfm?id=803034                                    * */
+/* ********************************************************************************************* */
+/* * Copyright (c) 2016 André B. Perina                                                        * */
+/* *                    Luciano Falqueto                                                       * */
+/* *                                                                                           * */
+/* * Permission is hereby granted, free of charge, to any person obtaining a copy of this      * */
+/* * software and associated documentation files (the "Software"), to deal in the Software     * */
+/* * without restriction, including without limitation the rights to use, copy, modify,        * */
+/* * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to        * */
+/* * permit persons to whom the Software is furnished to do so, subject to the following       * */
+/* * conditions:                                                                               * */
+/* *                                                                                           * */
+/* * The above copyright notice and this permission notice shall be included in all copies     * */
+/* * or substantial portions of the Software.                                                  * */
+/* *                                                                                           * */
+/* * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,       * */
+/* * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR  * */
+/* * PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE * */
+/* * FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      * */
+/* * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER    * */
+/* * DEALINGS IN THE SOFTWARE.                                                                 * */
+/* ********************************************************************************************* */
+
+#ifndef KK_VERIFY_H
+#define KK_VERIFY_H
+
+#include <stdint.h>
+
+#include "kk.h"
+#include "kk_pool.h"
+
+/**
+ * @brief Maximum number of random vectors of a verification.
+ */
+#define KK_VERIFY_MAX_ROUNDS 64
+
+/**
+ * @brief Rows of identity product given to a task (each task reduces its own rows).
+ */
+#define KK_VERIFY_BLOCK_ROWS 64
+
+/**
+ * @brief Columns of identity product accumulated at once (a packed KK_VERIFY_BLOCK_DEPTH-by-KK_VERIFY_BLOCK_COLS
+ * block of the matrix stays in L2 cache).
+ */
+#define KK_VERIFY_BLOCK_COLS 256
+
+/**
+ * @brief Inner dimension of identity product packed at once.
+ */
+#define KK_VERIFY_BLOCK_DEPTH 256
+
+/**
+ * @brief Return number of random vectors needed for a false-accept bound.
+ *
+ * @param bound Probability of accepting a wrong inverse (in (0, 1)).
+ *
+ * @return ceil(log2(1 / bound)), clamped to [1, KK_VERIFY_MAX_ROUNDS].
+ */
+int kk_verify_rounds(double bound);
+
+/**
+ * @brief Check that inv is the inverse of a (Freivalds' algorithm), in O(n^2).
+ *
+ * Instead of forming a * inv (O(n^3), as much as the inversion itself), every round draws a vector r
+ * of random signs and compares a * (inv * r) with r. All rounds share a single pass over inv and one
+ * over a. If any element of a * inv - I is off by more than 2 * tol, each round catches it with
+ * probability at least 1/2 (the two signs of the matching element of r move the residual by more than
+ * 2 * tol, so at most one of them keeps it within tol), so a wrong inverse is accepted with probability
+ * at most 2^-rounds (see kk_verify_rounds()).
+ *
+ * @param n Size of matrix.
+ * @param a n-by-n row-major matrix.
+ * @param inv n-by-n row-major inverse to check.
+ * @param rounds Number of random vectors (1 to KK_VERIFY_MAX_ROUNDS).
+ * @param seed Seed of random vectors.
+ * @param tol Largest accepted element of |a * inv * r - r|.
+ * @param ws Workspace (only used as scratch for 2 * n * rounds elements, so results of a previous
+ * kk_invert() on it are lost; pooled workspaces are grown).
+ * @param err Largest element of |a * inv * r - r| over all rounds (may be NULL).
+ *
+ * @return 0 if inv was accepted, 1 if it was rejected, -1 on invalid rounds or if workspace could not
+ * hold the vectors.
+ */
+int kk_verify(int n, const double *a, const double *inv, int rounds, uint64_t seed, double tol, kk_workspace_t *ws, double *err);
+
+/**
+ * @brief Return scratch memory needed by kk_verify_full().
+ *
+ * @param n Size of matrix.
+ * @param threads Number of workers.
+ *
+ * @return Size in bytes (per-task error sums, then packed blocks and accumulators of each worker).
+ */
+size_t kk_verify_full_size(int n, int threads);
+
+/**
+ * @brief Calculate error distance of an inverse from the full identity product, in O(n^3).
+ *
+ * Same as multiplying inv by a then taking the mean of |inv * a - I| (calculate_error() in main.c), but
+ * the product is never stored: tasks of KK_VERIFY_BLOCK_ROWS rows accumulate it KK_VERIFY_BLOCK_COLS
+ * columns at a time from packed blocks of both matrices, with a register-blocked kernel, and add up the
+ * error of each block as soon as it is complete. Each element of the product is summed in increasing
+ * inner index, so it is bit-identical to a plain row-by-column product; only the order of the error sum
+ * differs (per task, then tasks in order, whatever the number of workers).
+ *
+ * @param pool Pool that runs tasks (may be NULL to run them on the calling thread).
+ * @param n Size of matrix.
+ * @param inv n-by-n row-major inverse.
+ * @param a n-by-n row-major matrix.
+ * @param ws Workspace (only used as scratch, as in kk_verify(); pooled workspaces are grown).
+ * @param err Error distance (mean of |inv * a - I|, less is better).
+ *
+ * @return 0 on success, -1 if workspace could not hold the scratch memory.
+ */
+int kk_verify_full(kk_pool_t *pool, int n, const double *inv, const double *a, kk_workspace_t *ws, double *err);
+
+#endif
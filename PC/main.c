@@ -30,6 +30,13 @@
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include <unistd.h>
+
+#include "kk.h"
+#include "kk_file.h"
+#include "kk_format.h"
+#include "kk_perf.h"
+#include "kk_verify.h"
 
 /**
  * @brief Exact size of matrix.
@@ -41,20 +48,64 @@
  */
 #define ACTIVATE_TIMESTAMP
 
+/**
+ * @brief Uncomment this define to calculate only the determinant (no inverse nor identity check).
+ */
+//#define DETERMINANT_ONLY
+
+/**
+ * @brief Uncomment this define to check the inverse with random vectors (Freivalds' algorithm, O(N^2),
+ * see kk_verify()) instead of the full identity product (O(N^3)).
+ */
+//#define FREIVALDS_CHECK
+
+/**
+ * @brief Number of random vectors of Freivalds check (a wrong inverse passes with probability 2^-ROUNDS at most).
+ */
+#define FREIVALDS_ROUNDS 8
+
+/**
+ * @brief Seed of random vectors of Freivalds check (same vectors on every run).
+ */
+#define FREIVALDS_SEED 1
+
+/**
+ * @brief Largest accepted element of |A * A^-1 * r - r| in Freivalds check.
+ */
+#define FREIVALDS_TOL 1e-6
+
+/**
+ * @brief Uncomment this define to keep two scratch matrices instead of three (see kk_iterate_lean()).
+ */
+//#define LEAN_WORKSPACE
+
+/**
+ * @brief Uncomment this define to enable profiling via Linux hardware performance counters (see kk_perf.h).
+ */
+//#define ACTIVATE_PERFEVENT
+
+#ifdef ACTIVATE_PERFEVENT
+/**
+ * @brief Hardware counters, one section per phase.
+ */
+kk_perf_t perf;
+#endif
+
+/**
+ * @brief Buffered matrix output on stdout (see kk_format.h).
+ */
+kk_format_t out;
+
 /**
  * @brief Print a matrix.
  *
  * @param matrix N-by-N matrix.
  */
 void print_matrix(double matrix[N][N]) {
-	int i, j;
-	for(i = 0; i < N ; i++) {
-		for(j = 0; j < N; j++) {
-			printf("\t %.2lf", matrix[i][j]);
-		}
-		printf("\n");
-	}
-	printf("\n");
+	/* Messages printed so far go first */
+	fflush(stdout);
+	kk_format_matrix(&out, N, &matrix[0][0]);
+	kk_format_flush(&out);
 }
 
 /**
@@ -207,24 +258,85 @@ void the_algorithm(void) {
 							};
 #endif
 
-	/* Matrix scratchpad */
-	double matrix_K[3][N][N];
+	/* KK workspace (pooled scratchpad) */
+	kk_workspace_t ws;
+#ifdef DETERMINANT_ONLY
+	/* Determinant and division by zero flag */
+	kk_result_t res;
+#else
+	/* Intermediate matrix */
+	double matrix_D[N][N];
+	/* Inverted matrix */
+	double matrix_I[N][N];
+#ifdef FREIVALDS_CHECK
+	/* Result of Freivalds check (0 accepted, 1 rejected, -1 error) */
+	int verdict;
+#else
 	/* Calculated identity matrix based on calculated inverted matrix */
 	double matrix_IC[N][N];
+#endif
 	/* Error distance from true identity */
 	double error;
 	/* Auxiliary variables */
-	int i, j, k, next = 0, prev = 1, curr = 2;
+	int i, j;
+#endif
+
+	/* Allocate scratchpad once, outside timed sections (determinant only needs two buffers) */
+	kk_workspace_init(&ws, NULL, 0);
+#if defined(DETERMINANT_ONLY) || defined(LEAN_WORKSPACE)
+	if(kk_workspace_reserve_lean(&ws, N)) {
+#else
+	if(kk_workspace_reserve(&ws, N)) {
+#endif
+		printf("Could not allocate KK workspace\n");
+		return;
+	}
+
+#ifdef DETERMINANT_ONLY
+#ifdef ACTIVATE_TIMESTAMP
+	/* Timestamp before: KK Iterations */
+	then[1] = clock();
+#endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Start hardware counters: KK Iterations */
+	kk_perf_begin(&perf, 1);
+#endif
+
+	/* KK iterations, stopping at determinant (two buffers, no final iteration) */
+	kk_determinant(N, &matrix_O[0][0], &ws, &res);
+
+#ifdef ACTIVATE_TIMESTAMP
+	/* Timestamp after: KK Iterations */
+	now[1] = clock();
+#endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Stop hardware counters: KK Iterations */
+	kk_perf_end(&perf, 1);
+#endif
+
+	/* Print determinant */
+	printf("################################################\n");
+	printf("Determinant: %.2lf\n", res.det);
+	printf("Division by zero? %d\n", res.divZero);
+
+#ifdef ACTIVATE_TIMESTAMP
+	/* Print timestamp report */
+	printf("################################################\n");
+	printf("Timestamp 1: Iterations: %lu ticks\n", now[1] - then[1]);
+#endif
+#else
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp before: Transfer matrix */
 	then[0] = clock();
 #endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Start hardware counters: Transfer matrix */
+	kk_perf_begin(&perf, 0);
+#endif
 
 	/* Transfer matrix */
-	for(i = 0; i < N; i++)
-		for(j = 0; j < N; j++)
-			matrix_K[curr][i][j] = matrix_O[i][j];
+	kk_transfer(&ws, N, &matrix_O[0][0]);
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp after: Transfer matrix */
@@ -233,87 +345,132 @@ void the_algorithm(void) {
 	/* Timestamp before: KK Iterations */
 	then[1] = clock();
 #endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Stop hardware counters: Transfer matrix */
+	kk_perf_end(&perf, 0);
 
-	/* KK iterations */
-	for(k = 0; k < N-1; k++) {
-		for(i = 0; i < N; i++) {
-			for(j = 0; j < N; j++) {
-				matrix_K[next][i % N][j % N] =
-						(matrix_K[curr][i % N][j % N] * matrix_K[curr][(i + 1) % N][(j + 1) % N] - (matrix_K[curr][(i + 1) % N][j % N] * matrix_K[curr][i % N][(j + 1) % N])) /
-						(k? (matrix_K[prev][(i + 1) % N][(j + 1) % N]) : 1.0);
-			}
-		}
+	/* Start hardware counters: KK Iterations */
+	kk_perf_begin(&perf, 1);
+#endif
 
-		/* Refresh indexes */
-		next = (next + 1) % 3;
-		prev = (prev + 1) % 3;
-		curr = (curr + 1) % 3;
-	}
+	/* KK iterations */
+	kk_iterate(&ws);
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp after: KK Iterations */
 	now[1] = clock();
 #endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Stop hardware counters: KK Iterations */
+	kk_perf_end(&perf, 1);
+#endif
+
+	/* Get intermediate matrix */
+	for(i = 0; i < N; i++)
+		for(j = 0; j < N; j++)
+			matrix_D[i][j] = kk_getdetelem(&ws, i, j);
 
 	/* Print intermediate matrix */
 	printf("################################################\n");
-	printf("Matrix K+1: K = %d\n", (k+1));
-	print_matrix(matrix_K[curr]);
+	printf("Matrix K+1: K = %d\n", N);
+	print_matrix(matrix_D);
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp before: Final iteration */
 	then[2] = clock();
 #endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Start hardware counters: Final iteration */
+	kk_perf_begin(&perf, 2);
+#endif
 
 	/* Final iteration: Calculate inverse */
-	for(i = 0; i < N; i++)
-		for(j = 0; j < N; j++)
-				matrix_K[next][i][j] = (matrix_K[prev][(j + 1) % N][(i + 1) % N] / matrix_K[curr][i][j]);
+	kk_final(&ws, &matrix_I[0][0]);
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp after: Final iteration */
 	now[2] = clock();
 #endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Stop hardware counters: Final iteration */
+	kk_perf_end(&perf, 2);
+#endif
 
 	/* Print inverted matrix */
 	printf("################################################\n");
 	printf("Inverted matrix:\n");
-	print_matrix(matrix_K[next]);
+	print_matrix(matrix_I);
+	printf("Determinant: %.2lf\n", kk_getdetelem(&ws, 0, 0));
+	printf("Division by zero? %d\n", ws.divZero);
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp before: Calculate identity */
 	then[3] = clock();
 #endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Start hardware counters: Calculate identity */
+	kk_perf_begin(&perf, 3);
+#endif
 
+#ifdef FREIVALDS_CHECK
+	/* Calculate identity (only applied to random vectors) and error (largest residual) at once */
+	verdict = kk_verify(N, &matrix_O[0][0], &matrix_I[0][0], FREIVALDS_ROUNDS, FREIVALDS_SEED, FREIVALDS_TOL, &ws, &error);
+#else
 	/* Calculate identity */
-	multiply_matrix(matrix_K[next], matrix_O, matrix_IC);
+	multiply_matrix(matrix_I, matrix_O, matrix_IC);
+#endif
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp after: Calculate identity */
 	now[3] = clock();
 #endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Stop hardware counters: Calculate identity */
+	kk_perf_end(&perf, 3);
+#endif
 
+#ifndef FREIVALDS_CHECK
 	/* Print calculated identity matrix */
 	printf("################################################\n");
 	printf("Calculated identity based on calculated inverted matrix:\n");
 	print_matrix(matrix_IC);
+#endif
 	printf("################################################\n");
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp before: Calculate error */
 	then[4] = clock();
 #endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Start hardware counters: Calculate error */
+	kk_perf_begin(&perf, 4);
+#endif
 
+#ifndef FREIVALDS_CHECK
 	/* Calculate error */
 	error = calculate_error(matrix_IC);
+#endif
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Timestamp after: Calculate error */
 	now[4] = clock();
 #endif
+#ifdef ACTIVATE_PERFEVENT
+	/* Stop hardware counters: Calculate error */
+	kk_perf_end(&perf, 4);
+#endif
 
+#ifdef FREIVALDS_CHECK
+	/* Print verdict and error */
+	if(verdict < 0)
+		printf("Freivalds check could not run\n");
+	else
+		printf("Freivalds check (%d vectors): %s\n", FREIVALDS_ROUNDS, verdict? "rejected" : "accepted");
+	printf("Error distance (largest |A * A^-1 * r - r|): %.8lf\n", error);
+#else
 	/* Print error */
 	printf("Error distance: %.8lf\n", error);
+#endif
 
 #ifdef ACTIVATE_TIMESTAMP
 	/* Print timestamp report */
@@ -324,14 +481,148 @@ void the_algorithm(void) {
 	printf("Timestamp 3: Calculated identity: %lu ticks\n", now[3] - then[3]);
 	printf("Timestamp 4: Error distance: %lu ticks\n", now[4] - then[4]);
 #endif
+#endif
+
+	kk_workspace_free(&ws);
+}
+
+/**
+ * @brief Invert every matrix of a matrix file (see kk_file.h) and print inverses, as shortest round-trip text.
+ *
+ * @param in Input file (KK_FILE_F64, row-major).
+ *
+ * @return 0 on success, 1 on failure.
+ */
+int print_file(const char *in) {
+	/* Mapped file */
+	kk_file_t fin;
+	/* KK workspace (pooled scratchpad) */
+	kk_workspace_t ws;
+	/* Buffered output, one inverse at a time */
+	kk_format_t fout;
+	double *inv;
+	/* Auxiliary variables */
+	int ret = 0;
+	uint64_t r;
+
+	if(kk_file_map(&fin, in, 0)) {
+		printf("Could not map %s as a matrix file\n", in);
+		return 1;
+	}
+	if((KK_FILE_F64 != fin.hdr->type) || (KK_FILE_ROWMAJOR != fin.hdr->layout)) {
+		printf("Could not print %s (only row-major double matrices are supported)\n", in);
+		kk_file_unmap(&fin);
+		return 1;
+	}
+
+	inv = malloc((size_t) fin.hdr->n * fin.hdr->n * sizeof(double));
+	if(!inv || kk_format_init(&fout, STDOUT_FILENO, KK_FORMAT_TEXT, KK_FORMAT_SHORTEST, 0)) {
+		printf("Could not allocate output buffers\n");
+		free(inv);
+		kk_file_unmap(&fin);
+		return 1;
+	}
+
+	kk_workspace_init(&ws, NULL, 0);
+	for(r = 0; !ret && (r < fin.hdr->count); r++) {
+		if(kk_invert(fin.hdr->n, kk_file_record(&fin, r), inv, &ws, NULL)) {
+			/* Inverses printed so far go out before the message */
+			kk_format_flush(&fout);
+			printf("Could not allocate KK workspace for %ux%u matrices\n", fin.hdr->n, fin.hdr->n);
+			ret = 1;
+			break;
+		}
+		ret = kk_format_matrix(&fout, fin.hdr->n, inv)? 1 : 0;
+	}
+	ret |= kk_format_free(&fout)? 1 : 0;
+	kk_workspace_free(&ws);
+
+	free(inv);
+	kk_file_unmap(&fin);
+
+	return ret;
+}
+
+/**
+ * @brief Invert every matrix of a matrix file (see kk_file.h) into a new file, mapping to mapping.
+ *
+ * @param in Input file (KK_FILE_F64).
+ * @param out Output file (replaced if it exists, may be in for an in-place inversion).
+ *
+ * @return 0 on success, 1 on failure.
+ */
+int invert_file(const char *in, const char *out) {
+	/* Mapped files */
+	kk_file_t fin, fout;
+	/* KK workspace (pooled scratchpad) */
+	kk_workspace_t ws;
+	/* Auxiliary variables */
+	int ret, inplace = !strcmp(in, out);
+
+	if(kk_file_map(&fin, in, inplace)) {
+		printf("Could not map %s as a matrix file\n", in);
+		return 1;
+	}
+	if(!inplace && kk_file_create(&fout, out, fin.hdr)) {
+		printf("Could not create %s\n", out);
+		kk_file_unmap(&fin);
+		return 1;
+	}
+
+	kk_workspace_init(&ws, NULL, 0);
+	ret = kk_file_invert(&fin, inplace? &fin : &fout, &ws, NULL);
+	if(ret)
+		printf("Could not invert %s (only double matrices are supported)\n", in);
+	else
+		printf("Inverted %lu %ux%u matrices\n", (unsigned long) fin.hdr->count, fin.hdr->n, fin.hdr->n);
+	kk_workspace_free(&ws);
+
+	if(!inplace)
+		kk_file_unmap(&fout);
+	kk_file_unmap(&fin);
+
+	return ret? 1 : 0;
 }
 
 /**
  * @brief Main function.
+ *
+ * @param argc Number of arguments.
+ * @param argv Input and output matrix files, or input file and - to print its inverses (built-in
+ *             Vandermonde matrix if none given).
+ *
+ * @return 0 on success, 1 on failure.
  */
-int main(void) {
+int main(int argc, char *argv[]) {
+	if(3 == argc)
+		return strcmp(argv[2], "-")? invert_file(argv[1], argv[2]) : print_file(argv[1]);
+
+	if(kk_format_init(&out, STDOUT_FILENO, KK_FORMAT_TEXT, 2, 0)) {
+		printf("Could not allocate output buffer\n");
+		return 1;
+	}
+
+#ifdef ACTIVATE_PERFEVENT
+	/* Open and start hardware counters */
+	if(!kk_perf_open(&perf))
+		printf("Hardware performance counters unavailable (see /proc/sys/kernel/perf_event_paranoid)\n");
+#endif
+
 	/* Execute algorithm */
 	the_algorithm();
+	kk_format_free(&out);
+
+#ifdef ACTIVATE_PERFEVENT
+	/* Print hardware counters report */
+	printf("################################################\n");
+	kk_perf_report(&perf, 5, (const char *const []) {
+							"Transfer matrix",
+							"Iterations",
+							"Last iteration",
+							"Calculated identity",
+							"Error distance"});
+	kk_perf_close(&perf);
+#endif
 
 	return 0;
 }